@@ -51,7 +51,8 @@ if [ ! -d test_vectors ]; then
   cd ..
 fi
 
-gcc -Wall -Iblst/bindings src/eip2537.c src/test.c blst/libblst.a -o test_eip2537
+gcc -Wall -pthread -Iblst/bindings src/eip2537.c src/test.c blst/libblst.a -o test_eip2537
+gcc -O2 -Wall -pthread -Iblst/bindings src/eip2537.c src/bench.c blst/libblst.a -o bench_eip2537
 
 ./test_eip2537
 
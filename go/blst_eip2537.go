@@ -6,206 +6,885 @@ package blst_eip2537
 
 // #cgo CFLAGS: -I${SRCDIR}/../src -I${SRCDIR}/../blst/bindings -I${SRCDIR}/../blst/build -I${SRCDIR}/../blst/src -D__BLST_CGO__
 // #cgo amd64 CFLAGS: -D__ADX__ -mno-avx
+// #include <stdlib.h>
 // #include "eip2537.h"
+//
+// // eip2537_run with the gas used returned by value, a Go pointer passed
+// // for it would escape to the heap on every call
+// typedef struct {
+//   EIP2537_ERROR err;
+//   uint64_t      gas_used;
+// } eip2537_run_ret;
+//
+// static eip2537_run_ret eip2537_run_value(uint64_t address, const byte* in,
+//                                          size_t in_len, byte* out,
+//                                          size_t out_len, uint64_t gas_limit) {
+//   eip2537_run_ret ret;
+//   ret.err = eip2537_run(address, in, in_len, out, out_len, gas_limit,
+//                         &(ret.gas_used));
+//   return ret;
+// }
 import "C"
 import (
 	"errors"
+	"unsafe"
 )
 
 type Bls12Func func([]byte) ([]byte, error)
 
-func decodeEip2537Error(err C.EIP2537_ERROR) string {
-	var err_str string
+// Preallocated errors so failing calls do not allocate
+var (
+	ErrPointNotOnCurve    = errors.New("point not on curve")
+	ErrPointNotInSubgroup = errors.New("point not in subgroup")
+	ErrInvalidElement     = errors.New("invalid element")
+	ErrEncoding           = errors.New("encoding error")
+	ErrInvalidLength      = errors.New("invalid length")
+	ErrEmptyInput         = errors.New("empty input")
+	ErrMemory             = errors.New("memory allocation error")
+	ErrOutOfGas           = errors.New("out of gas")
+	ErrUnknownAddress     = errors.New("unknown address")
+	ErrFixedBaseLimit     = errors.New("fixed base limit reached")
+	ErrInvalidSelection   = errors.New("invalid selection table")
+	ErrUnknown            = errors.New("unknown error condition")
+)
 
+func eip2537Error(err C.EIP2537_ERROR) error {
 	switch err {
 	case C.EIP2537_SUCCESS:
-		err_str = "Success"
+		return nil
 	case C.EIP2537_POINT_NOT_ON_CURVE:
-		err_str = "point not on curve"
+		return ErrPointNotOnCurve
 	case C.EIP2537_POINT_NOT_IN_SUBGROUP:
-		err_str = "point not in subgroup"
+		return ErrPointNotInSubgroup
 	case C.EIP2537_INVALID_ELEMENT:
-		err_str = "invalid element"
+		return ErrInvalidElement
 	case C.EIP2537_ENCODING_ERROR:
-		err_str = "encoding error"
+		return ErrEncoding
 	case C.EIP2537_INVALID_LENGTH:
-		err_str = "invalid length"
+		return ErrInvalidLength
 	case C.EIP2537_EMPTY_INPUT:
-		err_str = "empty input"
+		return ErrEmptyInput
 	case C.EIP2537_MEMORY_ERROR:
-		err_str = "memory allocation error"
+		return ErrMemory
+	case C.EIP2537_OUT_OF_GAS:
+		return ErrOutOfGas
+	case C.EIP2537_UNKNOWN_ADDRESS:
+		return ErrUnknownAddress
+	case C.EIP2537_FIXED_BASE_LIMIT:
+		return ErrFixedBaseLimit
+	case C.EIP2537_INVALID_SELECTION:
+		return ErrInvalidSelection
 	default:
-		err_str = "unknown error condition"
+		return ErrUnknown
 	}
+}
 
-	return err_str
+// Number of threads for parallel paths, 0 uses all online cores
+func SetNumThreads(numThreads int) {
+	C.bls12_set_num_threads(C.size_t(numThreads))
 }
 
-func G1Add(input []byte) ([]byte, error) {
+// Minimum number of pairs before pairing is split across threads
+func SetPairingParallelThreshold(minPairs int) {
+	C.bls12_pairing_set_parallel_threshold(C.size_t(minPairs))
+}
+
+// Minimum number of pairs before multiexp is split across threads
+func SetMultiexpParallelThreshold(minPairs int) {
+	C.bls12_multiexp_set_parallel_threshold(C.size_t(minPairs))
+}
+
+// Scalar length aware G1Mul/G2Mul, on by default as inputs are public
+func SetMulVartime(enable bool) {
+	var e C.int
+	if enable {
+		e = 1
+	}
+	C.bls12_mul_set_vartime(e)
+}
+
+// Multiexp engines and selection table entries, see eip2537.h
+const (
+	MsmNaive     = C.BLS12_MSM_NAIVE
+	MsmBosCoster = C.BLS12_MSM_BC
+	MsmStraus    = C.BLS12_MSM_STRAUS
+	MsmPippenger = C.BLS12_MSM_PIPPENGER
+)
+
+type MsmSelection struct {
+	MaxPairs uint64
+	Engine   int
+}
+
+// Time every multiexp engine on this host and install the fastest
+func MultiexpCalibrate(maxPairs int) error {
+	err := C.bls12_multiexp_calibrate(C.size_t(maxPairs))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+	return nil
+}
+
+func toCSelection(table []MsmSelection) ([]C.bls12_msm_selection,
+	*C.bls12_msm_selection) {
+	ctable := make([]C.bls12_msm_selection, len(table))
+	for i, e := range table {
+		ctable[i].max_pairs = C.size_t(e.MaxPairs)
+		ctable[i].engine = C.bls12_msm_engine(e.Engine)
+	}
+	if len(ctable) == 0 {
+		return ctable, nil
+	}
+	return ctable, &ctable[0]
+}
+
+func fromCSelection(ctable []C.bls12_msm_selection, n int) []MsmSelection {
+	table := make([]MsmSelection, n)
+	for i := range table {
+		table[i].MaxPairs = uint64(ctable[i].max_pairs)
+		table[i].Engine = int(ctable[i].engine)
+	}
+	return table
+}
+
+// Multiexp engine selection tables, an empty table restores the default
+func G1MultiexpSetSelection(table []MsmSelection) error {
+	ctable, ptr := toCSelection(table)
+	err := C.bls12_g1multiexp_set_selection(ptr, C.size_t(len(ctable)))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+	return nil
+}
+
+func G2MultiexpSetSelection(table []MsmSelection) error {
+	ctable, ptr := toCSelection(table)
+	err := C.bls12_g2multiexp_set_selection(ptr, C.size_t(len(ctable)))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+	return nil
+}
+
+func G1MultiexpGetSelection() []MsmSelection {
+	ctable := make([]C.bls12_msm_selection, 16)
+	n := C.bls12_g1multiexp_get_selection(&ctable[0], C.size_t(len(ctable)))
+	return fromCSelection(ctable, int(n))
+}
+
+func G2MultiexpGetSelection() []MsmSelection {
+	ctable := make([]C.bls12_msm_selection, 16)
+	n := C.bls12_g2multiexp_get_selection(&ctable[0], C.size_t(len(ctable)))
+	return fromCSelection(ctable, int(n))
+}
+
+// Reuse a per thread multiexp scratch buffer of up to maxBytes, 0 is off
+func SetScratchArena(maxBytes int) {
+	C.bls12_scratch_arena_configure(C.size_t(maxBytes))
+}
+
+// Pairs dropped or merged away before the Miller loop, over all calls
+func PairingEliminatedPairs() uint64 {
+	return uint64(C.bls12_pairing_eliminated_pairs())
+}
+
+type PointCacheStats struct {
+	G1Hits   uint64
+	G1Misses uint64
+	G2Hits   uint64
+	G2Misses uint64
+}
+
+// Size the validated point caches, 0 entries disables a group
+func PointCacheConfigure(g1Entries, g2Entries int) error {
+	err := C.bls12_point_cache_configure(C.size_t(g1Entries),
+		C.size_t(g2Entries))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+
+	return nil
+}
+
+func GetPointCacheStats() PointCacheStats {
+	var stats C.bls12_point_cache_stats
+	C.bls12_point_cache_get_stats(&stats)
+
+	return PointCacheStats{
+		G1Hits:   uint64(stats.g1_hits),
+		G1Misses: uint64(stats.g1_misses),
+		G2Hits:   uint64(stats.g2_hits),
+		G2Misses: uint64(stats.g2_misses),
+	}
+}
+
+// Size the pairing G2 line cache, 0 entries disables it
+func PairingLineCacheConfigure(numEntries int) error {
+	err := C.bls12_pairing_line_cache_configure(C.size_t(numEntries))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+
+	return nil
+}
+
+func GetPairingLineCacheStats() (hits, misses uint64) {
+	var cHits, cMisses C.uint64_t
+	C.bls12_pairing_line_cache_get_stats(&cHits, &cMisses)
+
+	return uint64(cHits), uint64(cMisses)
+}
+
+// Build the generator tables for G1Mul/G2Mul now, not on first use
+func FixedBaseInit() {
+	C.bls12_fixed_base_init()
+}
+
+// Register a well-known G1 base for fixed base multiplication
+func G1AddFixedBase(base []byte) error {
+	if len(base) != 128 {
+		return ErrInvalidLength
+	}
+
+	err := C.bls12_g1_add_fixed_base((*C.byte)(&base[0]))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+
+	return nil
+}
+
+// Register a well-known G2 base for fixed base multiplication
+func G2AddFixedBase(base []byte) error {
+	if len(base) != 256 {
+		return ErrInvalidLength
+	}
+
+	err := C.bls12_g2_add_fixed_base((*C.byte)(&base[0]))
+	if err != C.EIP2537_SUCCESS {
+		return eip2537Error(err)
+	}
+
+	return nil
+}
+
+type bls12BatchOp func(out *C.byte, errs *C.EIP2537_ERROR, in **C.byte,
+	inLen *C.size_t, n C.size_t)
+
+// Independent calls run as one batch sharing the inversion to affine, inputs
+// are copied to C memory as cgo does not allow passing pointers to them
+func batch(inputs [][]byte, outLen int, op bls12BatchOp) ([][]byte, []error) {
+	n := len(inputs)
+	outputs := make([][]byte, n)
+	errs := make([]error, n)
+	if n == 0 {
+		return outputs, errs
+	}
+
+	total := 1
+	for _, input := range inputs {
+		total += len(input)
+	}
+	data := C.malloc(C.size_t(total))
+	ptrs := C.malloc(C.size_t(n) * C.size_t(unsafe.Sizeof((*C.byte)(nil))))
+	defer C.free(data)
+	defer C.free(ptrs)
+
+	dataSlice := unsafe.Slice((*byte)(data), total)
+	ptrSlice := unsafe.Slice((**C.byte)(ptrs), n)
+	lens := make([]C.size_t, n)
+	offset := 0
+	for i, input := range inputs {
+		copy(dataSlice[offset:], input)
+		ptrSlice[i] = (*C.byte)(unsafe.Pointer(&dataSlice[offset]))
+		lens[i] = C.size_t(len(input))
+		offset += len(input)
+	}
+
+	output := make([]byte, n*outLen)
+	cerrs := make([]C.EIP2537_ERROR, n)
+	op((*C.byte)(&output[0]), &cerrs[0], &ptrSlice[0], &lens[0], C.size_t(n))
+
+	for i := range inputs {
+		if cerrs[i] != C.EIP2537_SUCCESS {
+			errs[i] = eip2537Error(cerrs[i])
+			continue
+		}
+		outputs[i] = output[i*outLen : (i+1)*outLen]
+	}
+	return outputs, errs
+}
+
+func G1AddBatch(inputs [][]byte) ([][]byte, []error) {
+	return batch(inputs, 128, func(out *C.byte, errs *C.EIP2537_ERROR,
+		in **C.byte, inLen *C.size_t, n C.size_t) {
+		C.bls12_g1add_batch(out, errs, in, inLen, n)
+	})
+}
+
+func G1MulBatch(inputs [][]byte) ([][]byte, []error) {
+	return batch(inputs, 128, func(out *C.byte, errs *C.EIP2537_ERROR,
+		in **C.byte, inLen *C.size_t, n C.size_t) {
+		C.bls12_g1mul_batch(out, errs, in, inLen, n)
+	})
+}
+
+func G2AddBatch(inputs [][]byte) ([][]byte, []error) {
+	return batch(inputs, 256, func(out *C.byte, errs *C.EIP2537_ERROR,
+		in **C.byte, inLen *C.size_t, n C.size_t) {
+		C.bls12_g2add_batch(out, errs, in, inLen, n)
+	})
+}
+
+func G2MulBatch(inputs [][]byte) ([][]byte, []error) {
+	return batch(inputs, 256, func(out *C.byte, errs *C.EIP2537_ERROR,
+		in **C.byte, inLen *C.size_t, n C.size_t) {
+		C.bls12_g2mul_batch(out, errs, in, inLen, n)
+	})
+}
+
+// Output lengths of the precompiles from address 0x0a
+var precompileOutLen = [...]int{128, 128, 128, 256, 256, 256, 32, 128, 256}
+
+// Run writing into dst, which must hold the output of the precompile at
+// address (128, 256 or 32 bytes). Returns the output length and gas used
+func RunInto(address uint64, dst, input []byte, gasLimit uint64) (int,
+	uint64, error) {
+	var in, out *C.byte
+	if len(input) != 0 {
+		in = (*C.byte)(&input[0])
+	}
+	if len(dst) != 0 {
+		out = (*C.byte)(&dst[0])
+	}
+	ret := C.eip2537_run_value(C.uint64_t(address), in, C.size_t(len(input)),
+		out, C.size_t(len(dst)), C.uint64_t(gasLimit))
+	if ret.err != C.EIP2537_SUCCESS {
+		return 0, uint64(ret.gas_used), eip2537Error(ret.err)
+	}
+	return precompileOutLen[address-0x0a], uint64(ret.gas_used), nil
+}
+
+// Precompile at address with length check, gas and execution in one cgo call
+func Run(address uint64, input []byte, gasLimit uint64) ([]byte, uint64,
+	error) {
+	output := make([]byte, 256)
+	n, gasUsed, err := RunInto(address, output, input, gasLimit)
+	if err != nil {
+		return nil, gasUsed, err
+	}
+	return output[:n], gasUsed, nil
+}
+
+// Calls collected into contiguous arenas and run with one cgo call. The
+// arenas are kept across Reset so steady state use does not allocate
+type Batch struct {
+	addresses  []C.uint64_t
+	gasLimits  []C.uint64_t
+	gasUsed    []C.uint64_t
+	errs       []C.EIP2537_ERROR
+	inOffsets  []C.size_t
+	outOffsets []C.size_t
+	input      []byte
+	output     []byte
+}
+
+func (b *Batch) Reset() {
+	b.addresses = b.addresses[:0]
+	b.gasLimits = b.gasLimits[:0]
+	b.inOffsets = b.inOffsets[:0]
+	b.outOffsets = b.outOffsets[:0]
+	b.input = b.input[:0]
+}
+
+// Add a call, returns its index for Result
+func (b *Batch) Add(address uint64, input []byte, gasLimit uint64) int {
+	if len(b.inOffsets) == 0 {
+		b.inOffsets = append(b.inOffsets, 0)
+		b.outOffsets = append(b.outOffsets, 0)
+	}
+	outLen := 0
+	if address >= 0x0a && address-0x0a < uint64(len(precompileOutLen)) {
+		outLen = precompileOutLen[address-0x0a]
+	}
+	b.addresses = append(b.addresses, C.uint64_t(address))
+	b.gasLimits = append(b.gasLimits, C.uint64_t(gasLimit))
+	b.input = append(b.input, input...)
+	b.inOffsets = append(b.inOffsets, C.size_t(len(b.input)))
+	b.outOffsets = append(b.outOffsets,
+		b.outOffsets[len(b.outOffsets)-1]+C.size_t(outLen))
+	return len(b.addresses) - 1
+}
+
+// Run all added calls in one cgo call
+func (b *Batch) Run() {
+	n := len(b.addresses)
+	if n == 0 {
+		return
+	}
+	if cap(b.gasUsed) < n {
+		b.gasUsed = make([]C.uint64_t, n)
+		b.errs = make([]C.EIP2537_ERROR, n)
+	}
+	b.gasUsed = b.gasUsed[:n]
+	b.errs = b.errs[:n]
+	outLen := int(b.outOffsets[n]) + 1
+	if cap(b.output) < outLen {
+		b.output = make([]byte, outLen)
+	}
+	b.output = b.output[:outLen]
+	if cap(b.input) == 0 {
+		b.input = make([]byte, 0, 1)
+	}
+	C.eip2537_run_batch(&b.addresses[0],
+		(*C.byte)(unsafe.Pointer(&b.input[:1][0])), &b.inOffsets[0],
+		(*C.byte)(&b.output[0]), &b.outOffsets[0], &b.gasLimits[0],
+		&b.gasUsed[0], &b.errs[0], C.size_t(n))
+}
+
+// Output, gas used and error of call i after Run, the output aliases the
+// batch arena until the next Run
+func (b *Batch) Result(i int) ([]byte, uint64, error) {
+	if err := eip2537Error(b.errs[i]); err != nil {
+		return nil, uint64(b.gasUsed[i]), err
+	}
+	return b.output[b.outOffsets[i]:b.outOffsets[i+1]], uint64(b.gasUsed[i]),
+		nil
+}
+
+type bls12GasOp func(out *C.byte, in *C.byte, inLen C.size_t,
+	gasLimit C.uint64_t, gasUsed *C.uint64_t) C.EIP2537_ERROR
+
+// Calls charged against gasLimit before any input is decoded, returns the
+// gas used alongside the result
+func withGas(input []byte, outLen int, gasLimit uint64,
+	op bls12GasOp) ([]byte, uint64, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, 0, ErrInvalidLength
 	}
-	output := make([]byte, 128)
-	err := C.bls12_g1add((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
+	output := make([]byte, outLen)
+	var gasUsed C.uint64_t
+	err := op((*C.byte)(&output[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input)), C.uint64_t(gasLimit), &gasUsed)
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, uint64(gasUsed), eip2537Error(err)
+	}
+	return output, uint64(gasUsed), nil
+}
+
+func G1AddWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 128, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_g1add_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func G1MulWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 128, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_g1mul_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func G1MultiexpWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 128, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_g1multiexp_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func G2AddWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 256, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_g2add_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func G2MulWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 256, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_g2mul_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func G2MultiexpWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 256, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_g2multiexp_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func PairingWithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 32, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_pairing_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func MapFpToG1WithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 128, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_map_fp_to_g1_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func MapFp2ToG2WithGas(input []byte, gasLimit uint64) ([]byte, uint64, error) {
+	return withGas(input, 256, gasLimit, func(out *C.byte, in *C.byte,
+		inLen C.size_t, gasLimit C.uint64_t,
+		gasUsed *C.uint64_t) C.EIP2537_ERROR {
+		return C.bls12_map_fp2_to_g2_with_gas(out, in, inLen, gasLimit, gasUsed)
+	})
+}
+
+func MapFpToG1Batch(inputs [][]byte) ([][]byte, []error) {
+	return batch(inputs, 128, func(out *C.byte, errs *C.EIP2537_ERROR,
+		in **C.byte, inLen *C.size_t, n C.size_t) {
+		C.bls12_map_fp_to_g1_batch(out, errs, in, inLen, n)
+	})
+}
+
+func MapFp2ToG2Batch(inputs [][]byte) ([][]byte, []error) {
+	return batch(inputs, 256, func(out *C.byte, errs *C.EIP2537_ERROR,
+		in **C.byte, inLen *C.size_t, n C.size_t) {
+		C.bls12_map_fp2_to_g2_batch(out, errs, in, inLen, n)
+	})
+}
+
+// G1Add writing into dst, which must hold at least 128 bytes
+func G1AddInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 128 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_g1add((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func G1Add(input []byte) ([]byte, error) {
+	output := make([]byte, 128)
+	if err := G1AddInto(output, input); err != nil {
+		return nil, err
 	}
 	return output, nil
 }
 
+// G1Mul writing into dst, which must hold at least 128 bytes
+func G1MulInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 128 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_g1mul((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
 func G1Mul(input []byte) ([]byte, error) {
+	output := make([]byte, 128)
+	if err := G1MulInto(output, input); err != nil {
+		return nil, err
+	}
+	return output, nil
+}
+
+// Same result as G1Mul, endomorphism accelerated for points in the subgroup
+func G1MulGlv(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
 	output := make([]byte, 128)
-	err := C.bls12_g1mul((*C.byte)(&output[0]), (*C.byte)(&input[0]),
+	err := C.bls12_g1mul_glv((*C.byte)(&output[0]), (*C.byte)(&input[0]),
 		C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func G1Multiexp(input []byte) ([]byte, error) {
-	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+// G1Multiexp writing into dst, which must hold at least 128 bytes
+func G1MultiexpInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 128 {
+		return ErrInvalidLength
 	}
+	return eip2537Error(C.bls12_g1multiexp((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func G1Multiexp(input []byte) ([]byte, error) {
 	output := make([]byte, 128)
-	err := C.bls12_g1multiexp((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
-	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+	if err := G1MultiexpInto(output, input); err != nil {
+		return nil, err
 	}
 	return output, nil
 }
 
 func G1MultiexpNaive(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
 	output := make([]byte, 128)
 	err := C.bls12_g1multiexp_naive((*C.byte)(&output[0]), (*C.byte)(&input[0]),
 		C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
 func G1MultiexpBosCoster(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
 	output := make([]byte, 128)
 	err := C.bls12_g1multiexp_bc((*C.byte)(&output[0]), (*C.byte)(&input[0]),
 		C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func G2Add(input []byte) ([]byte, error) {
+func G1MultiexpPippenger(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
-	output := make([]byte, 256)
-	err := C.bls12_g2add((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
+	output := make([]byte, 128)
+	err := C.bls12_g1multiexp_pippenger((*C.byte)(&output[0]),
+		(*C.byte)(&input[0]), C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func G2Mul(input []byte) ([]byte, error) {
+func G1MultiexpStraus(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
-	output := make([]byte, 256)
-	err := C.bls12_g2mul((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
+	output := make([]byte, 128)
+	err := C.bls12_g1multiexp_straus((*C.byte)(&output[0]),
+		(*C.byte)(&input[0]), C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func G2Multiexp(input []byte) ([]byte, error) {
+// Bytes of scratch G1MultiexpWithScratch needs for an input length
+func G1MultiexpScratchSize(inLen int) int {
+	return int(C.bls12_g1multiexp_scratch_size(C.size_t(inLen)))
+}
+
+func G1MultiexpWithScratch(input []byte, scratch []byte) ([]byte, error) {
+	if len(input) == 0 {
+		return nil, ErrInvalidLength
+	}
+	var scratchPtr *C.byte
+	if len(scratch) != 0 {
+		scratchPtr = (*C.byte)(&scratch[0])
+	}
+	output := make([]byte, 128)
+	err := C.bls12_g1multiexp_with_scratch((*C.byte)(&output[0]),
+		(*C.byte)(&input[0]), C.size_t(len(input)),
+		unsafe.Pointer(scratchPtr), C.size_t(len(scratch)))
+	if err != C.EIP2537_SUCCESS {
+		return nil, eip2537Error(err)
+	}
+	return output, nil
+}
+
+// G2Add writing into dst, which must hold at least 256 bytes
+func G2AddInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 256 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_g2add((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func G2Add(input []byte) ([]byte, error) {
+	output := make([]byte, 256)
+	if err := G2AddInto(output, input); err != nil {
+		return nil, err
+	}
+	return output, nil
+}
+
+// G2Mul writing into dst, which must hold at least 256 bytes
+func G2MulInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 256 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_g2mul((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func G2Mul(input []byte) ([]byte, error) {
+	output := make([]byte, 256)
+	if err := G2MulInto(output, input); err != nil {
+		return nil, err
+	}
+	return output, nil
+}
+
+// Same result as G2Mul, endomorphism accelerated for points in the subgroup
+func G2MulGls(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
 	output := make([]byte, 256)
-	err := C.bls12_g2multiexp((*C.byte)(&output[0]), (*C.byte)(&input[0]),
+	err := C.bls12_g2mul_gls((*C.byte)(&output[0]), (*C.byte)(&input[0]),
 		C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
+	}
+	return output, nil
+}
+
+// G2Multiexp writing into dst, which must hold at least 256 bytes
+func G2MultiexpInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 256 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_g2multiexp((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func G2Multiexp(input []byte) ([]byte, error) {
+	output := make([]byte, 256)
+	if err := G2MultiexpInto(output, input); err != nil {
+		return nil, err
 	}
 	return output, nil
 }
 
 func G2MultiexpNaive(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
 	output := make([]byte, 256)
 	err := C.bls12_g2multiexp_naive((*C.byte)(&output[0]), (*C.byte)(&input[0]),
 		C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
 func G2MultiexpBosCoster(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
 	output := make([]byte, 256)
 	err := C.bls12_g2multiexp_bc((*C.byte)(&output[0]), (*C.byte)(&input[0]),
 		C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func Pairing(input []byte) ([]byte, error) {
+func G2MultiexpPippenger(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
-	output := make([]byte, 32)
-	err := C.bls12_pairing((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
+	output := make([]byte, 256)
+	err := C.bls12_g2multiexp_pippenger((*C.byte)(&output[0]),
+		(*C.byte)(&input[0]), C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func MapFpToG1(input []byte) ([]byte, error) {
+func G2MultiexpStraus(input []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
 	}
-	output := make([]byte, 128)
-	err := C.bls12_map_fp_to_g1((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
+	output := make([]byte, 256)
+	err := C.bls12_g2multiexp_straus((*C.byte)(&output[0]),
+		(*C.byte)(&input[0]), C.size_t(len(input)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
 	}
 	return output, nil
 }
 
-func MapFp2ToG2(input []byte) ([]byte, error) {
+// Bytes of scratch G2MultiexpWithScratch needs for an input length
+func G2MultiexpScratchSize(inLen int) int {
+	return int(C.bls12_g2multiexp_scratch_size(C.size_t(inLen)))
+}
+
+func G2MultiexpWithScratch(input []byte, scratch []byte) ([]byte, error) {
 	if len(input) == 0 {
-		return nil, errors.New(decodeEip2537Error(C.EIP2537_INVALID_LENGTH))
+		return nil, ErrInvalidLength
+	}
+	var scratchPtr *C.byte
+	if len(scratch) != 0 {
+		scratchPtr = (*C.byte)(&scratch[0])
 	}
 	output := make([]byte, 256)
-	err := C.bls12_map_fp2_to_g2((*C.byte)(&output[0]), (*C.byte)(&input[0]),
-		C.size_t(len(input)))
+	err := C.bls12_g2multiexp_with_scratch((*C.byte)(&output[0]),
+		(*C.byte)(&input[0]), C.size_t(len(input)),
+		unsafe.Pointer(scratchPtr), C.size_t(len(scratch)))
 	if err != C.EIP2537_SUCCESS {
-		return nil, errors.New(decodeEip2537Error(err))
+		return nil, eip2537Error(err)
+	}
+	return output, nil
+}
+
+// Pairing writing into dst, which must hold at least 32 bytes
+func PairingInto(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 32 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_pairing((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func Pairing(input []byte) ([]byte, error) {
+	output := make([]byte, 32)
+	if err := PairingInto(output, input); err != nil {
+		return nil, err
+	}
+	return output, nil
+}
+
+// MapFpToG1 writing into dst, which must hold at least 128 bytes
+func MapFpToG1Into(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 128 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_map_fp_to_g1((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func MapFpToG1(input []byte) ([]byte, error) {
+	output := make([]byte, 128)
+	if err := MapFpToG1Into(output, input); err != nil {
+		return nil, err
+	}
+	return output, nil
+}
+
+// MapFp2ToG2 writing into dst, which must hold at least 256 bytes
+func MapFp2ToG2Into(dst, input []byte) error {
+	if len(input) == 0 || len(dst) < 256 {
+		return ErrInvalidLength
+	}
+	return eip2537Error(C.bls12_map_fp2_to_g2((*C.byte)(&dst[0]), (*C.byte)(&input[0]),
+		C.size_t(len(input))))
+}
+
+func MapFp2ToG2(input []byte) ([]byte, error) {
+	output := make([]byte, 256)
+	if err := MapFp2ToG2Into(output, input); err != nil {
+		return nil, err
 	}
 	return output, nil
 }
@@ -7,8 +7,10 @@ package blst_eip2537
 import (
 	"encoding/hex"
 	"encoding/json"
+	"errors"
 	"fmt"
 	"io/ioutil"
+	"math"
 	"testing"
 	"time"
 )
@@ -144,15 +146,102 @@ func benchJson(file_path string, test_function Bls12Func, bench *testing.B) {
 	}
 }
 
+type Bls12GasFunc func([]byte, uint64) ([]byte, uint64, error)
+
+// Each vector must run with exactly its listed gas and fail one short of it
+func testJsonGas(file_path string, test_function Bls12GasFunc,
+	t *testing.T) {
+
+	test_json, err := ioutil.ReadFile(file_path)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	var tests []precompiledTest
+	err = json.Unmarshal(test_json, &tests)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	for _, test := range tests {
+		t.Run(test.Name, func(t *testing.T) {
+			input, err := hex.DecodeString(test.Input)
+			if err != nil {
+				t.Fatal(err)
+			}
+
+			output, gas_used, test_err := test_function(input, test.Gas)
+			if test_err != nil {
+				t.Fatalf("Test received unexpected error %v", test_err)
+			}
+			if gas_used != test.Gas {
+				t.Errorf("Expected gas %v, got %v", test.Gas, gas_used)
+			}
+			if out_str := hex.EncodeToString(output); out_str != test.Expected {
+				t.Errorf("Expected %v, got %v", test.Expected, out_str)
+			}
+
+			_, gas_used, test_err = test_function(input, test.Gas-1)
+			if !errors.Is(test_err, ErrOutOfGas) {
+				t.Errorf("Expected out of gas, got %v", test_err)
+			}
+			if gas_used != test.Gas-1 {
+				t.Errorf("Expected gas %v, got %v", test.Gas-1, gas_used)
+			}
+		})
+	}
+}
+
 // Tests
+// Each input twice in one batch, both results must agree
+func batchTwice(f func([][]byte) ([][]byte, []error)) Bls12Func {
+	return func(input []byte) ([]byte, error) {
+		outputs, errs := f([][]byte{input, input})
+		if errs[0] != nil {
+			return nil, errs[0]
+		}
+		if hex.EncodeToString(outputs[0]) != hex.EncodeToString(outputs[1]) {
+			return nil, fmt.Errorf("batch outputs differ")
+		}
+		return outputs[0], nil
+	}
+}
+
+// Writes into one reused buffer, as block processing would
+func into(f func(dst, input []byte) error, outLen int) Bls12Func {
+	dst := make([]byte, outLen)
+	return func(input []byte) ([]byte, error) {
+		if err := f(dst, input); err != nil {
+			return nil, err
+		}
+		return dst, nil
+	}
+}
+
 func TestG1Add(t *testing.T) {
 	testJson("../test_vectors/blsG1Add.json", true, G1Add, t)
 }
 
+func TestG1AddInto(t *testing.T) {
+	testJson("../test_vectors/blsG1Add.json", true, into(G1AddInto, 128), t)
+}
+
+func TestG1AddBatch(t *testing.T) {
+	testJson("../test_vectors/blsG1Add.json", true, batchTwice(G1AddBatch), t)
+}
+
 func TestG1Mul(t *testing.T) {
 	testJson("../test_vectors/blsG1Mul.json", true, G1Mul, t)
 }
 
+func TestG1MulBatch(t *testing.T) {
+	testJson("../test_vectors/blsG1Mul.json", true, batchTwice(G1MulBatch), t)
+}
+
+func TestG1MulGlv(t *testing.T) {
+	testJson("../test_vectors/blsG1Mul.json", true, G1MulGlv, t)
+}
+
 func TestG1Multiexp(t *testing.T) {
 	testJson("../test_vectors/blsG1MultiExp.json", true, G1Multiexp, t)
 }
@@ -165,14 +254,64 @@ func TestG1MultiexpBosCoster(t *testing.T) {
 	testJson("../test_vectors/blsG1MultiExp.json", true, G1MultiexpBosCoster, t)
 }
 
+func TestG1MultiexpPippenger(t *testing.T) {
+	testJson("../test_vectors/blsG1MultiExp.json", true, G1MultiexpPippenger, t)
+}
+
+func TestMultiexpCalibrate(t *testing.T) {
+	if err := MultiexpCalibrate(16); err != nil {
+		t.Fatal(err)
+	}
+	defer G1MultiexpSetSelection(nil)
+	defer G2MultiexpSetSelection(nil)
+
+	if len(G1MultiexpGetSelection()) == 0 {
+		t.Fatal("empty G1 selection table")
+	}
+	testJson("../test_vectors/blsG1MultiExp.json", true, G1Multiexp, t)
+	testJson("../test_vectors/blsG2MultiExp.json", true, G2Multiexp, t)
+}
+
+func TestMultiexpSetSelectionInvalid(t *testing.T) {
+	unsorted := []MsmSelection{{64, MsmStraus}, {32, MsmPippenger}}
+	if err := G1MultiexpSetSelection(unsorted); !errors.Is(err,
+		ErrInvalidSelection) {
+		t.Fatalf("expected ErrInvalidSelection, got %v", err)
+	}
+}
+
+func TestG1MultiexpStraus(t *testing.T) {
+	testJson("../test_vectors/blsG1MultiExp.json", true, G1MultiexpStraus, t)
+}
+
+func TestG1MultiexpWithScratch(t *testing.T) {
+	testJson("../test_vectors/blsG1MultiExp.json", true,
+		func(input []byte) ([]byte, error) {
+			scratch := make([]byte, G1MultiexpScratchSize(len(input)))
+			return G1MultiexpWithScratch(input, scratch)
+		}, t)
+}
+
 func TestG2Add(t *testing.T) {
 	testJson("../test_vectors/blsG2Add.json", true, G2Add, t)
 }
 
+func TestG2AddBatch(t *testing.T) {
+	testJson("../test_vectors/blsG2Add.json", true, batchTwice(G2AddBatch), t)
+}
+
 func TestG2Mul(t *testing.T) {
 	testJson("../test_vectors/blsG2Mul.json", true, G2Mul, t)
 }
 
+func TestG2MulBatch(t *testing.T) {
+	testJson("../test_vectors/blsG2Mul.json", true, batchTwice(G2MulBatch), t)
+}
+
+func TestG2MulGls(t *testing.T) {
+	testJson("../test_vectors/blsG2Mul.json", true, G2MulGls, t)
+}
+
 func TestG2Multiexp(t *testing.T) {
 	testJson("../test_vectors/blsG2MultiExp.json", true, G2Multiexp, t)
 }
@@ -185,6 +324,22 @@ func TestG2MultiexpBosCoster(t *testing.T) {
 	testJson("../test_vectors/blsG2MultiExp.json", true, G2MultiexpBosCoster, t)
 }
 
+func TestG2MultiexpPippenger(t *testing.T) {
+	testJson("../test_vectors/blsG2MultiExp.json", true, G2MultiexpPippenger, t)
+}
+
+func TestG2MultiexpStraus(t *testing.T) {
+	testJson("../test_vectors/blsG2MultiExp.json", true, G2MultiexpStraus, t)
+}
+
+func TestG2MultiexpWithScratch(t *testing.T) {
+	testJson("../test_vectors/blsG2MultiExp.json", true,
+		func(input []byte) ([]byte, error) {
+			scratch := make([]byte, G2MultiexpScratchSize(len(input)))
+			return G2MultiexpWithScratch(input, scratch)
+		}, t)
+}
+
 func TestPairing(t *testing.T) {
 	testJson("../test_vectors/blsPairing.json", true, Pairing, t)
 }
@@ -193,10 +348,18 @@ func TestMapFpToG1(t *testing.T) {
 	testJson("../test_vectors/blsMapG1.json", true, MapFpToG1, t)
 }
 
+func TestMapFpToG1Batch(t *testing.T) {
+	testJson("../test_vectors/blsMapG1.json", true, batchTwice(MapFpToG1Batch), t)
+}
+
 func TestMapFp2ToG2(t *testing.T) {
 	testJson("../test_vectors/blsMapG2.json", true, MapFp2ToG2, t)
 }
 
+func TestMapFp2ToG2Batch(t *testing.T) {
+	testJson("../test_vectors/blsMapG2.json", true, batchTwice(MapFp2ToG2Batch), t)
+}
+
 func TestG1AddFail(t *testing.T) {
 	testJson("../test_vectors/fail-blsG1Add.json", false, G1Add, t)
 }
@@ -205,6 +368,10 @@ func TestG1MulFail(t *testing.T) {
 	testJson("../test_vectors/fail-blsG1Mul.json", false, G1Mul, t)
 }
 
+func TestG1MulGlvFail(t *testing.T) {
+	testJson("../test_vectors/fail-blsG1Mul.json", false, G1MulGlv, t)
+}
+
 func TestG1MultiexpFail(t *testing.T) {
 	testJson("../test_vectors/fail-blsG1MultiExp.json", false, G1Multiexp, t)
 }
@@ -217,6 +384,10 @@ func TestG2MulFail(t *testing.T) {
 	testJson("../test_vectors/fail-blsG2Mul.json", false, G2Mul, t)
 }
 
+func TestG2MulGlsFail(t *testing.T) {
+	testJson("../test_vectors/fail-blsG2Mul.json", false, G2MulGls, t)
+}
+
 func TestG2MultiexpFail(t *testing.T) {
 	testJson("../test_vectors/fail-blsG2MultiExp.json", false, G2Multiexp, t)
 }
@@ -238,14 +409,26 @@ func BenchmarkG1Add(b *testing.B) {
 	benchJson("../test_vectors/blsG1Add.json", G1Add, b)
 }
 
+func BenchmarkG1AddInto(b *testing.B) {
+	benchJson("../test_vectors/blsG1Add.json", into(G1AddInto, 128), b)
+}
+
 func BenchmarkG1Mul(b *testing.B) {
 	benchJson("../test_vectors/blsG1Mul.json", G1Mul, b)
 }
 
+func BenchmarkG1MulGlv(b *testing.B) {
+	benchJson("../test_vectors/blsG1Mul.json", G1MulGlv, b)
+}
+
 func BenchmarkG1Multiexp(b *testing.B) {
 	benchJson("../test_vectors/blsG1MultiExp.json", G1Multiexp, b)
 }
 
+func BenchmarkG1MultiexpStraus(b *testing.B) {
+	benchJson("../test_vectors/blsG1MultiExp.json", G1MultiexpStraus, b)
+}
+
 func BenchmarkG2Add(b *testing.B) {
 	benchJson("../test_vectors/blsG2Add.json", G2Add, b)
 }
@@ -254,10 +437,18 @@ func BenchmarkG2Mul(b *testing.B) {
 	benchJson("../test_vectors/blsG2Mul.json", G2Mul, b)
 }
 
+func BenchmarkG2MulGls(b *testing.B) {
+	benchJson("../test_vectors/blsG2Mul.json", G2MulGls, b)
+}
+
 func BenchmarkG2Multiexp(b *testing.B) {
 	benchJson("../test_vectors/blsG2MultiExp.json", G2Multiexp, b)
 }
 
+func BenchmarkG2MultiexpStraus(b *testing.B) {
+	benchJson("../test_vectors/blsG2MultiExp.json", G2MultiexpStraus, b)
+}
+
 func BenchmarkPairing(b *testing.B) {
 	benchJson("../test_vectors/blsPairing.json", Pairing, b)
 }
@@ -269,3 +460,123 @@ func BenchmarkMapFpToG1(b *testing.B) {
 func BenchmarkMapFp2ToG2(b *testing.B) {
 	benchJson("../test_vectors/blsMapG2.json", MapFp2ToG2, b)
 }
+
+func TestWithGas(t *testing.T) {
+	testJsonGas("../test_vectors/blsG1Add.json", G1AddWithGas, t)
+	testJsonGas("../test_vectors/blsG1Mul.json", G1MulWithGas, t)
+	testJsonGas("../test_vectors/blsG1MultiExp.json", G1MultiexpWithGas, t)
+	testJsonGas("../test_vectors/blsG2Add.json", G2AddWithGas, t)
+	testJsonGas("../test_vectors/blsG2Mul.json", G2MulWithGas, t)
+	testJsonGas("../test_vectors/blsG2MultiExp.json", G2MultiexpWithGas, t)
+	testJsonGas("../test_vectors/blsPairing.json", PairingWithGas, t)
+	testJsonGas("../test_vectors/blsMapG1.json", MapFpToG1WithGas, t)
+	testJsonGas("../test_vectors/blsMapG2.json", MapFp2ToG2WithGas, t)
+}
+
+// Precompile through the single call dispatcher with an unlimited budget
+func runAt(address uint64) Bls12Func {
+	return func(input []byte) ([]byte, error) {
+		output, _, err := Run(address, input, math.MaxUint64)
+		return output, err
+	}
+}
+
+// Dispatcher writing into one reused buffer
+func runIntoAt(address uint64) Bls12Func {
+	dst := make([]byte, 256)
+	return func(input []byte) ([]byte, error) {
+		n, _, err := RunInto(address, dst, input, math.MaxUint64)
+		if err != nil {
+			return nil, err
+		}
+		return dst[:n], nil
+	}
+}
+
+func TestRunInto(t *testing.T) {
+	testJson("../test_vectors/blsG1Add.json", true, runIntoAt(0x0a), t)
+	testJson("../test_vectors/blsG2Mul.json", true, runIntoAt(0x0e), t)
+	testJson("../test_vectors/blsPairing.json", true, runIntoAt(0x10), t)
+
+	dst := make([]byte, 128)
+	input := make([]byte, 256)
+	allocs := testing.AllocsPerRun(100, func() {
+		RunInto(0x0a, dst, input, math.MaxUint64)
+	})
+	if allocs != 0 {
+		t.Errorf("Expected no allocations, got %v", allocs)
+	}
+
+	if _, _, err := RunInto(0x0d, dst, make([]byte, 512),
+		math.MaxUint64); !errors.Is(err, ErrInvalidLength) {
+		t.Errorf("Expected invalid length for a short dst, got %v", err)
+	}
+}
+
+func TestRun(t *testing.T) {
+	testJson("../test_vectors/blsG1Add.json", true, runAt(0x0a), t)
+	testJson("../test_vectors/blsG1Mul.json", true, runAt(0x0b), t)
+	testJson("../test_vectors/blsG1MultiExp.json", true, runAt(0x0c), t)
+	testJson("../test_vectors/blsG2Add.json", true, runAt(0x0d), t)
+	testJson("../test_vectors/blsG2Mul.json", true, runAt(0x0e), t)
+	testJson("../test_vectors/blsG2MultiExp.json", true, runAt(0x0f), t)
+	testJson("../test_vectors/blsPairing.json", true, runAt(0x10), t)
+	testJson("../test_vectors/blsMapG1.json", true, runAt(0x11), t)
+	testJson("../test_vectors/blsMapG2.json", true, runAt(0x12), t)
+
+	if _, _, err := Run(0x13, make([]byte, 64), math.MaxUint64); err == nil {
+		t.Errorf("Expected unknown address error")
+	}
+}
+
+// Every success vector of every precompile in one batch
+func TestBatchRun(t *testing.T) {
+	files := []string{"blsG1Add", "blsG1Mul", "blsG1MultiExp", "blsG2Add",
+		"blsG2Mul", "blsG2MultiExp", "blsPairing", "blsMapG1", "blsMapG2"}
+	var batch Batch
+	var expected []string
+	var gas []uint64
+
+	for round := 0; round < 2; round++ {
+		batch.Reset()
+		expected = expected[:0]
+		gas = gas[:0]
+		for i, file := range files {
+			test_json, err := ioutil.ReadFile("../test_vectors/" + file + ".json")
+			if err != nil {
+				t.Fatal(err)
+			}
+			var tests []precompiledTest
+			if err = json.Unmarshal(test_json, &tests); err != nil {
+				t.Fatal(err)
+			}
+			for _, test := range tests {
+				input, err := hex.DecodeString(test.Input)
+				if err != nil {
+					t.Fatal(err)
+				}
+				batch.Add(uint64(0x0a+i), input, test.Gas)
+				expected = append(expected, test.Expected)
+				gas = append(gas, test.Gas)
+			}
+		}
+		batch.Add(0x13, nil, 0)
+
+		batch.Run()
+		for i := range expected {
+			output, gas_used, err := batch.Result(i)
+			if err != nil {
+				t.Fatalf("Call %d received unexpected error %v", i, err)
+			}
+			if gas_used != gas[i] {
+				t.Errorf("Expected gas %v, got %v", gas[i], gas_used)
+			}
+			if out_str := hex.EncodeToString(output); out_str != expected[i] {
+				t.Errorf("Expected %v, got %v", expected[i], out_str)
+			}
+		}
+		if _, _, err := batch.Result(len(expected)); err != ErrUnknownAddress {
+			t.Errorf("Expected unknown address, got %v", err)
+		}
+	}
+}
@@ -39,6 +39,22 @@ fn gen_g2_point(rng: &mut rand_chacha::ChaCha20Rng) -> [u8; 256] {
     return g2.unwrap();
 }
 
+const G1_GENERATOR: &str = "\
+    0000000000000000000000000000000017f1d3a73197d7942695638c4fa9ac0f\
+    c3688c4f9774b905a14e3a3f171bac586c55e83ff97a1aeffb3af00adb22c6bb\
+    0000000000000000000000000000000008b3f481e3aaa0f1a09e30ed741d8ae4\
+    fcf5e095d5d00af600db18cb2c04b3edd03cc744a2888ae40caa232946c5e7e1";
+
+const G2_GENERATOR: &str = "\
+    00000000000000000000000000000000024aa2b2f08f0a91260805272dc51051\
+    c6e47ad4fa403b02b4510b647ae3d1770bac0326a805bbefd48056c8c121bdb8\
+    0000000000000000000000000000000013e02b6052719f607dacd3a088274f65\
+    596bd0d09920b61ab5da61bbdc7f5049334cf11213945d57e5ac7d055d042b7e\
+    000000000000000000000000000000000ce5d527727d6e118cc9cdc6da2e351a\
+    adfd9baa8cbdd3a76d429a695160d12c923ac9cc3baca289e193548608b82801\
+    000000000000000000000000000000000606c4a02ea734cc32acd2b02bc28b99\
+    cb3e287e85a763af267492ab572e99ab3f370d275cec1da1aaa9075ff05f79be";
+
 fn bench_g1(c: &mut Criterion) {
     let mut group = c.benchmark_group("g1");
 
@@ -66,6 +82,46 @@ fn bench_g1(c: &mut Criterion) {
         b.iter(|| blstEIP2537Executor::g1_mul(&g1_for_mul));
     });
 
+    group.bench_function("g1_mul_glv", |b| {
+        b.iter(|| blstEIP2537Executor::g1_mul_glv(&g1_for_mul));
+    });
+
+    // Scalar length sweep, variable time against constant time
+    for bits in [8, 64, 128, 256].iter() {
+        let mut input = Vec::from(&g1_for_mul[..]);
+        for (i, byte) in input[128..].iter_mut().rev().enumerate() {
+            if i * 8 >= *bits {
+                *byte = 0;
+            }
+        }
+
+        for vartime in [true, false].iter() {
+            blstEIP2537Executor::mul_set_vartime(*vartime);
+            let name = if *vartime {
+                "g1_mul_bits"
+            } else {
+                "g1_mul_ct_bits"
+            };
+            group.bench_with_input(
+                BenchmarkId::new(name, bits),
+                &input,
+                |b, p| {
+                    b.iter(|| blstEIP2537Executor::g1_mul(&p));
+                },
+            );
+        }
+        blstEIP2537Executor::mul_set_vartime(true);
+    }
+
+    // Same scalar against the generator, served from the fixed base table
+    blstEIP2537Executor::fixed_base_init();
+    let mut g1_gen_for_mul = hex::decode(G1_GENERATOR).unwrap();
+    g1_gen_for_mul.extend(&scalar);
+
+    group.bench_function("g1_mul_generator", |b| {
+        b.iter(|| blstEIP2537Executor::g1_mul(&g1_gen_for_mul));
+    });
+
     let multiexp_sizes =
         vec![2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096];
     for n in multiexp_sizes.iter() {
@@ -99,8 +155,46 @@ fn bench_g1(c: &mut Criterion) {
                 b.iter(|| blstEIP2537Executor::g1_multiexp_bc(&p));
             },
         );
+        group.bench_with_input(
+            BenchmarkId::new("g1_multiexp_pippenger", n),
+            &pairs_for_multiexp,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::g1_multiexp_pippenger(&p));
+            },
+        );
+        group.bench_with_input(
+            BenchmarkId::new("g1_multiexp_straus", n),
+            &pairs_for_multiexp,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::g1_multiexp_straus(&p));
+            },
+        );
     }
 
+    // Thread scaling of the largest multiexp
+    let n = 4096;
+    let mut pairs_for_multiexp = Vec::with_capacity(160 * n);
+    for _ in 0..n {
+        let g1_point = gen_g1_point(&mut rng);
+        pairs_for_multiexp.extend(&g1_point);
+        let mut scalar = [0u8; 32];
+        rng.fill_bytes(&mut scalar);
+        pairs_for_multiexp.extend(&scalar);
+    }
+
+    let num_threads = vec![1, 2, 4, 8, 16];
+    for t in num_threads.iter() {
+        blstEIP2537Executor::set_num_threads(*t);
+        group.bench_with_input(
+            BenchmarkId::new(format!("g1_multiexp_{}_threads", n), t),
+            &pairs_for_multiexp,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::g1_multiexp(&p));
+            },
+        );
+    }
+    blstEIP2537Executor::set_num_threads(0);
+
     group.finish();
 }
 
@@ -131,6 +225,46 @@ fn bench_g2(c: &mut Criterion) {
         b.iter(|| blstEIP2537Executor::g2_mul(&g2_for_mul));
     });
 
+    group.bench_function("g2_mul_gls", |b| {
+        b.iter(|| blstEIP2537Executor::g2_mul_gls(&g2_for_mul));
+    });
+
+    // Scalar length sweep, variable time against constant time
+    for bits in [8, 64, 128, 256].iter() {
+        let mut input = Vec::from(&g2_for_mul[..]);
+        for (i, byte) in input[256..].iter_mut().rev().enumerate() {
+            if i * 8 >= *bits {
+                *byte = 0;
+            }
+        }
+
+        for vartime in [true, false].iter() {
+            blstEIP2537Executor::mul_set_vartime(*vartime);
+            let name = if *vartime {
+                "g2_mul_bits"
+            } else {
+                "g2_mul_ct_bits"
+            };
+            group.bench_with_input(
+                BenchmarkId::new(name, bits),
+                &input,
+                |b, p| {
+                    b.iter(|| blstEIP2537Executor::g2_mul(&p));
+                },
+            );
+        }
+        blstEIP2537Executor::mul_set_vartime(true);
+    }
+
+    // Same scalar against the generator, served from the fixed base table
+    blstEIP2537Executor::fixed_base_init();
+    let mut g2_gen_for_mul = hex::decode(G2_GENERATOR).unwrap();
+    g2_gen_for_mul.extend(&scalar);
+
+    group.bench_function("g2_mul_generator", |b| {
+        b.iter(|| blstEIP2537Executor::g2_mul(&g2_gen_for_mul));
+    });
+
     let multiexp_sizes = vec![2, 4, 8, 16, 32, 64, 128, 256, 512, 1024];
     for n in multiexp_sizes.iter() {
         let mut pairs_for_multiexp = Vec::with_capacity(288 * n);
@@ -163,8 +297,46 @@ fn bench_g2(c: &mut Criterion) {
                 b.iter(|| blstEIP2537Executor::g2_multiexp_bc(&p));
             },
         );
+        group.bench_with_input(
+            BenchmarkId::new("g2_multiexp_pippenger", n),
+            &pairs_for_multiexp,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::g2_multiexp_pippenger(&p));
+            },
+        );
+        group.bench_with_input(
+            BenchmarkId::new("g2_multiexp_straus", n),
+            &pairs_for_multiexp,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::g2_multiexp_straus(&p));
+            },
+        );
+    }
+
+    // Thread scaling of the largest multiexp
+    let n = 1024;
+    let mut pairs_for_multiexp = Vec::with_capacity(288 * n);
+    for _ in 0..n {
+        let g2_point = gen_g2_point(&mut rng);
+        pairs_for_multiexp.extend(&g2_point);
+        let mut scalar = [0u8; 32];
+        rng.fill_bytes(&mut scalar);
+        pairs_for_multiexp.extend(&scalar);
     }
 
+    let num_threads = vec![1, 2, 4, 8, 16];
+    for t in num_threads.iter() {
+        blstEIP2537Executor::set_num_threads(*t);
+        group.bench_with_input(
+            BenchmarkId::new(format!("g2_multiexp_{}_threads", n), t),
+            &pairs_for_multiexp,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::g2_multiexp(&p));
+            },
+        );
+    }
+    blstEIP2537Executor::set_num_threads(0);
+
     group.finish();
 }
 
@@ -191,6 +363,17 @@ fn bench_pairing(c: &mut Criterion) {
                 b.iter(|| blstEIP2537Executor::pairing(&p));
             },
         );
+
+        // Same G2 points every call, lines served from the cache
+        blstEIP2537Executor::pairing_line_cache_configure(*n).unwrap();
+        group.bench_with_input(
+            BenchmarkId::new("pairing_line_cache", n),
+            &pairs,
+            |b, p| {
+                b.iter(|| blstEIP2537Executor::pairing(&p));
+            },
+        );
+        blstEIP2537Executor::pairing_line_cache_configure(0).unwrap();
     }
 
     group.finish();
@@ -217,5 +400,84 @@ fn bench_map(c: &mut Criterion) {
     group.finish();
 }
 
-criterion_group!(benches, bench_g1, bench_g2, bench_pairing, bench_map);
+// Mixed independent calls, roughly as a precompile heavy block would issue
+fn bench_batch(c: &mut Criterion) {
+    let mut group = c.benchmark_group("batch");
+
+    let seed = [0u8; 32];
+    let mut rng = ChaCha20Rng::from_seed(seed);
+
+    let mut inputs: Vec<(Precompile, Vec<u8>)> = Vec::new();
+    for _ in 0..16 {
+        let mut scalar = [0u8; 32];
+        rng.fill_bytes(&mut scalar);
+
+        let g1_a = gen_g1_point(&mut rng);
+        let g1_b = gen_g1_point(&mut rng);
+        let g2_a = gen_g2_point(&mut rng);
+        let g2_b = gen_g2_point(&mut rng);
+
+        inputs.push((Precompile::G1Add, [&g1_a[..], &g1_b[..]].concat()));
+        inputs.push((Precompile::G1Mul, [&g1_a[..], &scalar[..]].concat()));
+        inputs.push((Precompile::G2Add, [&g2_a[..], &g2_b[..]].concat()));
+        inputs.push((Precompile::G2Mul, [&g2_a[..], &scalar[..]].concat()));
+        inputs.push((Precompile::MapFpToG1, gen_fp(&mut rng).to_vec()));
+        inputs.push((
+            Precompile::MapFp2ToG2,
+            [gen_fp(&mut rng), gen_fp(&mut rng)].concat(),
+        ));
+        inputs.push((
+            Precompile::G1Multiexp,
+            [&g1_a[..], &scalar[..], &g1_b[..], &scalar[..]].concat(),
+        ));
+        inputs.push((Precompile::Pairing, [&g1_a[..], &g2_a[..]].concat()));
+    }
+
+    let jobs: Vec<Job> = inputs
+        .iter()
+        .map(|(precompile, input)| Job {
+            precompile: *precompile,
+            input: &input,
+            gas_limit: u64::MAX,
+        })
+        .collect();
+    let mut outputs = vec![[0u8; 256]; jobs.len()];
+    let mut results = vec![JobResult::default(); jobs.len()];
+
+    group.bench_function(format!("mixed_{}_run", jobs.len()), |b| {
+        b.iter(|| {
+            for job in jobs.iter() {
+                let _ = blstEIP2537Executor::run(
+                    job.precompile.address(),
+                    job.input,
+                    job.gas_limit,
+                );
+            }
+        });
+    });
+
+    for t in [1, 2, 4, 0].iter() {
+        let mut executor = BatchExecutor::new(*t);
+        group.bench_function(
+            BenchmarkId::new(
+                format!("mixed_{}_executor_threads", jobs.len()),
+                executor.num_threads(),
+            ),
+            |b| {
+                b.iter(|| executor.execute(&jobs, &mut outputs, &mut results));
+            },
+        );
+    }
+
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_g1,
+    bench_g2,
+    bench_pairing,
+    bench_map,
+    bench_batch
+);
 criterion_main!(benches);
@@ -4,6 +4,10 @@
 
 #![allow(non_camel_case_types)]
 
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+
 pub type byte = u8;
 pub type EIP2537_ERROR = u32;
 const EIP2537_SUCCESS: EIP2537_ERROR = 0;
@@ -14,6 +18,10 @@ const EIP2537_ENCODING_ERROR: EIP2537_ERROR = 4;
 const EIP2537_INVALID_LENGTH: EIP2537_ERROR = 5;
 const EIP2537_EMPTY_INPUT: EIP2537_ERROR = 6;
 const EIP2537_MEMORY_ERROR: EIP2537_ERROR = 7;
+const EIP2537_OUT_OF_GAS: EIP2537_ERROR = 8;
+const EIP2537_UNKNOWN_ADDRESS: EIP2537_ERROR = 9;
+const EIP2537_FIXED_BASE_LIMIT: EIP2537_ERROR = 10;
+const EIP2537_INVALID_SELECTION: EIP2537_ERROR = 11;
 
 extern "C" {
     pub fn bls12_g1add(
@@ -46,6 +54,34 @@ extern "C" {
         in_len: usize,
     ) -> EIP2537_ERROR;
 
+    pub fn bls12_g1multiexp_pippenger(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1multiexp_straus(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1multiexp_scratch_size(in_len: usize) -> usize;
+
+    pub fn bls12_g1multiexp_with_scratch(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        scratch: *mut byte,
+        scratch_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1mul_glv(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+    ) -> EIP2537_ERROR;
+
     pub fn bls12_g2add(
         out: *mut byte,
         input: *const byte,
@@ -76,6 +112,66 @@ extern "C" {
         in_len: usize,
     ) -> EIP2537_ERROR;
 
+    pub fn bls12_g2multiexp_pippenger(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2multiexp_straus(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2multiexp_scratch_size(in_len: usize) -> usize;
+
+    pub fn bls12_g2multiexp_with_scratch(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        scratch: *mut byte,
+        scratch_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2mul_gls(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1add_batch(
+        out: *mut byte,
+        errs: *mut EIP2537_ERROR,
+        input: *const *const byte,
+        in_len: *const usize,
+        n: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1mul_batch(
+        out: *mut byte,
+        errs: *mut EIP2537_ERROR,
+        input: *const *const byte,
+        in_len: *const usize,
+        n: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2add_batch(
+        out: *mut byte,
+        errs: *mut EIP2537_ERROR,
+        input: *const *const byte,
+        in_len: *const usize,
+        n: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2mul_batch(
+        out: *mut byte,
+        errs: *mut EIP2537_ERROR,
+        input: *const *const byte,
+        in_len: *const usize,
+        n: usize,
+    ) -> EIP2537_ERROR;
+
     pub fn bls12_pairing(
         out: *mut byte,
         input: *const byte,
@@ -93,23 +189,645 @@ extern "C" {
         input: *const byte,
         in_len: usize,
     ) -> EIP2537_ERROR;
+
+    pub fn bls12_map_fp_to_g1_batch(
+        out: *mut byte,
+        errs: *mut EIP2537_ERROR,
+        input: *const *const byte,
+        in_len: *const usize,
+        n: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_map_fp2_to_g2_batch(
+        out: *mut byte,
+        errs: *mut EIP2537_ERROR,
+        input: *const *const byte,
+        in_len: *const usize,
+        n: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1add_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1mul_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1multiexp_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2add_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2mul_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2multiexp_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_pairing_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_map_fp_to_g1_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_map_fp2_to_g2_with_gas(
+        out: *mut byte,
+        input: *const byte,
+        in_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn eip2537_run(
+        address: u64,
+        input: *const byte,
+        in_len: usize,
+        out: *mut byte,
+        out_len: usize,
+        gas_limit: u64,
+        gas_used: *mut u64,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_set_num_threads(num_threads: usize);
+
+    pub fn bls12_set_thread_num_threads(num_threads: usize) -> usize;
+
+    pub fn bls12_pairing_set_parallel_threshold(min_pairs: usize);
+
+    pub fn bls12_multiexp_set_parallel_threshold(min_pairs: usize);
+
+    pub fn bls12_pairing_eliminated_pairs() -> u64;
+
+    pub fn bls12_mul_set_vartime(enable: i32);
+
+    pub fn bls12_g1multiexp_set_selection(
+        table: *const bls12_msm_selection,
+        num_entries: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g2multiexp_set_selection(
+        table: *const bls12_msm_selection,
+        num_entries: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_g1multiexp_get_selection(
+        table: *mut bls12_msm_selection,
+        max_entries: usize,
+    ) -> usize;
+
+    pub fn bls12_g2multiexp_get_selection(
+        table: *mut bls12_msm_selection,
+        max_entries: usize,
+    ) -> usize;
+
+    pub fn bls12_multiexp_calibrate(max_pairs: usize) -> EIP2537_ERROR;
+
+    pub fn bls12_scratch_arena_configure(max_bytes: usize);
+
+    pub fn bls12_scratch_arena_release();
+
+    pub fn bls12_point_cache_configure(
+        g1_entries: usize,
+        g2_entries: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_point_cache_get_stats(stats: *mut bls12_point_cache_stats);
+
+    pub fn bls12_pairing_line_cache_configure(
+        num_entries: usize,
+    ) -> EIP2537_ERROR;
+
+    pub fn bls12_pairing_line_cache_get_stats(hits: *mut u64, misses: *mut u64);
+
+    pub fn bls12_fixed_base_init();
+
+    pub fn bls12_g1_add_fixed_base(base: *const byte) -> EIP2537_ERROR;
+
+    pub fn bls12_g2_add_fixed_base(base: *const byte) -> EIP2537_ERROR;
+}
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct bls12_point_cache_stats {
+    pub g1_hits: u64,
+    pub g1_misses: u64,
+    pub g2_hits: u64,
+    pub g2_misses: u64,
+}
+
+pub const BLS12_MSM_NAIVE: u32 = 0;
+pub const BLS12_MSM_BC: u32 = 1;
+pub const BLS12_MSM_STRAUS: u32 = 2;
+pub const BLS12_MSM_PIPPENGER: u32 = 3;
+
+#[repr(C)]
+#[derive(Debug, Default, Clone, Copy)]
+pub struct bls12_msm_selection {
+    pub max_pairs: usize,
+    pub engine: u32,
 }
 
 pub struct blstEIP2537Executor;
 
-impl blstEIP2537Executor {
-    fn decode_eip2537_error(err: EIP2537_ERROR) -> &'static str {
-        match err {
-            EIP2537_SUCCESS => "Success",
-            EIP2537_POINT_NOT_ON_CURVE => "point not on curve",
-            EIP2537_POINT_NOT_IN_SUBGROUP => "point not in subgroup",
-            EIP2537_INVALID_ELEMENT => "invalid element",
-            EIP2537_ENCODING_ERROR => "encoding error",
-            EIP2537_INVALID_LENGTH => "invalid length",
-            EIP2537_EMPTY_INPUT => "empty input",
-            EIP2537_MEMORY_ERROR => "memory allocation error",
-            _ => "unknown error condition",
-        }
+impl blstEIP2537Executor {
+    fn decode_eip2537_error(err: EIP2537_ERROR) -> &'static str {
+        match err {
+            EIP2537_SUCCESS => "Success",
+            EIP2537_POINT_NOT_ON_CURVE => "point not on curve",
+            EIP2537_POINT_NOT_IN_SUBGROUP => "point not in subgroup",
+            EIP2537_INVALID_ELEMENT => "invalid element",
+            EIP2537_ENCODING_ERROR => "encoding error",
+            EIP2537_INVALID_LENGTH => "invalid length",
+            EIP2537_EMPTY_INPUT => "empty input",
+            EIP2537_MEMORY_ERROR => "memory allocation error",
+            EIP2537_OUT_OF_GAS => "out of gas",
+            EIP2537_UNKNOWN_ADDRESS => "unknown address",
+            EIP2537_FIXED_BASE_LIMIT => "fixed base limit reached",
+            EIP2537_INVALID_SELECTION => "invalid selection table",
+            _ => "unknown error condition",
+        }
+    }
+
+    // Number of threads for parallel paths, 0 uses all online cores
+    pub fn set_num_threads(num_threads: usize) {
+        unsafe { bls12_set_num_threads(num_threads) };
+    }
+
+    // Minimum number of pairs before pairing is split across threads
+    pub fn set_pairing_parallel_threshold(min_pairs: usize) {
+        unsafe { bls12_pairing_set_parallel_threshold(min_pairs) };
+    }
+
+    // Minimum number of pairs before multiexp is split across threads
+    pub fn set_multiexp_parallel_threshold(min_pairs: usize) {
+        unsafe { bls12_multiexp_set_parallel_threshold(min_pairs) };
+    }
+
+    // Scalar length aware g1_mul/g2_mul, on by default as inputs are public
+    pub fn mul_set_vartime(enable: bool) {
+        unsafe { bls12_mul_set_vartime(enable as i32) };
+    }
+
+    // Time every multiexp engine on this host and install the fastest
+    pub fn multiexp_calibrate(max_pairs: usize) -> Result<(), &'static str> {
+        let err = unsafe { bls12_multiexp_calibrate(max_pairs) };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    // Multiexp engine selection tables, an empty table restores the default
+    pub fn g1_multiexp_set_selection(
+        table: &[bls12_msm_selection],
+    ) -> Result<(), &'static str> {
+        let err = unsafe {
+            bls12_g1multiexp_set_selection(table.as_ptr(), table.len())
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    pub fn g2_multiexp_set_selection(
+        table: &[bls12_msm_selection],
+    ) -> Result<(), &'static str> {
+        let err = unsafe {
+            bls12_g2multiexp_set_selection(table.as_ptr(), table.len())
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    pub fn g1_multiexp_get_selection() -> Vec<bls12_msm_selection> {
+        let mut table = vec![bls12_msm_selection::default(); 16];
+        let n = unsafe {
+            bls12_g1multiexp_get_selection(table.as_mut_ptr(), table.len())
+        };
+        table.truncate(n);
+        table
+    }
+
+    pub fn g2_multiexp_get_selection() -> Vec<bls12_msm_selection> {
+        let mut table = vec![bls12_msm_selection::default(); 16];
+        let n = unsafe {
+            bls12_g2multiexp_get_selection(table.as_mut_ptr(), table.len())
+        };
+        table.truncate(n);
+        table
+    }
+
+    // Reuse a per thread multiexp scratch buffer of up to max_bytes, 0 is off
+    pub fn scratch_arena_configure(max_bytes: usize) {
+        unsafe { bls12_scratch_arena_configure(max_bytes) };
+    }
+
+    // Free the calling thread's multiexp scratch buffer
+    pub fn scratch_arena_release() {
+        unsafe { bls12_scratch_arena_release() };
+    }
+
+    // Pairs dropped or merged away before the Miller loop, over all calls
+    pub fn pairing_eliminated_pairs() -> u64 {
+        unsafe { bls12_pairing_eliminated_pairs() }
+    }
+
+    // Size the validated point caches, 0 entries disables a group
+    pub fn point_cache_configure(
+        g1_entries: usize,
+        g2_entries: usize,
+    ) -> Result<(), &'static str> {
+        let err =
+            unsafe { bls12_point_cache_configure(g1_entries, g2_entries) };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    pub fn point_cache_stats() -> bls12_point_cache_stats {
+        let mut stats = bls12_point_cache_stats::default();
+        unsafe { bls12_point_cache_get_stats(&mut stats) };
+        stats
+    }
+
+    // Size the pairing G2 line cache, 0 entries disables it
+    pub fn pairing_line_cache_configure(
+        num_entries: usize,
+    ) -> Result<(), &'static str> {
+        let err = unsafe { bls12_pairing_line_cache_configure(num_entries) };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    // Returns (hits, misses) of the pairing G2 line cache
+    pub fn pairing_line_cache_stats() -> (u64, u64) {
+        let mut hits = 0u64;
+        let mut misses = 0u64;
+        unsafe { bls12_pairing_line_cache_get_stats(&mut hits, &mut misses) };
+        (hits, misses)
+    }
+
+    // Build the generator tables for g1_mul/g2_mul now, not on first use
+    pub fn fixed_base_init() {
+        unsafe { bls12_fixed_base_init() };
+    }
+
+    // Register a well-known G1 base for fixed base multiplication
+    pub fn g1_add_fixed_base(base: &[u8]) -> Result<(), &'static str> {
+        if base.len() != 128 {
+            return Err(blstEIP2537Executor::decode_eip2537_error(
+                EIP2537_INVALID_LENGTH,
+            ));
+        }
+
+        let err = unsafe { bls12_g1_add_fixed_base(base.as_ptr()) };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    // Register a well-known G2 base for fixed base multiplication
+    pub fn g2_add_fixed_base(base: &[u8]) -> Result<(), &'static str> {
+        if base.len() != 256 {
+            return Err(blstEIP2537Executor::decode_eip2537_error(
+                EIP2537_INVALID_LENGTH,
+            ));
+        }
+
+        let err = unsafe { bls12_g2_add_fixed_base(base.as_ptr()) };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(())
+    }
+
+    // Independent calls run as one batch sharing the inversion to affine
+    fn batch<const N: usize>(
+        inputs: &[&[u8]],
+        op: unsafe extern "C" fn(
+            *mut byte,
+            *mut EIP2537_ERROR,
+            *const *const byte,
+            *const usize,
+            usize,
+        ) -> EIP2537_ERROR,
+    ) -> Vec<Result<[u8; N], &'static str>> {
+        let ptrs: Vec<*const byte> =
+            inputs.iter().map(|i| i.as_ptr()).collect();
+        let lens: Vec<usize> = inputs.iter().map(|i| i.len()).collect();
+        let mut output = vec![[0u8; N]; inputs.len()];
+        let mut errs = vec![EIP2537_SUCCESS; inputs.len()];
+
+        unsafe {
+            op(
+                output.as_mut_ptr() as *mut byte,
+                errs.as_mut_ptr(),
+                ptrs.as_ptr(),
+                lens.as_ptr(),
+                inputs.len(),
+            )
+        };
+
+        output
+            .into_iter()
+            .zip(errs)
+            .map(|(out, err)| {
+                if err != EIP2537_SUCCESS {
+                    return Err(blstEIP2537Executor::decode_eip2537_error(err));
+                }
+                Ok(out)
+            })
+            .collect()
+    }
+
+    pub fn g1_add_batch(
+        inputs: &[&[u8]],
+    ) -> Vec<Result<[u8; 128], &'static str>> {
+        blstEIP2537Executor::batch::<128>(inputs, bls12_g1add_batch)
+    }
+
+    pub fn g1_mul_batch(
+        inputs: &[&[u8]],
+    ) -> Vec<Result<[u8; 128], &'static str>> {
+        blstEIP2537Executor::batch::<128>(inputs, bls12_g1mul_batch)
+    }
+
+    pub fn g2_add_batch(
+        inputs: &[&[u8]],
+    ) -> Vec<Result<[u8; 256], &'static str>> {
+        blstEIP2537Executor::batch::<256>(inputs, bls12_g2add_batch)
+    }
+
+    pub fn g2_mul_batch(
+        inputs: &[&[u8]],
+    ) -> Vec<Result<[u8; 256], &'static str>> {
+        blstEIP2537Executor::batch::<256>(inputs, bls12_g2mul_batch)
+    }
+
+    pub fn map_fp_to_g1_batch(
+        inputs: &[&[u8]],
+    ) -> Vec<Result<[u8; 128], &'static str>> {
+        blstEIP2537Executor::batch::<128>(inputs, bls12_map_fp_to_g1_batch)
+    }
+
+    pub fn map_fp2_to_g2_batch(
+        inputs: &[&[u8]],
+    ) -> Vec<Result<[u8; 256], &'static str>> {
+        blstEIP2537Executor::batch::<256>(inputs, bls12_map_fp2_to_g2_batch)
+    }
+
+    // Precompile at address writing into output, which must hold its
+    // output (128, 256 or 32 bytes). Returns the output length and gas used
+    pub fn run_into(
+        address: u64,
+        input: &[u8],
+        gas_limit: u64,
+        output: &mut [u8],
+    ) -> (Result<usize, &'static str>, u64) {
+        const OUT_LEN: [usize; 9] =
+            [128, 128, 128, 256, 256, 256, 32, 128, 256];
+        let mut gas_used = 0u64;
+
+        let err = unsafe {
+            eip2537_run(
+                address,
+                input.as_ptr(),
+                input.len(),
+                output.as_mut_ptr(),
+                output.len(),
+                gas_limit,
+                &mut gas_used,
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return (
+                Err(blstEIP2537Executor::decode_eip2537_error(err)),
+                gas_used,
+            );
+        }
+
+        (Ok(OUT_LEN[(address - 0x0a) as usize]), gas_used)
+    }
+
+    // Precompile at address with length check, gas and execution in one
+    // FFI call, returns the output and the gas used
+    pub fn run(
+        address: u64,
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<Vec<u8>, &'static str>, u64) {
+        let mut output = vec![0u8; 256];
+        let (res, gas_used) = blstEIP2537Executor::run_into(
+            address,
+            input,
+            gas_limit,
+            &mut output,
+        );
+
+        (
+            res.map(|len| {
+                output.truncate(len);
+                output
+            }),
+            gas_used,
+        )
+    }
+
+    // Calls charged against gas_limit before any input is decoded, returns
+    // the gas used alongside the result
+    fn with_gas<const N: usize>(
+        input: &[u8],
+        gas_limit: u64,
+        op: unsafe extern "C" fn(
+            *mut byte,
+            *const byte,
+            usize,
+            u64,
+            *mut u64,
+        ) -> EIP2537_ERROR,
+    ) -> (Result<[u8; N], &'static str>, u64) {
+        let mut output = [0u8; N];
+        let mut gas_used = 0u64;
+
+        let err = unsafe {
+            op(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+                gas_limit,
+                &mut gas_used,
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return (
+                Err(blstEIP2537Executor::decode_eip2537_error(err)),
+                gas_used,
+            );
+        }
+
+        (Ok(output), gas_used)
+    }
+
+    pub fn g1_add_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 128], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<128>(
+            input,
+            gas_limit,
+            bls12_g1add_with_gas,
+        )
+    }
+
+    pub fn g1_mul_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 128], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<128>(
+            input,
+            gas_limit,
+            bls12_g1mul_with_gas,
+        )
+    }
+
+    pub fn g1_multiexp_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 128], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<128>(
+            input,
+            gas_limit,
+            bls12_g1multiexp_with_gas,
+        )
+    }
+
+    pub fn g2_add_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 256], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<256>(
+            input,
+            gas_limit,
+            bls12_g2add_with_gas,
+        )
+    }
+
+    pub fn g2_mul_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 256], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<256>(
+            input,
+            gas_limit,
+            bls12_g2mul_with_gas,
+        )
+    }
+
+    pub fn g2_multiexp_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 256], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<256>(
+            input,
+            gas_limit,
+            bls12_g2multiexp_with_gas,
+        )
+    }
+
+    pub fn pairing_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 32], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<32>(
+            input,
+            gas_limit,
+            bls12_pairing_with_gas,
+        )
+    }
+
+    pub fn map_fp_to_g1_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 128], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<128>(
+            input,
+            gas_limit,
+            bls12_map_fp_to_g1_with_gas,
+        )
+    }
+
+    pub fn map_fp2_to_g2_with_gas(
+        input: &[u8],
+        gas_limit: u64,
+    ) -> (Result<[u8; 256], &'static str>, u64) {
+        blstEIP2537Executor::with_gas::<256>(
+            input,
+            gas_limit,
+            bls12_map_fp2_to_g2_with_gas,
+        )
     }
 
     pub fn g1_add<'a>(input: &'a [u8]) -> Result<[u8; 128], &'static str> {
@@ -140,6 +858,20 @@ impl blstEIP2537Executor {
         Ok(output)
     }
 
+    pub fn g1_mul_glv<'a>(input: &'a [u8]) -> Result<[u8; 128], &'static str> {
+        let mut output = [0u8; 128];
+
+        let err = unsafe {
+            bls12_g1mul_glv(output.as_mut_ptr(), input.as_ptr(), input.len())
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
     pub fn g1_multiexp<'a>(input: &'a [u8]) -> Result<[u8; 128], &'static str> {
         let mut output = [0u8; 128];
 
@@ -194,6 +926,74 @@ impl blstEIP2537Executor {
         Ok(output)
     }
 
+    pub fn g1_multiexp_pippenger<'a>(
+        input: &'a [u8],
+    ) -> Result<[u8; 128], &'static str> {
+        let mut output = [0u8; 128];
+
+        let err = unsafe {
+            bls12_g1multiexp_pippenger(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
+    pub fn g1_multiexp_straus<'a>(
+        input: &'a [u8],
+    ) -> Result<[u8; 128], &'static str> {
+        let mut output = [0u8; 128];
+
+        let err = unsafe {
+            bls12_g1multiexp_straus(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
+    // Bytes of scratch g1_multiexp_with_scratch needs for an input length
+    pub fn g1_multiexp_scratch_size(in_len: usize) -> usize {
+        unsafe { bls12_g1multiexp_scratch_size(in_len) }
+    }
+
+    pub fn g1_multiexp_with_scratch<'a>(
+        input: &'a [u8],
+        scratch: &mut [u8],
+    ) -> Result<[u8; 128], &'static str> {
+        let mut output = [0u8; 128];
+
+        let err = unsafe {
+            bls12_g1multiexp_with_scratch(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+                scratch.as_mut_ptr(),
+                scratch.len(),
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
     pub fn g2_add<'a>(input: &'a [u8]) -> Result<[u8; 256], &'static str> {
         let mut output = [0u8; 256];
 
@@ -222,6 +1022,20 @@ impl blstEIP2537Executor {
         Ok(output)
     }
 
+    pub fn g2_mul_gls<'a>(input: &'a [u8]) -> Result<[u8; 256], &'static str> {
+        let mut output = [0u8; 256];
+
+        let err = unsafe {
+            bls12_g2mul_gls(output.as_mut_ptr(), input.as_ptr(), input.len())
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
     pub fn g2_multiexp<'a>(input: &'a [u8]) -> Result<[u8; 256], &'static str> {
         let mut output = [0u8; 256];
 
@@ -276,6 +1090,74 @@ impl blstEIP2537Executor {
         Ok(output)
     }
 
+    pub fn g2_multiexp_pippenger<'a>(
+        input: &'a [u8],
+    ) -> Result<[u8; 256], &'static str> {
+        let mut output = [0u8; 256];
+
+        let err = unsafe {
+            bls12_g2multiexp_pippenger(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
+    pub fn g2_multiexp_straus<'a>(
+        input: &'a [u8],
+    ) -> Result<[u8; 256], &'static str> {
+        let mut output = [0u8; 256];
+
+        let err = unsafe {
+            bls12_g2multiexp_straus(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
+    // Bytes of scratch g2_multiexp_with_scratch needs for an input length
+    pub fn g2_multiexp_scratch_size(in_len: usize) -> usize {
+        unsafe { bls12_g2multiexp_scratch_size(in_len) }
+    }
+
+    pub fn g2_multiexp_with_scratch<'a>(
+        input: &'a [u8],
+        scratch: &mut [u8],
+    ) -> Result<[u8; 256], &'static str> {
+        let mut output = [0u8; 256];
+
+        let err = unsafe {
+            bls12_g2multiexp_with_scratch(
+                output.as_mut_ptr(),
+                input.as_ptr(),
+                input.len(),
+                scratch.as_mut_ptr(),
+                scratch.len(),
+            )
+        };
+
+        if err != EIP2537_SUCCESS {
+            return Err(blstEIP2537Executor::decode_eip2537_error(err));
+        }
+
+        Ok(output)
+    }
+
     pub fn pairing<'a>(input: &'a [u8]) -> Result<[u8; 32], &'static str> {
         let mut output = [0u8; 32];
 
@@ -327,6 +1209,246 @@ impl blstEIP2537Executor {
     }
 }
 
+// Precompiles by address, for batches of mixed calls
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Precompile {
+    G1Add = 0x0a,
+    G1Mul = 0x0b,
+    G1Multiexp = 0x0c,
+    G2Add = 0x0d,
+    G2Mul = 0x0e,
+    G2Multiexp = 0x0f,
+    Pairing = 0x10,
+    MapFpToG1 = 0x11,
+    MapFp2ToG2 = 0x12,
+}
+
+impl Precompile {
+    pub fn address(self) -> u64 {
+        self as u64
+    }
+
+    pub fn output_len(self) -> usize {
+        match self {
+            Precompile::G1Add
+            | Precompile::G1Mul
+            | Precompile::G1Multiexp
+            | Precompile::MapFpToG1 => 128,
+            Precompile::Pairing => 32,
+            _ => 256,
+        }
+    }
+}
+
+pub struct Job<'a> {
+    pub precompile: Precompile,
+    pub input: &'a [u8],
+    pub gas_limit: u64,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct JobResult {
+    pub status: Result<(), &'static str>,
+    pub gas_used: u64,
+}
+
+impl Default for JobResult {
+    fn default() -> Self {
+        JobResult {
+            status: Ok(()),
+            gas_used: 0,
+        }
+    }
+}
+
+// Jobs of one batch shared with the workers, which claim indices until
+// none are left. Pointers stay valid as execute waits for every worker
+struct BatchJobs {
+    jobs: *const Job<'static>,
+    outputs: *mut [u8; 256],
+    results: *mut JobResult,
+    len: usize,
+    next: AtomicUsize,
+}
+
+unsafe impl Send for BatchJobs {}
+unsafe impl Sync for BatchJobs {}
+
+impl BatchJobs {
+    fn run(&self) {
+        loop {
+            let i = self.next.fetch_add(1, Ordering::Relaxed);
+            if i >= self.len {
+                break;
+            }
+
+            let (job, out, result) = unsafe {
+                (
+                    &*self.jobs.add(i),
+                    &mut *self.outputs.add(i),
+                    &mut *self.results.add(i),
+                )
+            };
+
+            let mut gas_used = 0u64;
+            let err = unsafe {
+                eip2537_run(
+                    job.precompile.address(),
+                    job.input.as_ptr(),
+                    job.input.len(),
+                    out.as_mut_ptr(),
+                    out.len(),
+                    job.gas_limit,
+                    &mut gas_used,
+                )
+            };
+
+            result.gas_used = gas_used;
+            result.status = if err == EIP2537_SUCCESS {
+                Ok(())
+            } else {
+                Err(blstEIP2537Executor::decode_eip2537_error(err))
+            };
+        }
+    }
+}
+
+struct PoolState {
+    batch: Option<Arc<BatchJobs>>,
+    generation: u64,
+    running: usize,
+    shutdown: bool,
+}
+
+struct PoolShared {
+    state: Mutex<PoolState>,
+    work: Condvar,
+    done: Condvar,
+}
+
+// Persistent worker threads running independent precompile calls in
+// parallel, the calling thread takes part in each batch. Calls made by the
+// pool stay on their thread (bls12_set_thread_num_threads) so large pairing
+// and multiexp jobs do not start threads of their own on top of the pool
+pub struct BatchExecutor {
+    shared: Arc<PoolShared>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl BatchExecutor {
+    // num_threads of 0 uses all available cores
+    pub fn new(num_threads: usize) -> BatchExecutor {
+        let num_threads = if num_threads == 0 {
+            std::thread::available_parallelism().map_or(1, |n| n.get())
+        } else {
+            num_threads
+        };
+
+        let shared = Arc::new(PoolShared {
+            state: Mutex::new(PoolState {
+                batch: None,
+                generation: 0,
+                running: 0,
+                shutdown: false,
+            }),
+            work: Condvar::new(),
+            done: Condvar::new(),
+        });
+
+        let workers = (1..num_threads)
+            .map(|_| {
+                let shared = shared.clone();
+                std::thread::spawn(move || BatchExecutor::worker(&shared))
+            })
+            .collect();
+
+        BatchExecutor { shared, workers }
+    }
+
+    fn worker(shared: &PoolShared) {
+        unsafe { bls12_set_thread_num_threads(1) };
+
+        let mut seen = 0u64;
+        loop {
+            let batch = {
+                let mut state = shared.state.lock().unwrap();
+                while !state.shutdown && state.generation == seen {
+                    state = shared.work.wait(state).unwrap();
+                }
+                if state.shutdown {
+                    return;
+                }
+                seen = state.generation;
+                state.batch.clone()
+            };
+
+            if let Some(batch) = batch {
+                batch.run();
+            }
+
+            let mut state = shared.state.lock().unwrap();
+            state.running -= 1;
+            if state.running == 0 {
+                shared.done.notify_all();
+            }
+        }
+    }
+
+    pub fn num_threads(&self) -> usize {
+        self.workers.len() + 1
+    }
+
+    // Run jobs across the pool, job i writes the first output_len bytes of
+    // outputs[i] and its status and gas used to results[i]
+    pub fn execute(
+        &mut self,
+        jobs: &[Job],
+        outputs: &mut [[u8; 256]],
+        results: &mut [JobResult],
+    ) {
+        assert!(outputs.len() >= jobs.len() && results.len() >= jobs.len());
+        if jobs.is_empty() {
+            return;
+        }
+
+        let batch = Arc::new(BatchJobs {
+            jobs: jobs.as_ptr() as *const Job<'static>,
+            outputs: outputs.as_mut_ptr(),
+            results: results.as_mut_ptr(),
+            len: jobs.len(),
+            next: AtomicUsize::new(0),
+        });
+
+        {
+            let mut state = self.shared.state.lock().unwrap();
+            state.batch = Some(batch.clone());
+            state.generation += 1;
+            state.running = self.workers.len();
+            self.shared.work.notify_all();
+        }
+
+        let prev = unsafe { bls12_set_thread_num_threads(1) };
+        batch.run();
+        unsafe { bls12_set_thread_num_threads(prev) };
+
+        let mut state = self.shared.state.lock().unwrap();
+        while state.running != 0 {
+            state = self.shared.done.wait(state).unwrap();
+        }
+        state.batch = None;
+    }
+}
+
+impl Drop for BatchExecutor {
+    fn drop(&mut self) {
+        self.shared.state.lock().unwrap().shutdown = true;
+        self.shared.work.notify_all();
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -395,6 +1517,16 @@ mod tests {
         assert!(success);
     }
 
+    #[test]
+    fn test_g1mul_glv() {
+        let p = "../test_vectors/g1_mul.csv";
+        let f = |input: &[u8]| {
+            blstEIP2537Executor::g1_mul_glv(input).map(|r| r.to_vec())
+        };
+        let success = run_on_test_inputs(p, true, f);
+        assert!(success);
+    }
+
     #[test]
     fn test_g1_not_on_curve() {
         let p = "../test_vectors/g1_not_on_curve.csv";
@@ -435,6 +1567,17 @@ mod tests {
         assert!(success);
     }
 
+    #[test]
+    fn test_g1multiexp_pippenger() {
+        let p = "../test_vectors/g1_multiexp.csv";
+        let f = |input: &[u8]| {
+            blstEIP2537Executor::g1_multiexp_pippenger(input)
+                .map(|r| r.to_vec())
+        };
+        let success = run_on_test_inputs(p, true, f);
+        assert!(success);
+    }
+
     #[test]
     fn test_g2add() {
         let p = "../test_vectors/g2_add.csv";
@@ -455,6 +1598,16 @@ mod tests {
         assert!(success);
     }
 
+    #[test]
+    fn test_g2mul_gls() {
+        let p = "../test_vectors/g2_mul.csv";
+        let f = |input: &[u8]| {
+            blstEIP2537Executor::g2_mul_gls(input).map(|r| r.to_vec())
+        };
+        let success = run_on_test_inputs(p, true, f);
+        assert!(success);
+    }
+
     #[test]
     fn test_g2_not_on_curve() {
         let p = "../test_vectors/g2_not_on_curve.csv";
@@ -495,6 +1648,17 @@ mod tests {
         assert!(success);
     }
 
+    #[test]
+    fn test_g2multiexp_pippenger() {
+        let p = "../test_vectors/g2_multiexp.csv";
+        let f = |input: &[u8]| {
+            blstEIP2537Executor::g2_multiexp_pippenger(input)
+                .map(|r| r.to_vec())
+        };
+        let success = run_on_test_inputs(p, true, f);
+        assert!(success);
+    }
+
     #[test]
     fn test_pairing() {
         let p = "../test_vectors/pairing.csv";
@@ -554,4 +1718,99 @@ mod tests {
         let success = run_on_test_inputs(p, false, f);
         assert!(success);
     }
+
+    #[test]
+    fn test_out_of_gas() {
+        // Zero encodings are points at infinity, the cost is charged first
+        let input = vec![0u8; 4096 * 288];
+        let cost = 4096 * 55000 * 174 / 1000;
+        let (res, gas_used) =
+            blstEIP2537Executor::g2_multiexp_with_gas(&input, cost - 1);
+        assert_eq!(res, Err("out of gas"));
+        assert_eq!(gas_used, cost - 1);
+
+        let (res, gas_used) =
+            blstEIP2537Executor::pairing_with_gas(&input[..384], 138000);
+        assert_eq!(res.map(|r| r[31]), Ok(1));
+        assert_eq!(gas_used, 138000);
+
+        let (res, gas_used) =
+            blstEIP2537Executor::map_fp_to_g1_with_gas(&input[..63], 5500);
+        assert_eq!(res, Err("invalid length"));
+        assert_eq!(gas_used, 0);
+    }
+
+    #[test]
+    fn test_run() {
+        let input = vec![0u8; 384];
+        let (res, gas_used) = blstEIP2537Executor::run(0x10, &input, 138000);
+        assert_eq!(res.map(|r| r.len()), Ok(32));
+        assert_eq!(gas_used, 138000);
+
+        let (res, gas_used) =
+            blstEIP2537Executor::run(0x0a, &input[..256], 600);
+        assert_eq!(res, Ok(vec![0u8; 128]));
+        assert_eq!(gas_used, 600);
+
+        let (res, gas_used) = blstEIP2537Executor::run(0x13, &input, 1000000);
+        assert_eq!(res, Err("unknown address"));
+        assert_eq!(gas_used, 0);
+
+        let mut output = [0u8; 128];
+        let (res, gas_used) = blstEIP2537Executor::run_into(
+            0x0a,
+            &input[..256],
+            600,
+            &mut output,
+        );
+        assert_eq!(res, Ok(128));
+        assert_eq!(gas_used, 600);
+
+        let (res, _) =
+            blstEIP2537Executor::run_into(0x0d, &[0u8; 512], 600, &mut output);
+        assert_eq!(res, Err("invalid length"));
+    }
+
+    #[test]
+    fn test_batch_executor() {
+        let zeros = vec![0u8; 384];
+        let jobs = [
+            Job {
+                precompile: Precompile::G1Add,
+                input: &zeros[..256],
+                gas_limit: 600,
+            },
+            Job {
+                precompile: Precompile::Pairing,
+                input: &zeros,
+                gas_limit: 138000,
+            },
+            Job {
+                precompile: Precompile::G2Add,
+                input: &zeros,
+                gas_limit: 4500,
+            },
+            Job {
+                precompile: Precompile::MapFpToG1,
+                input: &zeros[..64],
+                gas_limit: 5499,
+            },
+        ];
+        let mut outputs = vec![[0xffu8; 256]; jobs.len()];
+        let mut results = vec![JobResult::default(); jobs.len()];
+
+        let mut executor = BatchExecutor::new(3);
+        for _ in 0..2 {
+            executor.execute(&jobs, &mut outputs, &mut results);
+
+            assert_eq!(results[0].status, Ok(()));
+            assert_eq!(results[0].gas_used, 600);
+            assert_eq!(&outputs[0][..128], &zeros[..128]);
+            assert_eq!(results[1].status, Ok(()));
+            assert_eq!(outputs[1][31], 1);
+            assert_eq!(results[2].status, Err("invalid length"));
+            assert_eq!(results[3].status, Err("out of gas"));
+            assert_eq!(results[3].gas_used, 5500);
+        }
+    }
 }
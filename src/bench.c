@@ -0,0 +1,505 @@
+/*
+ * Copyright Supranational LLC
+ * Licensed under the Apache License, Version 2.0, see LICENSE for details.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "blst.h"
+#include "eip2537.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+# include <x86intrin.h>
+# define BENCH_HAVE_TSC
+#endif
+
+/* Benchmark of every precompile entry point without bindings, one row per
+   function, input size and input case as CSV (default) or JSON lines. The
+   random case runs next to known worst cases for each function so their
+   cost can be compared against the same gas charge
+
+   Usage: bench_eip2537 [csv|json] [min_ms]
+
+   Each row is warmed up then repeated for at least min_ms (default 200).
+   cycles_per_op is the time stamp counter on x86_64 and 0 elsewhere */
+
+#define BENCH_MAX_PAIRS         4096
+#define BENCH_MAX_PAIRING_PAIRS 64
+
+/* Input generation */
+static uint64_t bench_rng_state = 0x2537;
+
+static uint64_t bench_rand() {
+  uint64_t z = (bench_rng_state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void bench_rand_bytes(byte* out, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    out[i] = (byte)bench_rand();
+  }
+}
+
+static void bench_fp_to_bytes(byte out[64], const blst_fp* fp) {
+  memset(out, 0, 16);
+  blst_bendian_from_fp(out + 16, fp);
+}
+
+/* Random multiples of the generators, encoded as EIP-2537 points */
+static void bench_g1_points(byte* out, size_t stride, size_t num) {
+  byte           k[32];
+  blst_p1        p, step;
+  blst_p1_affine p_aff;
+
+  bench_rand_bytes(k, 32);
+  blst_p1_mult(&p, blst_p1_generator(), k, 255);
+  bench_rand_bytes(k, 32);
+  blst_p1_mult(&step, blst_p1_generator(), k, 255);
+
+  for (size_t i = 0; i < num; ++i) {
+    blst_p1_to_affine(&p_aff, &p);
+    bench_fp_to_bytes(out + (i * stride), &(p_aff.x));
+    bench_fp_to_bytes(out + (i * stride) + 64, &(p_aff.y));
+    blst_p1_add_or_double(&p, &p, &step);
+  }
+}
+
+static void bench_g2_points(byte* out, size_t stride, size_t num) {
+  byte           k[32];
+  blst_p2        p, step;
+  blst_p2_affine p_aff;
+
+  bench_rand_bytes(k, 32);
+  blst_p2_mult(&p, blst_p2_generator(), k, 255);
+  bench_rand_bytes(k, 32);
+  blst_p2_mult(&step, blst_p2_generator(), k, 255);
+
+  for (size_t i = 0; i < num; ++i) {
+    blst_p2_to_affine(&p_aff, &p);
+    bench_fp_to_bytes(out + (i * stride), &(p_aff.x.fp[0]));
+    bench_fp_to_bytes(out + (i * stride) + 64, &(p_aff.x.fp[1]));
+    bench_fp_to_bytes(out + (i * stride) + 128, &(p_aff.y.fp[0]));
+    bench_fp_to_bytes(out + (i * stride) + 192, &(p_aff.y.fp[1]));
+    blst_p2_add_or_double(&p, &p, &step);
+  }
+}
+
+/* Full 256 bit scalars after each point */
+static void bench_scalars(byte* out, size_t stride, size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    bench_rand_bytes(out + (i * stride), 32);
+  }
+}
+
+/* Field elements below p, the top byte of p is 0x1a */
+static void bench_fps(byte* out, size_t num) {
+  for (size_t i = 0; i < num; ++i) {
+    memset(out + (i * 64), 0, 16);
+    bench_rand_bytes(out + (i * 64) + 16, 48);
+    out[(i * 64) + 16] &= 0x0f;
+  }
+}
+
+/* A point on the G2 curve outside the subgroup, x = (c, 1) for the first c
+   with x^3 + 4(1 + i) a square, the cofactor makes G2 membership unlikely */
+static void bench_g2_not_in_subgroup(byte out[256]) {
+  uint64_t       four[6] = { 4, 0, 0, 0, 0, 0 };
+  uint64_t       one[6]  = { 1, 0, 0, 0, 0, 0 };
+  blst_fp2       b, rhs;
+  blst_p2_affine p;
+
+  blst_fp_from_uint64(&(b.fp[0]), four);
+  b.fp[1] = b.fp[0];
+  blst_fp_from_uint64(&(p.x.fp[1]), one);
+
+  for (uint64_t c = 1; ; ++c) {
+    uint64_t c0[6] = { c, 0, 0, 0, 0, 0 };
+    blst_fp_from_uint64(&(p.x.fp[0]), c0);
+
+    blst_fp2_sqr(&rhs, &(p.x));
+    blst_fp2_mul(&rhs, &rhs, &(p.x));
+    blst_fp2_add(&rhs, &rhs, &b);
+
+    if (blst_fp2_sqrt(&(p.y), &rhs) && blst_p2_affine_on_curve(&p) &&
+        !blst_p2_affine_in_g2(&p)) {
+      break;
+    }
+  }
+
+  bench_fp_to_bytes(out, &(p.x.fp[0]));
+  bench_fp_to_bytes(out + 64, &(p.x.fp[1]));
+  bench_fp_to_bytes(out + 128, &(p.y.fp[0]));
+  bench_fp_to_bytes(out + 192, &(p.y.fp[1]));
+}
+
+/* Entry points under a common signature */
+typedef EIP2537_ERROR (*bench_fn)(byte* out, byte* in, size_t in_len);
+
+#define BENCH_WRAP(name)                                 \
+  static EIP2537_ERROR bench_##name(byte* out, byte* in, \
+                                     size_t in_len) {    \
+    return bls12_##name(out, in, in_len);                \
+  }
+
+BENCH_WRAP(g1add)
+BENCH_WRAP(g1mul)
+BENCH_WRAP(g1mul_glv)
+BENCH_WRAP(g1multiexp)
+BENCH_WRAP(g1multiexp_naive)
+BENCH_WRAP(g1multiexp_bc)
+BENCH_WRAP(g1multiexp_straus)
+BENCH_WRAP(g1multiexp_pippenger)
+BENCH_WRAP(g2add)
+BENCH_WRAP(g2mul)
+BENCH_WRAP(g2mul_gls)
+BENCH_WRAP(g2multiexp)
+BENCH_WRAP(g2multiexp_naive)
+BENCH_WRAP(g2multiexp_bc)
+BENCH_WRAP(g2multiexp_straus)
+BENCH_WRAP(g2multiexp_pippenger)
+BENCH_WRAP(pairing)
+BENCH_WRAP(map_fp_to_g1)
+BENCH_WRAP(map_fp2_to_g2)
+
+typedef enum {
+  BENCH_G1ADD = 0,
+  BENCH_G1MUL,
+  BENCH_G1MULTIEXP,
+  BENCH_G2ADD,
+  BENCH_G2MUL,
+  BENCH_G2MULTIEXP,
+  BENCH_PAIRING,
+  BENCH_MAP_G1,
+  BENCH_MAP_G2,
+} bench_kind;
+
+/* Input cases, worst cases only apply to some kinds */
+typedef enum {
+  BENCH_RANDOM = 0,
+  BENCH_DOUBLE,             /* ADD of a point to itself                  */
+  BENCH_MAX_SCALAR,         /* MUL and MULTIEXP scalars of all ones      */
+  BENCH_INFINITY,           /* MULTIEXP padded with points at infinity   */
+  BENCH_SAME_POINT,         /* MULTIEXP of one repeated point            */
+  BENCH_BC_GAP,             /* MULTIEXP scalars 6 bits apart, longest
+                               Bos-Coster subtraction chains             */
+  BENCH_LAST_NOT_IN_GROUP,  /* PAIRING failing the subgroup check last   */
+  BENCH_FP_MAX,             /* MAP of p - 1                              */
+  BENCH_NUM_CASES
+} bench_case;
+
+static const char* bench_case_names[BENCH_NUM_CASES] = {
+  "random", "double", "max_scalar", "infinity", "same_point", "bc_gap",
+  "last_not_in_subgroup", "fp_max"
+};
+
+typedef struct {
+  const char* name;
+  bench_fn    fn;
+  bench_kind  kind;
+  size_t      max_pairs;  /* sizes 1, 2, 4, ... up to this, 1 if fixed */
+} bench_entry;
+
+static const bench_entry bench_entries[] = {
+  {"g1add",                bench_g1add,                BENCH_G1ADD,         1},
+  {"g1mul",                bench_g1mul,                BENCH_G1MUL,         1},
+  {"g1mul_glv",            bench_g1mul_glv,            BENCH_G1MUL,         1},
+  {"g1multiexp",           bench_g1multiexp,           BENCH_G1MULTIEXP, 4096},
+  {"g1multiexp_naive",     bench_g1multiexp_naive,     BENCH_G1MULTIEXP,  256},
+  {"g1multiexp_bc",        bench_g1multiexp_bc,        BENCH_G1MULTIEXP, 1024},
+  {"g1multiexp_straus",    bench_g1multiexp_straus,    BENCH_G1MULTIEXP,  256},
+  {"g1multiexp_pippenger", bench_g1multiexp_pippenger, BENCH_G1MULTIEXP, 4096},
+  {"g2add",                bench_g2add,                BENCH_G2ADD,         1},
+  {"g2mul",                bench_g2mul,                BENCH_G2MUL,         1},
+  {"g2mul_gls",            bench_g2mul_gls,            BENCH_G2MUL,         1},
+  {"g2multiexp",           bench_g2multiexp,           BENCH_G2MULTIEXP, 4096},
+  {"g2multiexp_naive",     bench_g2multiexp_naive,     BENCH_G2MULTIEXP,  256},
+  {"g2multiexp_bc",        bench_g2multiexp_bc,        BENCH_G2MULTIEXP, 1024},
+  {"g2multiexp_straus",    bench_g2multiexp_straus,    BENCH_G2MULTIEXP,  256},
+  {"g2multiexp_pippenger", bench_g2multiexp_pippenger, BENCH_G2MULTIEXP, 4096},
+  {"pairing",              bench_pairing,              BENCH_PAIRING,      64},
+  {"map_fp_to_g1",         bench_map_fp_to_g1,         BENCH_MAP_G1,        1},
+  {"map_fp2_to_g2",        bench_map_fp2_to_g2,        BENCH_MAP_G2,        1},
+};
+
+/* Generated inputs shared by all rows */
+typedef struct {
+  byte* g1_pairs;       /* BENCH_MAX_PAIRS of G1 point || scalar         */
+  byte* g2_pairs;       /* BENCH_MAX_PAIRS of G2 point || scalar         */
+  byte* pairing_pairs;  /* BENCH_MAX_PAIRING_PAIRS of G1 || G2 point     */
+  byte* worst;          /* worst case input built for each row           */
+  byte  g1_add[256];
+  byte  g2_add[512];
+  byte  fps[128];
+  byte  g2_not_in_group[256];
+} bench_inputs;
+
+static int bench_inputs_init(bench_inputs* in) {
+  in->g1_pairs      = (byte*) malloc(BENCH_MAX_PAIRS * 160);
+  in->g2_pairs      = (byte*) malloc(BENCH_MAX_PAIRS * 288);
+  in->pairing_pairs = (byte*) malloc(BENCH_MAX_PAIRING_PAIRS * 384);
+  in->worst         = (byte*) malloc(BENCH_MAX_PAIRS * 288);
+  if ((in->g1_pairs == NULL) || (in->g2_pairs == NULL) ||
+      (in->pairing_pairs == NULL) || (in->worst == NULL)) {
+    return 0;
+  }
+
+  bench_g1_points(in->g1_pairs, 160, BENCH_MAX_PAIRS);
+  bench_scalars(in->g1_pairs + 128, 160, BENCH_MAX_PAIRS);
+  bench_g2_points(in->g2_pairs, 288, BENCH_MAX_PAIRS);
+  bench_scalars(in->g2_pairs + 256, 288, BENCH_MAX_PAIRS);
+  bench_g1_points(in->pairing_pairs, 384, BENCH_MAX_PAIRING_PAIRS);
+  bench_g2_points(in->pairing_pairs + 128, 384, BENCH_MAX_PAIRING_PAIRS);
+
+  bench_g1_points(in->g1_add, 128, 2);
+  bench_g2_points(in->g2_add, 256, 2);
+  bench_fps(in->fps, 2);
+  bench_g2_not_in_subgroup(in->g2_not_in_group);
+
+  return 1;
+}
+
+static void bench_inputs_free(bench_inputs* in) {
+  free(in->g1_pairs);
+  free(in->g2_pairs);
+  free(in->pairing_pairs);
+  free(in->worst);
+}
+
+/* Copy num pairs of random points and scalars, the points replaced by the
+   first one or by infinity and the scalars by a given case */
+static void bench_msm_input(byte* out, const byte* pairs, size_t pair_len,
+                            size_t num, bench_case c) {
+  size_t point_len = pair_len - 32;
+
+  memcpy(out, pairs, num * pair_len);
+
+  for (size_t i = 0; i < num; ++i) {
+    byte* point  = out + (i * pair_len);
+    byte* scalar = point + point_len;
+
+    if (c == BENCH_INFINITY) {
+      memset(point, 0, point_len);
+    }
+    else if (c == BENCH_SAME_POINT) {
+      memcpy(point, pairs, point_len);
+    }
+    else if (c == BENCH_MAX_SCALAR) {
+      memset(scalar, 0xff, 32);
+    }
+    else if (c == BENCH_BC_GAP) {
+      /* All ones shifted right by 6 bits per step, 42 steps per ladder */
+      size_t shift = 6 * (i % 42);
+      memset(scalar, 0, shift / 8);
+      scalar[shift / 8] = (byte)(0xff >> (shift % 8));
+      memset(scalar + (shift / 8) + 1, 0xff, 31 - (shift / 8));
+    }
+  }
+}
+
+/* p - 1 in a 64 byte encoding */
+static void bench_fp_max(byte out[64]) {
+  static const byte p_minus_1[48] = {
+    0x1a, 0x01, 0x11, 0xea, 0x39, 0x7f, 0xe6, 0x9a, 0x4b, 0x1b, 0xa7, 0xb6,
+    0x43, 0x4b, 0xac, 0xd7, 0x64, 0x77, 0x4b, 0x84, 0xf3, 0x85, 0x12, 0xbf,
+    0x67, 0x30, 0xd2, 0xa0, 0xf6, 0xb0, 0xf6, 0x24, 0x1e, 0xab, 0xff, 0xfe,
+    0xb1, 0x53, 0xff, 0xff, 0xb9, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xaa, 0xaa
+  };
+
+  memset(out, 0, 16);
+  memcpy(out + 16, p_minus_1, 48);
+}
+
+/* Input, gas and expected status of a row, NULL if the case does not apply
+   to the kind */
+static byte* bench_input(bench_inputs* in, bench_kind kind, bench_case c,
+                         size_t pairs, size_t* in_len, uint64_t* gas,
+                         EIP2537_ERROR* expected) {
+  *expected = EIP2537_SUCCESS;
+
+  switch (kind) {
+    case BENCH_G1ADD:
+    case BENCH_G2ADD: {
+      size_t point_len = (kind == BENCH_G1ADD) ? 128 : 256;
+      byte*  add       = (kind == BENCH_G1ADD) ? in->g1_add : in->g2_add;
+      *in_len = 2 * point_len;
+      *gas    = (kind == BENCH_G1ADD) ? bls12_g1add_gas() : bls12_g2add_gas();
+      if (c == BENCH_RANDOM) {
+        return add;
+      }
+      if (c != BENCH_DOUBLE) {
+        return NULL;
+      }
+      memcpy(in->worst, add, point_len);
+      memcpy(in->worst + point_len, add, point_len);
+      return in->worst;
+    }
+    case BENCH_G1MUL:
+    case BENCH_G2MUL: {
+      size_t pair_len = (kind == BENCH_G1MUL) ? 160 : 288;
+      byte*  mul      = (kind == BENCH_G1MUL) ? in->g1_pairs : in->g2_pairs;
+      *in_len = pair_len;
+      *gas    = (kind == BENCH_G1MUL) ? bls12_g1mul_gas() : bls12_g2mul_gas();
+      if (c == BENCH_RANDOM) {
+        return mul;
+      }
+      if (c != BENCH_MAX_SCALAR) {
+        return NULL;
+      }
+      bench_msm_input(in->worst, mul, pair_len, 1, c);
+      return in->worst;
+    }
+    case BENCH_G1MULTIEXP:
+    case BENCH_G2MULTIEXP: {
+      size_t pair_len = (kind == BENCH_G1MULTIEXP) ? 160 : 288;
+      byte*  msm = (kind == BENCH_G1MULTIEXP) ? in->g1_pairs : in->g2_pairs;
+      *in_len = pairs * pair_len;
+      *gas    = (kind == BENCH_G1MULTIEXP) ? bls12_g1multiexp_gas(*in_len) :
+                                             bls12_g2multiexp_gas(*in_len);
+      if (c == BENCH_RANDOM) {
+        return msm;
+      }
+      if ((c != BENCH_MAX_SCALAR) && (c != BENCH_INFINITY) &&
+          (c != BENCH_SAME_POINT) && (c != BENCH_BC_GAP)) {
+        return NULL;
+      }
+      bench_msm_input(in->worst, msm, pair_len, pairs, c);
+      return in->worst;
+    }
+    case BENCH_PAIRING:
+      *in_len = pairs * 384;
+      *gas    = bls12_pairing_gas(*in_len);
+      if (c == BENCH_RANDOM) {
+        return in->pairing_pairs;
+      }
+      if (c != BENCH_LAST_NOT_IN_GROUP) {
+        return NULL;
+      }
+      memcpy(in->worst, in->pairing_pairs, *in_len);
+      memcpy(in->worst + *in_len - 256, in->g2_not_in_group, 256);
+      *expected = EIP2537_POINT_NOT_IN_SUBGROUP;
+      return in->worst;
+    default:
+      *in_len = (kind == BENCH_MAP_G1) ? 64 : 128;
+      *gas    = (kind == BENCH_MAP_G1) ? bls12_map_fp_to_g1_gas() :
+                                         bls12_map_fp2_to_g2_gas();
+      if (c == BENCH_RANDOM) {
+        return in->fps;
+      }
+      if (c != BENCH_FP_MAX) {
+        return NULL;
+      }
+      bench_fp_max(in->worst);
+      bench_fp_max(in->worst + 64);
+      return in->worst;
+  }
+}
+
+static uint64_t bench_now_ns() {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t bench_cycles() {
+#ifdef BENCH_HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+int main(int argc, char** argv) {
+  int      json   = (argc > 1) && (strcmp(argv[1], "json") == 0);
+  uint64_t min_ns = 200ULL * 1000000ULL;
+  if (argc > 2) {
+    min_ns = strtoull(argv[2], NULL, 10) * 1000000ULL;
+  }
+
+  bench_inputs in;
+  if (!bench_inputs_init(&in)) {
+    printf("ERROR allocating inputs\n");
+    bench_inputs_free(&in);
+    return -1;
+  }
+
+  if (!json) {
+    printf("name,case,pairs,in_len,iterations,ns_per_op,cycles_per_op,gas,"
+           "mgas_per_s\n");
+  }
+
+  byte out[256];
+  for (size_t e = 0; e < (sizeof(bench_entries) / sizeof(bench_entry));
+       ++e) {
+    const bench_entry* entry = &(bench_entries[e]);
+
+    for (size_t pairs = 1; pairs <= entry->max_pairs; pairs <<= 1) {
+      for (int c = BENCH_RANDOM; c < BENCH_NUM_CASES; ++c) {
+        size_t        in_len;
+        uint64_t      gas;
+        EIP2537_ERROR expected;
+        byte*         input = bench_input(&in, entry->kind, (bench_case)c,
+                                          pairs, &in_len, &gas, &expected);
+        if (input == NULL) {
+          continue;
+        }
+
+        /* Warm up caches, thread pools and lazily built tables */
+        EIP2537_ERROR err;
+        uint64_t start = bench_now_ns();
+        do {
+          err = entry->fn(out, input, in_len);
+        } while ((err == expected) &&
+                 ((bench_now_ns() - start) < (min_ns / 10)));
+
+        if (err != expected) {
+          printf("ERROR %s %s with %zu pairs - %d\n", entry->name,
+                 bench_case_names[c], pairs, err);
+          bench_inputs_free(&in);
+          return -1;
+        }
+
+        uint64_t iterations = 0;
+        uint64_t elapsed;
+        uint64_t cycles = bench_cycles();
+        start = bench_now_ns();
+        do {
+          entry->fn(out, input, in_len);
+          ++iterations;
+          elapsed = bench_now_ns() - start;
+        } while (elapsed < min_ns);
+        cycles = bench_cycles() - cycles;
+
+        double ns_per_op     = (double)elapsed / (double)iterations;
+        double cycles_per_op = (double)cycles / (double)iterations;
+        double mgas_per_s    = ((double)gas * 1000.0) / ns_per_op;
+
+        if (json) {
+          printf("{\"name\":\"%s\",\"case\":\"%s\",\"pairs\":%zu,"
+                 "\"in_len\":%zu,\"iterations\":%llu,\"ns_per_op\":%.1f,"
+                 "\"cycles_per_op\":%.1f,\"gas\":%llu,"
+                 "\"mgas_per_s\":%.2f}\n",
+                 entry->name, bench_case_names[c], pairs, in_len,
+                 (unsigned long long)iterations, ns_per_op, cycles_per_op,
+                 (unsigned long long)gas, mgas_per_s);
+        }
+        else {
+          printf("%s,%s,%zu,%zu,%llu,%.1f,%.1f,%llu,%.2f\n", entry->name,
+                 bench_case_names[c], pairs, in_len,
+                 (unsigned long long)iterations, ns_per_op, cycles_per_op,
+                 (unsigned long long)gas, mgas_per_s);
+        }
+        fflush(stdout);
+      }
+    }
+  }
+
+  bench_inputs_free(&in);
+
+  return 0;
+}
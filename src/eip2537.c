@@ -10,8 +10,25 @@
 #include "eip2537.h"
 #include <math.h>
 #include <string.h>
-
-#include <immintrin.h> /* TODO - make platform independent */
+#include <time.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+# include <immintrin.h>
+#elif defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+#if !defined(_WIN32) && !defined(__EIP2537_NO_THREADS__)
+# define EIP2537_THREADS
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+# define BLS12_THREAD_LOCAL __declspec(thread)
+#else
+# define BLS12_THREAD_LOCAL __thread
+#endif
 
 /* Utility debug print functions */
 #include <stdio.h>
@@ -54,45 +71,285 @@ void print_blst_p1_affine(const blst_p1_affine* p_aff, const char* name) {
 }
 
 
+/* Threading configuration */
+
+/* Relaxed atomics for counters shared between threads */
+#ifdef EIP2537_THREADS
+# define BLS12_ATOMIC_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+# define BLS12_ATOMIC_LOAD(p)   __atomic_load_n((p), __ATOMIC_RELAXED)
+# define BLS12_ATOMIC_STORE(p, v) \
+           __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+# define BLS12_ATOMIC_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+# define BLS12_ATOMIC_STORE_RELEASE(p, v) \
+           __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+# define BLS12_ATOMIC_SUB_ACQ_REL(p, v) \
+           __atomic_sub_fetch((p), (v), __ATOMIC_ACQ_REL)
+# define BLS12_ATOMIC_CAS_ACQUIRE(p, e, v) \
+           __atomic_compare_exchange_n((p), (e), (v), 0, __ATOMIC_ACQUIRE, \
+                                       __ATOMIC_RELAXED)
+# define BLS12_ATOMIC_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+# define BLS12_ATOMIC_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+# define BLS12_ATOMIC_ADD(p, v)           (*(p) += (v))
+# define BLS12_ATOMIC_LOAD(p)             (*(p))
+# define BLS12_ATOMIC_STORE(p, v)         (*(p) = (v))
+# define BLS12_ATOMIC_LOAD_ACQUIRE(p)     (*(p))
+# define BLS12_ATOMIC_STORE_RELEASE(p, v) (*(p) = (v))
+# define BLS12_ATOMIC_SUB_ACQ_REL(p, v)   (*(p) -= (v))
+# define BLS12_ATOMIC_CAS_ACQUIRE(p, e, v) \
+           ((*(p) == *(e)) ? ((*(p) = (v)), 1) : ((*(e) = *(p)), 0))
+# define BLS12_ATOMIC_FENCE_ACQUIRE()
+# define BLS12_ATOMIC_FENCE_RELEASE()
+#endif
+
+/* Number of threads used by parallel paths, 0 means all online cores */
+static size_t bls12_num_threads = 0;
+
+/* Override for calls made from this thread, 0 defers to the global count */
+static BLS12_THREAD_LOCAL size_t bls12_thread_num_threads = 0;
+
+/* Minimum number of pairs before pairing is split across threads */
+static size_t bls12_pairing_parallel_threshold = 8;
+
+/* Minimum number of pairs before multiexp is split across threads */
+static size_t bls12_multiexp_parallel_threshold = 32;
+
+/* Knobs may change while other threads run precompiles, so they are only
+   accessed atomically */
+void bls12_set_num_threads(size_t num_threads) {
+  BLS12_ATOMIC_STORE(&bls12_num_threads, num_threads);
+}
+
+size_t bls12_set_thread_num_threads(size_t num_threads) {
+  size_t prev = bls12_thread_num_threads;
+  bls12_thread_num_threads = num_threads;
+  return prev;
+}
+
+void bls12_pairing_set_parallel_threshold(size_t min_pairs) {
+  BLS12_ATOMIC_STORE(&bls12_pairing_parallel_threshold, min_pairs);
+}
+
+void bls12_multiexp_set_parallel_threshold(size_t min_pairs) {
+  BLS12_ATOMIC_STORE(&bls12_multiexp_parallel_threshold, min_pairs);
+}
+
+/* Resolve configured thread count, always at least 1 */
+static size_t bls12_get_num_threads() {
+#ifdef EIP2537_THREADS
+  if (bls12_thread_num_threads != 0) {
+    return bls12_thread_num_threads;
+  }
+
+  size_t num_threads = BLS12_ATOMIC_LOAD(&bls12_num_threads);
+  if (num_threads == 0) {
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (num_cores > 0) ? (size_t)num_cores : 1;
+  }
+  return num_threads;
+#else
+  return 1;
+#endif
+}
+
+#define BLS12_STACK_TASKS 64
+
+/* Run worker on args[t] for t < num_tasks, task 0 on the calling thread and
+   any task whose thread fails to start inline, returns 0 on memory error */
+static int bls12_run_tasks(void* (*worker)(void*), void* args,
+                           size_t arg_size, size_t num_tasks) {
+  byte* arg = (byte*)args;
+
+#ifdef EIP2537_THREADS
+  if (num_tasks > 1) {
+    /* Thread handles on the stack unless there are many tasks */
+    pthread_t  stack_threads[BLS12_STACK_TASKS];
+    byte       stack_started[BLS12_STACK_TASKS];
+    pthread_t* threads = stack_threads;
+    byte*      started = stack_started;
+    if (num_tasks > BLS12_STACK_TASKS) {
+      threads = (pthread_t*) malloc(num_tasks * sizeof(pthread_t));
+      started = (byte*) malloc(num_tasks);
+      if ((threads == NULL) || (started == NULL)) {
+        free(threads);
+        free(started);
+        return 0;
+      }
+    }
+
+    for (size_t t = 1; t < num_tasks; ++t) {
+      started[t] = (pthread_create(&(threads[t]), NULL, worker,
+                                   arg + (t * arg_size)) == 0);
+    }
+
+    worker(arg);
+
+    for (size_t t = 1; t < num_tasks; ++t) {
+      if (started[t]) {
+        pthread_join(threads[t], NULL);
+      }
+      else {
+        worker(arg + (t * arg_size));
+      }
+    }
+
+    if (threads != stack_threads) {
+      free(threads);
+      free(started);
+    }
+    return 1;
+  }
+#endif
+
+  for (size_t t = 0; t < num_tasks; ++t) {
+    worker(arg + (t * arg_size));
+  }
+  return 1;
+}
+
+
+/* Scratch memory for the MSM paths, either caller owned or taken from a
+   thread local arena that is reused across calls while it is under the
+   configured limit. Calls beyond the limit, or with the arena off, use the
+   heap for that call only */
+#define BLS12_SCRATCH_ALIGN 64
+
+static size_t                    bls12_scratch_arena_limit = 0;
+static BLS12_THREAD_LOCAL byte*  bls12_scratch_arena       = NULL;
+static BLS12_THREAD_LOCAL size_t bls12_scratch_arena_size  = 0;
+
+void bls12_scratch_arena_configure(size_t max_bytes) {
+  BLS12_ATOMIC_STORE(&bls12_scratch_arena_limit, max_bytes);
+}
+
+void bls12_scratch_arena_release() {
+  free(bls12_scratch_arena);
+  bls12_scratch_arena      = NULL;
+  bls12_scratch_arena_size = 0;
+}
+
+/* Bytes a caller needs to provide for size bytes at any alignment */
+static size_t bls12_scratch_padded(size_t size) {
+  return size + BLS12_SCRATCH_ALIGN - 1;
+}
+
+/* Align scratch up, NULL if it does not hold size bytes once aligned */
+static byte* bls12_scratch_align(void* scratch, size_t scratch_len,
+                                 size_t size) {
+  if (scratch == NULL) {
+    return NULL;
+  }
+
+  size_t pad = (BLS12_SCRATCH_ALIGN -
+                ((uintptr_t)scratch % BLS12_SCRATCH_ALIGN)) %
+               BLS12_SCRATCH_ALIGN;
+  if ((scratch_len < pad) || ((scratch_len - pad) < size)) {
+    return NULL;
+  }
+
+  return (byte*)scratch + pad;
+}
+
+/* size bytes of aligned scratch, from the caller when scratch is given and
+   from the arena or heap otherwise. *owned must be freed after the call */
+static byte* bls12_scratch_get(void* scratch, size_t scratch_len,
+                               size_t size, byte** owned) {
+  *owned = NULL;
+
+  if (scratch != NULL) {
+    return bls12_scratch_align(scratch, scratch_len, size);
+  }
+
+  size_t len = bls12_scratch_padded(size);
+  if (len <= BLS12_ATOMIC_LOAD(&bls12_scratch_arena_limit)) {
+    if (bls12_scratch_arena_size < len) {
+      free(bls12_scratch_arena);
+      bls12_scratch_arena      = (byte*) malloc(len);
+      bls12_scratch_arena_size = (bls12_scratch_arena == NULL) ? 0 : len;
+    }
+    return bls12_scratch_align(bls12_scratch_arena, bls12_scratch_arena_size,
+                               size);
+  }
+
+  *owned = (byte*) malloc(len);
+  return bls12_scratch_align(*owned, len, size);
+}
+
 /* Heap functions used in Bos-Coster mutliscalar multiplication operations */
 
-/* Scalar comparison: Return 1 if a < b, 0 otherwise */
-/* TODO - make platform independent */
-static inline int compare_scalars(const blst_scalar* a, const blst_scalar* b) {
+/* out = a - b over four 64 bit limbs, returns the borrow. x86_64 chains
+   sbb through the intrinsic, aarch64 through subs/sbcs and anything else
+   computes each borrow in C */
+static inline int scalar_limbs_sub(uint64_t out[4], const uint64_t a[4],
+                                   const uint64_t b[4]) {
+#if defined(__x86_64__) || defined(_M_X64)
   unsigned char c = 0;
-  long long unsigned int out;
 
-  c = _subborrow_u64(c, *((uint64_t*)a->b), *((uint64_t*)b->b), &out);
-  c = _subborrow_u64(c, *(((uint64_t*)a->b)+1), *(((uint64_t*)b->b)+1), &out);
-  c = _subborrow_u64(c, *(((uint64_t*)a->b)+2), *(((uint64_t*)b->b)+2), &out);
-  c = _subborrow_u64(c, *(((uint64_t*)a->b)+3), *(((uint64_t*)b->b)+3), &out);
+  c = _subborrow_u64(c, a[0], b[0], (long long unsigned int*)&(out[0]));
+  c = _subborrow_u64(c, a[1], b[1], (long long unsigned int*)&(out[1]));
+  c = _subborrow_u64(c, a[2], b[2], (long long unsigned int*)&(out[2]));
+  c = _subborrow_u64(c, a[3], b[3], (long long unsigned int*)&(out[3]));
 
   return (c & 0x1);
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3];
+  uint64_t borrow;
+
+  /* Carry clear after the chain means a borrow out of the top limb */
+  __asm__("subs %0, %0, %5\n\t"
+          "sbcs %1, %1, %6\n\t"
+          "sbcs %2, %2, %7\n\t"
+          "sbcs %3, %3, %8\n\t"
+          "cset %4, lo"
+          : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3), "=r"(borrow)
+          : "r"(b[0]), "r"(b[1]), "r"(b[2]), "r"(b[3])
+          : "cc");
+
+  out[0] = r0;
+  out[1] = r1;
+  out[2] = r2;
+  out[3] = r3;
+
+  return (int)borrow;
+#else
+  uint64_t borrow = 0;
+
+  for (size_t i = 0; i < 4; i++) {
+    uint64_t t = a[i] - b[i];
+    uint64_t next_borrow = (a[i] < b[i]) | (t < borrow);
+    out[i] = t - borrow;
+    borrow = next_borrow;
+  }
+
+  return (int)borrow;
+#endif
 }
 
-/* Scalar subtraction: a = a - b */
-/* TODO - make platform independent */
-static inline int blst_scalar_sub_assign(blst_scalar* a, const blst_scalar* b) {
-  unsigned char c = 0;
+/* Scalar comparison: Return 1 if a < b, 0 otherwise */
+static inline int compare_scalars(const blst_scalar* a, const blst_scalar* b) {
+  uint64_t out[4];
 
-  c = _subborrow_u64(c, *((uint64_t*)a->b), *((uint64_t*)b->b),
-                     ((long long unsigned int*)a->b));
-  c = _subborrow_u64(c, *(((uint64_t*)a->b)+1), *(((uint64_t*)b->b)+1),
-                     ((long long unsigned int*)a->b) + 1);
-  c = _subborrow_u64(c, *(((uint64_t*)a->b)+2), *(((uint64_t*)b->b)+2),
-                     ((long long unsigned int*)a->b) + 2);
-  c = _subborrow_u64(c, *(((uint64_t*)a->b)+3), *(((uint64_t*)b->b)+3),
-                     ((long long unsigned int*)a->b) + 3);
+  return scalar_limbs_sub(out, (const uint64_t*)a->b, (const uint64_t*)b->b);
+}
 
-  return (c & 0x1);
+/* Scalar subtraction: a = a - b */
+static inline int blst_scalar_sub_assign(blst_scalar* a, const blst_scalar* b) {
+  return scalar_limbs_sub((uint64_t*)a->b, (const uint64_t*)a->b,
+                          (const uint64_t*)b->b);
 }
 
 /* Find MSB in scalar and return number of bits */
-/* TODO - make platform independent */
 static inline int blst_scalar_num_bits(const blst_scalar* a) {
   for (int i = 3; i >= 0; i--) {
-    if (*(((uint64_t*)a->b) + i) != 0) {
-      return (64 * (i + 1)) - __builtin_clzll(*(((uint64_t*)a->b) + i));
+    uint64_t limb = *(((uint64_t*)a->b) + i);
+    if (limb != 0) {
+#if defined(_MSC_VER) && !defined(__clang__)
+      unsigned long msb;
+      _BitScanReverse64(&msb, limb);
+      return (64 * i) + (int)msb + 1;
+#else
+      return (64 * (i + 1)) - __builtin_clzll(limb);
+#endif
     }
   }
   return 0;
@@ -259,764 +516,4609 @@ static int blst_scalars_max_heapreplace_p2(blst_p2* skipped_result,
 }
 
 
-/* Extract encoded field element byte array into blst_fp object */
-static int fp_from_bytes(blst_fp* fp, const byte* in) {
-  /* Ensure first 16 bytes of field element are zero */
-  byte acc_pad = 0;
+/* Helper functions used in Pippenger multiscalar multiplication operations */
 
-  for (size_t i = 0; i < 16; ++i) {
-    acc_pad |= *in++;
-  }
+/* Choose window size in bits based on number of point/scalar pairs */
+static size_t pippenger_window_size(size_t num_pairs) {
+  size_t log2_pairs = 0;
 
-  if (acc_pad != 0) {
-    return -1;
+  while (num_pairs >>= 1) {
+    log2_pairs++;
   }
 
-  /* Next 48 bytes are field element in big endian form */
-  limb_t limb = 0;
-  size_t n = 48;
-
-  while(n--) {
-    limb <<= 8;
-    limb |= *in++;
-    fp->l[n / sizeof(limb_t)] = limb;
+  /* Balance the n bucket additions per window against the 2^(w-1) buckets */
+  if (log2_pairs > 12) {
+    return log2_pairs - 3;
+  }
+  if (log2_pairs > 4) {
+    return log2_pairs - 2;
   }
+  return 2;
+}
 
-  /* Check field element is less than modulus (also check if it's zero) */
-  blst_fp zero = { 0 };
-  blst_fp_add(&zero, fp, &zero);
+/* Extract window + 1 bits of a little endian scalar starting at bit
+   offset - 1, the lowest bit being the top bit of the previous window */
+static uint32_t booth_get_wval(const byte* k, size_t offset, size_t window) {
+  size_t   bit = (offset == 0) ? 0 : (offset - 1);
+  size_t   idx = bit / 8;
+  uint64_t acc = 0;
 
-  limb_t acc_mod  = 0;
-  limb_t acc_zero = 0;
-  for (size_t i = 0; i < (48 / sizeof(limb_t)); ++i) {
-    acc_mod  |= zero.l[i] ^ fp->l[i];
-    acc_zero |= zero.l[i];
+  /* Window is at most 16 bits so 4 bytes always cover it */
+  for (size_t i = 0; (i < 4) && ((idx + i) < 32); ++i) {
+    acc |= ((uint64_t)k[idx + i]) << (8 * i);
   }
 
-  if (acc_mod != 0) {
-    return -1;
+  acc >>= (bit % 8);
+  if (offset == 0) {
+    acc <<= 1;
   }
 
-  /* Convert field element to Montgomery form */
-  blst_fp_to(fp, fp);
+  return (uint32_t)(acc & ((1 << (window + 1)) - 1));
+}
 
-  /* Return if field element is zero or not */
-  if (acc_zero == 0) {
-    return 0;
+/* Booth recode window value into a signed digit in [-2^(w-1), 2^(w-1)] */
+static int32_t booth_encode(uint32_t wval, size_t window) {
+  int32_t digit = (int32_t)((wval + 1) >> 1);
+
+  return digit - (int32_t)(((wval >> window) & 1) << window);
+}
+
+/* Compute a single window of G1 bucket method, ret = sum (j * bucket_j) */
+static void blst_p1s_pippenger_window(blst_p1* ret, blst_p1* buckets,
+                                      const blst_p1_affine* bases,
+                                      const blst_scalar* scalars,
+                                      size_t num_pairs, size_t offset,
+                                      size_t window) {
+  size_t num_buckets = (size_t)1 << (window - 1);
+
+  memset(buckets, 0, num_buckets * sizeof(blst_p1)); /* Infinity */
+
+  /* Accumulate each base into the bucket of its signed digit */
+  for (size_t i = 0; i < num_pairs; ++i) {
+    int32_t digit = booth_encode(booth_get_wval(scalars[i].b, offset, window),
+                                 window);
+
+    if (digit > 0) {
+      blst_p1_add_or_double_affine(&(buckets[digit - 1]),
+                                   &(buckets[digit - 1]), &(bases[i]));
+    }
+    else if (digit < 0) {
+      blst_p1_affine neg_base = bases[i];
+      blst_fp_cneg(&(neg_base.y), &(neg_base.y), 1);
+      blst_p1_add_or_double_affine(&(buckets[-digit - 1]),
+                                   &(buckets[-digit - 1]), &neg_base);
+    }
   }
 
-  return 1;
+  /* Running sum from the top bucket down weights bucket j by j */
+  blst_p1 running = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+  memset(ret, 0, sizeof(blst_p1));           /* Infinity */
+
+  for (size_t j = num_buckets; j-- > 0;) {
+    blst_p1_add_or_double(&running, &running, &(buckets[j]));
+    blst_p1_add_or_double(ret, ret, &running);
+  }
 }
 
-/* Encode blst_fp object into byte array */
-static void fp_to_bytes(byte* out, const blst_fp* fp) {
-  for (size_t i = 0; i < 16; ++i) {
-    out[i] = 0;
+/* Split each window into chunks of points so every thread has work, picking
+   the chunk count with the shortest estimated critical path, where a task
+   costs one bucket addition per point plus two per bucket to reduce */
+static size_t pippenger_num_chunks(size_t num_pairs, size_t window,
+                                   size_t num_windows, size_t num_threads) {
+  size_t best_chunks = 1;
+  size_t best_cost   = SIZE_MAX;
+
+  for (size_t c = 1; (c <= num_threads) && (c <= num_pairs); ++c) {
+    size_t rounds = ((num_windows * c) + num_threads - 1) / num_threads;
+    size_t cost   = rounds * (((num_pairs + c - 1) / c) +
+                              ((size_t)1 << window));
+
+    if (cost < best_cost) {
+      best_cost   = cost;
+      best_chunks = c;
+    }
   }
-  blst_bendian_from_fp(out + 16, fp);
+
+  return best_chunks;
 }
 
-/* Decode a G1 point from the encoded 128 byte field element array */
-static EIP2537_ERROR decode_g1_point(blst_p1_affine* out, const byte* in) {
-  /* Extract the x,y field elements from encoding */
-  int fp_x_status = fp_from_bytes(&(out->x), in);
-  int fp_y_status = fp_from_bytes(&(out->y), in + 64);
+/* Multiexp engine selection, entries in increasing max_pairs order with the
+   last one covering any larger input. Defaults send up to 64 pairs through
+   Straus and larger inputs through Pippenger, BLS12_G1_MSM_SELECTION and
+   BLS12_G2_MSM_SELECTION compile in a calibrated table instead */
+#define BLS12_MSM_MAX_SELECTIONS 16
+
+#define BLS12_MSM_DEFAULT_SELECTION \
+  { { 64, BLS12_MSM_STRAUS }, { SIZE_MAX, BLS12_MSM_PIPPENGER } }
+
+#ifndef BLS12_G1_MSM_SELECTION
+# define BLS12_G1_MSM_SELECTION BLS12_MSM_DEFAULT_SELECTION
+#endif
+#ifndef BLS12_G2_MSM_SELECTION
+# define BLS12_G2_MSM_SELECTION BLS12_MSM_DEFAULT_SELECTION
+#endif
+
+static const bls12_msm_selection
+  bls12_g1_msm_default[BLS12_MSM_MAX_SELECTIONS] = BLS12_G1_MSM_SELECTION;
+static const bls12_msm_selection
+  bls12_g2_msm_default[BLS12_MSM_MAX_SELECTIONS] = BLS12_G2_MSM_SELECTION;
+
+/* Live tables behind a sequence lock, odd while a writer installs entries,
+   so precompiles on other threads never select from a half written table */
+typedef struct {
+  size_t              seq;
+  bls12_msm_selection entries[BLS12_MSM_MAX_SELECTIONS];
+} bls12_msm_table;
+
+static bls12_msm_table bls12_g1_msm_selection = { 0, BLS12_G1_MSM_SELECTION };
+static bls12_msm_table bls12_g2_msm_selection = { 0, BLS12_G2_MSM_SELECTION };
+
+/* Consistent copy of the live entries, retried while a writer is active */
+static void bls12_msm_snapshot(bls12_msm_table* table,
+                               bls12_msm_selection* out) {
+  for (;;) {
+    size_t seq = BLS12_ATOMIC_LOAD_ACQUIRE(&(table->seq));
+
+    for (size_t i = 0; i < BLS12_MSM_MAX_SELECTIONS; ++i) {
+      out[i].max_pairs = BLS12_ATOMIC_LOAD(&(table->entries[i].max_pairs));
+      out[i].engine    = BLS12_ATOMIC_LOAD(&(table->entries[i].engine));
+    }
 
-  /* Ensure both field elements are valid */
-  if ((fp_x_status < 0) || (fp_y_status < 0)) {
-    return EIP2537_INVALID_ELEMENT;
+    BLS12_ATOMIC_FENCE_ACQUIRE();
+    if (((seq & 1) == 0) && (BLS12_ATOMIC_LOAD(&(table->seq)) == seq)) {
+      return;
+    }
   }
+}
 
-  /* If infinity then simply return */
-  if ((fp_x_status == 0) && (fp_y_status == 0)) {
-    return EIP2537_SUCCESS;
+/* Publish a complete table, writers take the lock by making seq odd */
+static void bls12_msm_publish(bls12_msm_table* table,
+                              const bls12_msm_selection* in) {
+  size_t seq = BLS12_ATOMIC_LOAD(&(table->seq)) & ~(size_t)1;
+  while (!BLS12_ATOMIC_CAS_ACQUIRE(&(table->seq), &seq, seq + 1)) {
+    seq &= ~(size_t)1;
   }
+  BLS12_ATOMIC_FENCE_RELEASE();
 
-  /* Check if point is on the curve */
-  if (!blst_p1_affine_on_curve(out)) {
-    return EIP2537_POINT_NOT_ON_CURVE; 
+  for (size_t i = 0; i < BLS12_MSM_MAX_SELECTIONS; ++i) {
+    BLS12_ATOMIC_STORE(&(table->entries[i].max_pairs), in[i].max_pairs);
+    BLS12_ATOMIC_STORE(&(table->entries[i].engine), in[i].engine);
   }
 
-  /* TODO - do we need a subgroup check as well? */
-
-  return EIP2537_SUCCESS;
+  BLS12_ATOMIC_STORE_RELEASE(&(table->seq), seq + 2);
 }
 
-/* Encode a G1 point into byte array from affine point representation */
-static void encode_g1_point(byte* out, const blst_p1_affine* in) {
-  /* TODO - need to check for infinity? */
-  fp_to_bytes(out, &(in->x));
-  fp_to_bytes(out + 64, &(in->y));
+/* Engine for num_pairs, the SIZE_MAX entry ends every table */
+static bls12_msm_engine bls12_msm_select(bls12_msm_table* table,
+                                         size_t num_pairs) {
+  bls12_msm_selection entries[BLS12_MSM_MAX_SELECTIONS];
+  bls12_msm_snapshot(table, entries);
+
+  size_t i = 0;
+  while ((i < (BLS12_MSM_MAX_SELECTIONS - 1)) &&
+         (entries[i].max_pairs < num_pairs)) {
+    ++i;
+  }
+  return entries[i].engine;
 }
 
+/* Install entries, NULL or none restores the default table. The new table
+   is built aside and published whole */
+static EIP2537_ERROR bls12_msm_set_selection(bls12_msm_table* table,
+                                             const bls12_msm_selection* def,
+                                             const bls12_msm_selection* in,
+                                             size_t num_entries) {
+  if ((in == NULL) || (num_entries == 0)) {
+    bls12_msm_publish(table, def);
+    return EIP2537_SUCCESS;
+  }
+
+  if (num_entries > BLS12_MSM_MAX_SELECTIONS) {
+    return EIP2537_INVALID_LENGTH;
+  }
 
+  for (size_t i = 0; i < num_entries; ++i) {
+    if ((in[i].engine < BLS12_MSM_NAIVE) ||
+        (in[i].engine > BLS12_MSM_PIPPENGER) ||
+        ((i > 0) && (in[i].max_pairs <= in[i - 1].max_pairs))) {
+      return EIP2537_INVALID_SELECTION;
+    }
+  }
 
+  bls12_msm_selection entries[BLS12_MSM_MAX_SELECTIONS];
+  memset(entries, 0, sizeof(entries));
+  memcpy(entries, in, num_entries * sizeof(*entries));
+  entries[num_entries - 1].max_pairs = SIZE_MAX;
 
+  bls12_msm_publish(table, entries);
 
+  return EIP2537_SUCCESS;
+}
 
-/* Extract encoded field element byte array into blst_fp2 object */
-static int fp2_from_bytes(blst_fp2* fp2, const byte* in) {
-  /* Extract the c0 and c1 field elements from encoding */
-  int fp_c0_status = fp_from_bytes(&(fp2->fp[0]), in);
-  int fp_c1_status = fp_from_bytes(&(fp2->fp[1]), in + 64);
+/* Copy out up to max_entries entries, returns the number in the table */
+static size_t bls12_msm_get_selection(bls12_msm_table* table,
+                                      bls12_msm_selection* out,
+                                      size_t max_entries) {
+  bls12_msm_selection entries[BLS12_MSM_MAX_SELECTIONS];
+  bls12_msm_snapshot(table, entries);
+
+  size_t num_entries = 1;
+  while ((num_entries < BLS12_MSM_MAX_SELECTIONS) &&
+         (entries[num_entries - 1].max_pairs != SIZE_MAX)) {
+    ++num_entries;
+  }
 
-  if ((fp_c0_status < 0) || (fp_c1_status < 0)) {
-    return -1;
+  for (size_t i = 0; (i < num_entries) && (i < max_entries); ++i) {
+    out[i] = entries[i];
   }
 
-  return (fp_c0_status | fp_c1_status);
+  return num_entries;
 }
 
-/* Encode blst_fp2 object into byte array */
-static void fp2_to_bytes(byte* out, const blst_fp2* fp2) {
-  for (size_t i = 0; i < 16; ++i) {
-    out[i] = 0;
-    out[i + 64] = 0;
-  }
-  blst_bendian_from_fp(out + 16, &(fp2->fp[0]));
-  blst_bendian_from_fp(out + 80, &(fp2->fp[1]));
+EIP2537_ERROR bls12_g1multiexp_set_selection(const bls12_msm_selection* table,
+                                             size_t num_entries) {
+  return bls12_msm_set_selection(&bls12_g1_msm_selection, bls12_g1_msm_default,
+                                 table, num_entries);
 }
 
-/* Decode a G2 point from the encoded 256 byte field element array */
-static EIP2537_ERROR decode_g2_point(blst_p2_affine* out, const byte* in) {
-  /* Extract the x,y field elements from encoding */
-  int fp_x_status = fp2_from_bytes(&(out->x), in);
-  int fp_y_status = fp2_from_bytes(&(out->y), in + 128);
+EIP2537_ERROR bls12_g2multiexp_set_selection(const bls12_msm_selection* table,
+                                             size_t num_entries) {
+  return bls12_msm_set_selection(&bls12_g2_msm_selection, bls12_g2_msm_default,
+                                 table, num_entries);
+}
 
-  /* Ensure both field elements are valid */
-  if ((fp_x_status < 0) || (fp_y_status < 0)) {
-    return EIP2537_INVALID_ELEMENT;
-  }
+size_t bls12_g1multiexp_get_selection(bls12_msm_selection* table,
+                                      size_t max_entries) {
+  return bls12_msm_get_selection(&bls12_g1_msm_selection, table, max_entries);
+}
 
-  /* If infinity then simply return */
-  if ((fp_x_status == 0) && (fp_y_status == 0)) {
-    return EIP2537_SUCCESS;
-  }
+size_t bls12_g2multiexp_get_selection(bls12_msm_selection* table,
+                                      size_t max_entries) {
+  return bls12_msm_get_selection(&bls12_g2_msm_selection, table, max_entries);
+}
 
-  /* Check if point is on the curve */
-  if (!blst_p2_affine_on_curve(out)) {
-    return EIP2537_POINT_NOT_ON_CURVE; 
+/* Window and task split for num_pairs, shared by scratch sizing and the MSM
+   so both agree for the current threading configuration. The MSM drops
+   threads when caller scratch was sized under a smaller plan */
+typedef struct {
+  size_t window;
+  size_t num_windows;
+  size_t num_chunks;
+  size_t num_tasks;
+  size_t num_threads;
+} pippenger_plan;
+
+static void pippenger_plan_init_threads(pippenger_plan* plan,
+                                        size_t num_pairs,
+                                        size_t num_threads) {
+  plan->window      = pippenger_window_size(num_pairs);
+  plan->num_windows = (256 / plan->window) + 1; /* Room for the Booth carry */
+  plan->num_threads = num_threads;
+
+  plan->num_chunks = pippenger_num_chunks(num_pairs, plan->window,
+                                          plan->num_windows,
+                                          plan->num_threads);
+  plan->num_tasks  = plan->num_windows * plan->num_chunks;
+  if (plan->num_threads > plan->num_tasks) {
+    plan->num_threads = plan->num_tasks;
   }
-
-  /* TODO - do we need a subgroup check as well? */
-
-  return EIP2537_SUCCESS;
 }
 
-/* Encode a G2 point into byte array from affine point representation */
-static void encode_g2_point(byte* out, const blst_p2_affine* in) {
-  /* TODO - need to check for infinity? */
-  fp2_to_bytes(out, &(in->x));
-  fp2_to_bytes(out + 128, &(in->y));
+static void pippenger_plan_init(pippenger_plan* plan, size_t num_pairs) {
+  /* Large inputs split windows and point chunks across threads */
+  size_t num_threads = 1;
+  if (num_pairs >= BLS12_ATOMIC_LOAD(&bls12_multiexp_parallel_threshold)) {
+    num_threads = bls12_get_num_threads();
+  }
+
+  pippenger_plan_init_threads(plan, num_pairs, num_threads);
 }
 
+/* Pippenger decodes its pairs in blocks claimed by whichever bucket thread
+   reaches them first, so one set of threads serves the whole call. A block
+   is only waited on while another running thread decodes it */
+#define PIPPENGER_DECODE_BLOCK 64
 
+#define PIPPENGER_BLOCK_FREE    0
+#define PIPPENGER_BLOCK_CLAIMED 1
+#define PIPPENGER_BLOCK_DECODED 2
 
+typedef EIP2537_ERROR (*pippenger_decode_fn)(void* bases,
+                                             blst_scalar* scalars,
+                                             const byte* in, size_t num);
 
-/* Decode a 32 byte scalar from the encoded 32 byte array */
-static EIP2537_ERROR decode_scalar(blst_scalar* out, const byte* in) {
-  blst_scalar_from_bendian(out, in);
-  return EIP2537_SUCCESS;
+typedef struct {
+  pippenger_decode_fn decode;
+  byte*               bases;
+  size_t              point_size;
+  blst_scalar*        scalars;
+  const byte*         in;
+  size_t              pair_len;
+  size_t              num_pairs;
+  EIP2537_ERROR*      rets;     /* result of each block */
+  byte*               states;   /* free, claimed or decoded */
+  byte                failed;
+} pippenger_decode;
+
+static size_t pippenger_decode_num_blocks(size_t num_pairs) {
+  return (num_pairs + PIPPENGER_DECODE_BLOCK - 1) / PIPPENGER_DECODE_BLOCK;
 }
 
-/*
-  ABI for G1 addition
+static size_t pippenger_decode_size(size_t num_pairs) {
+  return pippenger_decode_num_blocks(num_pairs) * (sizeof(EIP2537_ERROR) + 1);
+}
 
-  G1 addition call expects 256 bytes as an input that is interpreted as byte
-    concatenation of two G1 points (128 bytes each). Output is an encoding of
-    addition operation result - single G1 point (128 bytes).
+static void pippenger_decode_init(pippenger_decode* d, void* mem,
+                                  pippenger_decode_fn decode, void* bases,
+                                  size_t point_size, blst_scalar* scalars,
+                                  const byte* in, size_t pair_len,
+                                  size_t num_pairs) {
+  size_t num_blocks = pippenger_decode_num_blocks(num_pairs);
+
+  d->decode     = decode;
+  d->bases      = (byte*)bases;
+  d->point_size = point_size;
+  d->scalars    = scalars;
+  d->in         = in;
+  d->pair_len   = pair_len;
+  d->num_pairs  = num_pairs;
+  d->rets       = (EIP2537_ERROR*)mem;
+  d->states     = (byte*)(d->rets + num_blocks);
+  d->failed     = 0;
+  memset(d->states, PIPPENGER_BLOCK_FREE, num_blocks);
+}
 
-  Error cases:
-    Either of points being not on the curve must result in error
-    Field elements encoding rules apply (obviously)
-    Input has invalid length
-*/
-EIP2537_ERROR bls12_g1add(byte out[128], const byte in[256], size_t in_len) {
-  /* Check length, is this even necessary? */
-  if (in_len != 256) {
-    return EIP2537_INVALID_LENGTH;
+static void pippenger_decode_block(pippenger_decode* d, size_t b) {
+  size_t start = b * PIPPENGER_DECODE_BLOCK;
+  size_t num   = d->num_pairs - start;
+  if (num > PIPPENGER_DECODE_BLOCK) {
+    num = PIPPENGER_DECODE_BLOCK;
   }
 
-  EIP2537_ERROR ret;
-
-  /* Decode inputs */
-  blst_p1_affine a_aff;
-  ret = decode_g1_point(&a_aff, in);
-  if (ret != EIP2537_SUCCESS) {
-    return ret;
+  d->rets[b] = d->decode(d->bases + (start * d->point_size),
+                         d->scalars + start, d->in + (start * d->pair_len),
+                         num);
+  if (d->rets[b] != EIP2537_SUCCESS) {
+    BLS12_ATOMIC_STORE(&(d->failed), 1);
   }
+  BLS12_ATOMIC_STORE_RELEASE(&(d->states[b]), PIPPENGER_BLOCK_DECODED);
+}
 
-  blst_p1_affine b_aff;
-  ret = decode_g1_point(&b_aff, in + 128);
-  if (ret != EIP2537_SUCCESS) {
-    return ret;
+/* Make pairs [start, end) available, decoding any unclaimed block in range,
+   returns 0 once any block has failed */
+static int pippenger_decode_range(pippenger_decode* d, size_t start,
+                                  size_t end) {
+  size_t first = start / PIPPENGER_DECODE_BLOCK;
+  size_t last  = (end + PIPPENGER_DECODE_BLOCK - 1) / PIPPENGER_DECODE_BLOCK;
+
+  for (size_t b = first; b < last; ++b) {
+    byte state = PIPPENGER_BLOCK_FREE;
+    if (BLS12_ATOMIC_CAS_ACQUIRE(&(d->states[b]), &state,
+                                 PIPPENGER_BLOCK_CLAIMED)) {
+      pippenger_decode_block(d, b);
+    }
   }
 
-  /* One of the inputs needs to be projective for point addition function */
-  blst_p1 b;
-  blst_p1_from_affine(&b, &b_aff);
+  for (size_t b = first; b < last; ++b) {
+    while (BLS12_ATOMIC_LOAD_ACQUIRE(&(d->states[b])) !=
+           PIPPENGER_BLOCK_DECODED) {
+      if (BLS12_ATOMIC_LOAD(&(d->failed))) {
+        return 0;
+      }
+    }
+  }
 
-  /* P = A + B */
-  blst_p1 p;
-  blst_p1_add_or_double_affine(&p, &b, &a_aff);
+  return !BLS12_ATOMIC_LOAD(&(d->failed));
+}
 
-  /* Convert point to affine */
-  blst_p1_affine p_aff;
-  blst_p1_to_affine(&p_aff, &p);
+/* After the threads joined, the first failing block in input order gives
+   the error as in a serial decode, blocks skipped after a failure are
+   decoded here */
+static EIP2537_ERROR pippenger_decode_result(pippenger_decode* d) {
+  size_t num_blocks = pippenger_decode_num_blocks(d->num_pairs);
 
-  /* Encode affine point to EIP format */
-  encode_g1_point(out, &p_aff);
+  for (size_t b = 0; b < num_blocks; ++b) {
+    if (d->states[b] == PIPPENGER_BLOCK_FREE) {
+      pippenger_decode_block(d, b);
+    }
+    if (d->rets[b] != EIP2537_SUCCESS) {
+      return d->rets[b];
+    }
+  }
 
   return EIP2537_SUCCESS;
 }
 
-/* 
-  ABI for G1 multiplication
+/* G1 bucket method split into (window, chunk) tasks shared by all threads */
+typedef struct {
+  const blst_p1_affine* bases;
+  const blst_scalar*    scalars;
+  size_t                num_pairs;
+  size_t                window;
+  size_t                num_chunks;
+  size_t                num_tasks;
+  size_t                num_threads;
+  blst_p1*              sums;        /* window sum of each task */
+  pippenger_decode*     decode;
+} blst_p1s_pippenger_ctx;
+
+/* Thread t runs tasks t, t + num_threads, ... with its own buckets */
+typedef struct {
+  const blst_p1s_pippenger_ctx* ctx;
+  size_t                        thread;
+  blst_p1*                      buckets;
+} blst_p1s_pippenger_work;
+
+static void* blst_p1s_pippenger_worker(void* arg) {
+  blst_p1s_pippenger_work*      work = (blst_p1s_pippenger_work*)arg;
+  const blst_p1s_pippenger_ctx* ctx  = work->ctx;
+
+  for (size_t task = work->thread; task < ctx->num_tasks;
+       task += ctx->num_threads) {
+    size_t w     = task / ctx->num_chunks;
+    size_t chunk = task % ctx->num_chunks;
+    size_t start = (ctx->num_pairs * chunk) / ctx->num_chunks;
+    size_t end   = (ctx->num_pairs * (chunk + 1)) / ctx->num_chunks;
+
+    if (!pippenger_decode_range(ctx->decode, start, end)) {
+      break;
+    }
 
-  G1 multiplication call expects 160 bytes as an input that is interpreted as
-    byte concatenation of encoding of G1 point (128 bytes) and encoding of a
-    scalar value (32 bytes). Output is an encoding of multiplication operation
-    result - single G1 point (128 bytes).
+    blst_p1s_pippenger_window(&(ctx->sums[task]), work->buckets,
+                              ctx->bases + start, ctx->scalars + start,
+                              end - start, w * ctx->window, ctx->window);
+  }
 
-  Error cases:
-    Point being not on the curve must result in error
-    Field elements encoding rules apply (obviously)
-    Input has invalid length
+  return NULL;
+}
 
-*/
-EIP2537_ERROR bls12_g1mul(byte out[128], const byte in[160], size_t in_len) {
-  /* Check length, is this even necessary? */
-  if (in_len != 160) {
-    return EIP2537_INVALID_LENGTH;
+/* G2 buckets are kept affine once the window is wide enough that batches of
+   additions can share one Fp2 inversion (Montgomery trick) */
+#define G2_BATCH_AFFINE_MIN_WINDOW 6
+#define G2_BATCH_AFFINE_MAX_BATCH  256
+
+/* Bucket storage for one window of G2 bucket method */
+typedef struct {
+  blst_p2*        overflow;      /* projective sums, used when batch is busy */
+  blst_p2_affine* buckets;       /* affine sums, valid when occupied is set  */
+  blst_p2_affine* batch_points;  /* pending point per batch slot             */
+  blst_fp2*       batch_denoms;  /* denominator per batch slot               */
+  blst_fp2*       batch_prods;   /* running product of denominators          */
+  uint32_t*       batch_buckets; /* target bucket per batch slot             */
+  byte*           occupied;      /* affine bucket holds a point              */
+  byte*           in_batch;      /* bucket already has a pending addition    */
+  size_t          batch_size;
+  size_t          batch_len;
+} blst_p2_buckets;
+
+/* Bytes needed to hold blst_p2_buckets arrays for a given window */
+static size_t blst_p2_buckets_sizeof(size_t window) {
+  size_t num_buckets = (size_t)1 << (window - 1);
+  size_t batch_size  = num_buckets >> 2;
+
+  if (batch_size > G2_BATCH_AFFINE_MAX_BATCH) {
+    batch_size = G2_BATCH_AFFINE_MAX_BATCH;
+  }
+
+  return (num_buckets * (sizeof(blst_p2) + sizeof(blst_p2_affine) + 2)) +
+         (batch_size * (sizeof(blst_p2_affine) + (2 * sizeof(blst_fp2)) +
+                        sizeof(uint32_t)));
+}
+
+/* Carve bucket arrays out of a single allocation, largest alignment first */
+static void blst_p2_buckets_init(blst_p2_buckets* b, void* mem,
+                                 size_t window) {
+  size_t num_buckets = (size_t)1 << (window - 1);
+  byte*  ptr         = (byte*)mem;
+
+  b->batch_size = num_buckets >> 2;
+  if (b->batch_size > G2_BATCH_AFFINE_MAX_BATCH) {
+    b->batch_size = G2_BATCH_AFFINE_MAX_BATCH;
+  }
+  b->batch_len = 0;
+
+  b->overflow      = (blst_p2*)ptr;
+  ptr             += num_buckets * sizeof(blst_p2);
+  b->buckets       = (blst_p2_affine*)ptr;
+  ptr             += num_buckets * sizeof(blst_p2_affine);
+  b->batch_points  = (blst_p2_affine*)ptr;
+  ptr             += b->batch_size * sizeof(blst_p2_affine);
+  b->batch_denoms  = (blst_fp2*)ptr;
+  ptr             += b->batch_size * sizeof(blst_fp2);
+  b->batch_prods   = (blst_fp2*)ptr;
+  ptr             += b->batch_size * sizeof(blst_fp2);
+  b->batch_buckets = (uint32_t*)ptr;
+  ptr             += b->batch_size * sizeof(uint32_t);
+  b->occupied      = ptr;
+  ptr             += num_buckets;
+  b->in_batch      = ptr;
+}
+
+/* Apply all pending affine bucket additions using one shared inversion */
+static void blst_p2_buckets_flush(blst_p2_buckets* b) {
+  size_t n = b->batch_len;
+
+  if (n == 0) {
+    return;
+  }
+
+  /* Denominator is x2 - x1 for addition or 2 * y1 for doubling */
+  for (size_t i = 0; i < n; ++i) {
+    const blst_p2_affine* bucket = &(b->buckets[b->batch_buckets[i]]);
+    const blst_p2_affine* point  = &(b->batch_points[i]);
+
+    if (memcmp(&(bucket->x), &(point->x), sizeof(blst_fp2)) == 0) {
+      blst_fp2_add(&(b->batch_denoms[i]), &(bucket->y), &(bucket->y));
+    }
+    else {
+      blst_fp2_sub(&(b->batch_denoms[i]), &(point->x), &(bucket->x));
+    }
+
+    if (i == 0) {
+      b->batch_prods[0] = b->batch_denoms[0];
+    }
+    else {
+      blst_fp2_mul(&(b->batch_prods[i]), &(b->batch_prods[i - 1]),
+                   &(b->batch_denoms[i]));
+    }
+  }
+
+  blst_fp2 inv;
+  blst_fp2_eucl_inverse(&inv, &(b->batch_prods[n - 1]));
+
+  /* Walk back peeling off one inverse per slot */
+  for (size_t i = n; i-- > 0;) {
+    uint32_t              idx    = b->batch_buckets[i];
+    blst_p2_affine*       bucket = &(b->buckets[idx]);
+    const blst_p2_affine* point  = &(b->batch_points[i]);
+    blst_fp2              inv_i, lambda, t;
+
+    if (i > 0) {
+      blst_fp2_mul(&inv_i, &inv, &(b->batch_prods[i - 1]));
+      blst_fp2_mul(&inv, &inv, &(b->batch_denoms[i]));
+    }
+    else {
+      inv_i = inv;
+    }
+
+    b->in_batch[idx] = 0;
+
+    if (memcmp(&(bucket->x), &(point->x), sizeof(blst_fp2)) == 0) {
+      if (memcmp(&(bucket->y), &(point->y), sizeof(blst_fp2)) != 0) {
+        /* P + (-P), bucket becomes empty */
+        b->occupied[idx] = 0;
+        continue;
+      }
+      /* lambda = 3 * x^2 / (2 * y) */
+      blst_fp2_sqr(&t, &(bucket->x));
+      blst_fp2_mul_by_3(&t, &t);
+    }
+    else {
+      /* lambda = (y2 - y1) / (x2 - x1) */
+      blst_fp2_sub(&t, &(point->y), &(bucket->y));
+    }
+    blst_fp2_mul(&lambda, &t, &inv_i);
+
+    /* x3 = lambda^2 - x1 - x2, y3 = lambda * (x1 - x3) - y1 */
+    blst_fp2 x3;
+    blst_fp2_sqr(&x3, &lambda);
+    blst_fp2_sub(&x3, &x3, &(bucket->x));
+    blst_fp2_sub(&x3, &x3, &(point->x));
+
+    blst_fp2_sub(&t, &(bucket->x), &x3);
+    blst_fp2_mul(&t, &t, &lambda);
+    blst_fp2_sub(&(bucket->y), &t, &(bucket->y));
+    bucket->x = x3;
+  }
+
+  b->batch_len = 0;
+}
+
+/* Add a point into a bucket, batching affine additions when enabled */
+static void blst_p2_buckets_add(blst_p2_buckets* b, uint32_t idx,
+                                const blst_p2_affine* point, int use_batch) {
+  if (!use_batch || b->in_batch[idx]) {
+    blst_p2_add_or_double_affine(&(b->overflow[idx]), &(b->overflow[idx]),
+                                 point);
+  }
+  else if (!b->occupied[idx]) {
+    b->buckets[idx]  = *point;
+    b->occupied[idx] = 1;
+  }
+  else {
+    b->batch_points[b->batch_len]  = *point;
+    b->batch_buckets[b->batch_len] = idx;
+    b->in_batch[idx]               = 1;
+    if (++b->batch_len == b->batch_size) {
+      blst_p2_buckets_flush(b);
+    }
+  }
+}
+
+/* Compute a single window of G2 bucket method, ret = sum (j * bucket_j) */
+static void blst_p2s_pippenger_window(blst_p2* ret, blst_p2_buckets* b,
+                                      const blst_p2_affine* bases,
+                                      const blst_scalar* scalars,
+                                      size_t num_pairs, size_t offset,
+                                      size_t window) {
+  size_t num_buckets = (size_t)1 << (window - 1);
+  int    use_batch   = (window >= G2_BATCH_AFFINE_MIN_WINDOW);
+
+  memset(b->overflow, 0, num_buckets * sizeof(blst_p2)); /* Infinity */
+  memset(b->occupied, 0, num_buckets);
+  memset(b->in_batch, 0, num_buckets);
+
+  /* Accumulate each base into the bucket of its signed digit */
+  for (size_t i = 0; i < num_pairs; ++i) {
+    int32_t digit = booth_encode(booth_get_wval(scalars[i].b, offset, window),
+                                 window);
+
+    /* Infinity adds nothing, and would not fit the affine formulas */
+    if ((digit == 0) || blst_p2_affine_is_inf(&(bases[i]))) {
+      continue;
+    }
+
+    if (digit > 0) {
+      blst_p2_buckets_add(b, digit - 1, &(bases[i]), use_batch);
+    }
+    else {
+      blst_p2_affine neg_base = bases[i];
+      blst_fp2_cneg(&(neg_base.y), &(neg_base.y), 1);
+      blst_p2_buckets_add(b, -digit - 1, &neg_base, use_batch);
+    }
+  }
+  blst_p2_buckets_flush(b);
+
+  /* Running sum from the top bucket down weights bucket j by j */
+  blst_p2 running = { {{{{0}}, {{0}}}},
+                      {{{{0}}, {{0}}}},
+                      {{{{0}}, {{0}}}} }; /* Infinity */
+  memset(ret, 0, sizeof(blst_p2));        /* Infinity */
+
+  for (size_t j = num_buckets; j-- > 0;) {
+    if (b->occupied[j]) {
+      blst_p2_add_or_double_affine(&running, &running, &(b->buckets[j]));
+    }
+    blst_p2_add_or_double(&running, &running, &(b->overflow[j]));
+    blst_p2_add_or_double(ret, ret, &running);
+  }
+}
+
+
+/* G2 bucket method split into (window, chunk) tasks shared by all threads */
+typedef struct {
+  const blst_p2_affine* bases;
+  const blst_scalar*    scalars;
+  size_t                num_pairs;
+  size_t                window;
+  size_t                num_chunks;
+  size_t                num_tasks;
+  size_t                num_threads;
+  blst_p2*              sums;        /* window sum of each task */
+  pippenger_decode*     decode;
+} blst_p2s_pippenger_ctx;
+
+/* Thread t runs tasks t, t + num_threads, ... with its own buckets */
+typedef struct {
+  const blst_p2s_pippenger_ctx* ctx;
+  size_t                        thread;
+  blst_p2_buckets               buckets;
+} blst_p2s_pippenger_work;
+
+static void* blst_p2s_pippenger_worker(void* arg) {
+  blst_p2s_pippenger_work*      work = (blst_p2s_pippenger_work*)arg;
+  const blst_p2s_pippenger_ctx* ctx  = work->ctx;
+
+  for (size_t task = work->thread; task < ctx->num_tasks;
+       task += ctx->num_threads) {
+    size_t w     = task / ctx->num_chunks;
+    size_t chunk = task % ctx->num_chunks;
+    size_t start = (ctx->num_pairs * chunk) / ctx->num_chunks;
+    size_t end   = (ctx->num_pairs * (chunk + 1)) / ctx->num_chunks;
+
+    if (!pippenger_decode_range(ctx->decode, start, end)) {
+      break;
+    }
+
+    blst_p2s_pippenger_window(&(ctx->sums[task]), &(work->buckets),
+                              ctx->bases + start, ctx->scalars + start,
+                              end - start, w * ctx->window, ctx->window);
+  }
+
+  return NULL;
+}
+
+/* Validated point cache, maps an encoding to its decoded affine point */
+
+#define POINT_CACHE_NUM_LOCKS    64
+#define POINT_CACHE_ON_CURVE     1  /* decoded, subgroup not yet checked */
+#define POINT_CACHE_IN_GROUP     2  /* decoded and in the prime subgroup */
+#define POINT_CACHE_NOT_IN_GROUP 3  /* decoded but outside the subgroup  */
+
+/* Direct mapped table, entry is state byte, padding, point then encoding */
+typedef struct {
+  byte*    entries;
+  size_t   capacity;   /* power of two, 0 when disabled */
+  size_t   enc_len;
+  size_t   point_size;
+  uint64_t hits;
+  uint64_t misses;
+  byte     locks[POINT_CACHE_NUM_LOCKS];
+} bls12_point_cache;
+
+static bls12_point_cache bls12_g1_cache = {
+  NULL, 0, 128, sizeof(blst_p1_affine), 0, 0, {0}
+};
+static bls12_point_cache bls12_g2_cache = {
+  NULL, 0, 256, sizeof(blst_p2_affine), 0, 0, {0}
+};
+
+static void bls12_spin_lock(byte* lock) {
+#ifdef EIP2537_THREADS
+  while (__atomic_test_and_set(lock, __ATOMIC_ACQUIRE)) {
+  }
+#else
+  (void)lock;
+#endif
+}
+
+static void bls12_spin_unlock(byte* lock) {
+#ifdef EIP2537_THREADS
+  __atomic_clear(lock, __ATOMIC_RELEASE);
+#else
+  (void)lock;
+#endif
+}
+
+/* Hash the x coordinate of an encoding and the last word of y, which tells
+   P from -P so e(P, Q) e(-P, Q) style inputs do not evict each other */
+static uint64_t point_cache_hash(const byte* in, size_t enc_len) {
+  uint64_t h = 0;
+  uint64_t word;
+
+  for (size_t i = 0; i < (enc_len / 2); i += 8) {
+    memcpy(&word, in + i, 8);
+    h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+  }
+
+  memcpy(&word, in + enc_len - 8, 8);
+  h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+
+  return h ^ (h >> 29);
+}
+
+static size_t point_cache_entry_size(const bls12_point_cache* cache) {
+  return 8 + cache->point_size + cache->enc_len;
+}
+
+/* Copy out the cached point for an encoding, returns its state or 0 */
+static byte point_cache_lookup(bls12_point_cache* cache, const byte* in,
+                               void* point) {
+  if (BLS12_ATOMIC_LOAD(&(cache->capacity)) == 0) {
+    return 0;
+  }
+
+  uint64_t h     = point_cache_hash(in, cache->enc_len);
+  byte*    lock  = &(cache->locks[h % POINT_CACHE_NUM_LOCKS]);
+  byte     state = 0;
+
+  bls12_spin_lock(lock);
+  if (cache->capacity != 0) {
+    byte* entry = cache->entries + ((h & (cache->capacity - 1)) *
+                                    point_cache_entry_size(cache));
+
+    if ((entry[0] != 0) &&
+        (memcmp(entry + 8 + cache->point_size, in, cache->enc_len) == 0)) {
+      memcpy(point, entry + 8, cache->point_size);
+      state = entry[0];
+    }
+  }
+  bls12_spin_unlock(lock);
+
+  if (state != 0) {
+    BLS12_ATOMIC_ADD(&(cache->hits), 1);
+  }
+  else {
+    BLS12_ATOMIC_ADD(&(cache->misses), 1);
+  }
+
+  return state;
+}
+
+/* Store a decoded point for an encoding, evicting whatever shares its slot */
+static void point_cache_insert(bls12_point_cache* cache, const byte* in,
+                               const void* point, byte state) {
+  if (BLS12_ATOMIC_LOAD(&(cache->capacity)) == 0) {
+    return;
+  }
+
+  uint64_t h    = point_cache_hash(in, cache->enc_len);
+  byte*    lock = &(cache->locks[h % POINT_CACHE_NUM_LOCKS]);
+
+  bls12_spin_lock(lock);
+  if (cache->capacity != 0) {
+    byte* entry = cache->entries + ((h & (cache->capacity - 1)) *
+                                    point_cache_entry_size(cache));
+
+    entry[0] = state;
+    memcpy(entry + 8, point, cache->point_size);
+    memcpy(entry + 8 + cache->point_size, in, cache->enc_len);
+  }
+  bls12_spin_unlock(lock);
+}
+
+/* Resize or disable a cache, holding every lock while the table changes */
+static EIP2537_ERROR point_cache_configure(bls12_point_cache* cache,
+                                           size_t num_entries) {
+  size_t capacity = 0;
+  byte*  entries  = NULL;
+
+  if (num_entries > 0) {
+    capacity = 1;
+    while ((capacity << 1) <= num_entries) {
+      capacity <<= 1;
+    }
+
+    entries = (byte*) calloc(capacity, point_cache_entry_size(cache));
+    if (entries == NULL) {
+      return EIP2537_MEMORY_ERROR;
+    }
+  }
+
+  for (size_t i = 0; i < POINT_CACHE_NUM_LOCKS; ++i) {
+    bls12_spin_lock(&(cache->locks[i]));
+  }
+
+  byte* old_entries = cache->entries;
+  cache->entries    = entries;
+  BLS12_ATOMIC_STORE(&(cache->capacity), capacity);
+  BLS12_ATOMIC_STORE(&(cache->hits), 0);
+  BLS12_ATOMIC_STORE(&(cache->misses), 0);
+
+  for (size_t i = 0; i < POINT_CACHE_NUM_LOCKS; ++i) {
+    bls12_spin_unlock(&(cache->locks[i]));
+  }
+
+  free(old_entries);
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_point_cache_configure(size_t g1_entries,
+                                          size_t g2_entries) {
+  EIP2537_ERROR ret;
+
+  ret = point_cache_configure(&bls12_g1_cache, g1_entries);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return point_cache_configure(&bls12_g2_cache, g2_entries);
+}
+
+void bls12_point_cache_get_stats(bls12_point_cache_stats* stats) {
+  stats->g1_hits   = BLS12_ATOMIC_LOAD(&(bls12_g1_cache.hits));
+  stats->g1_misses = BLS12_ATOMIC_LOAD(&(bls12_g1_cache.misses));
+  stats->g2_hits   = BLS12_ATOMIC_LOAD(&(bls12_g2_cache.hits));
+  stats->g2_misses = BLS12_ATOMIC_LOAD(&(bls12_g2_cache.misses));
+}
+
+
+/* p as little endian limbs */
+static const uint64_t bls12_p[6] = {
+  0xb9feffffffffaaab, 0x1eabfffeb153ffff, 0x6730d2a0f6b0f624,
+  0x64774b84f38512bf, 0x4b1ba7b6434bacd7, 0x1a0111ea397fe69a
+};
+
+/* Big endian word load, compiles to a single load and byte swap */
+static inline uint64_t load_be64(const byte* in) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    v = (v << 8) | in[i];
+  }
+  return v;
+}
+
+/* Set fp to the Montgomery form of canonical little endian 64 bit limbs */
+static inline void fp_from_limbs(blst_fp* fp, const uint64_t limbs[6]) {
+  for (size_t j = 0; j < 6; ++j) {
+    for (size_t k = 0; k < (sizeof(uint64_t) / sizeof(limb_t)); ++k) {
+      fp->l[(j * (sizeof(uint64_t) / sizeof(limb_t))) + k] =
+        (limb_t)(limbs[j] >> (k * 8 * sizeof(limb_t)));
+    }
+  }
+
+  blst_fp_to(fp, fp);
+}
+
+/* Extract encoded field element byte array into blst_fp object, one pass
+   over whole words. Returns -1 if invalid, 0 if zero and 1 otherwise */
+static int fp_from_bytes(blst_fp* fp, const byte* in) {
+  /* Ensure first 16 bytes of field element are zero */
+  if ((load_be64(in) | load_be64(in + 8)) != 0) {
+    return -1;
+  }
+
+  /* Next 48 bytes are field element in big endian form, check it is less
+     than the modulus with the borrow of element - p */
+  uint64_t limbs[6];
+  uint64_t borrow  = 0;
+  uint64_t nonzero = 0;
+
+  for (size_t j = 0; j < 6; ++j) {
+    uint64_t l = load_be64(in + 16 + ((5 - j) * 8));
+    uint64_t t = l - bls12_p[j];
+    borrow     = (l < bls12_p[j]) | (t < borrow);
+    nonzero   |= l;
+    limbs[j]   = l;
+  }
+
+  if (borrow == 0) {
+    return -1;
+  }
+
+  /* Convert field element to Montgomery form */
+  fp_from_limbs(fp, limbs);
+
+  /* Return if field element is zero or not */
+  return (nonzero != 0);
+}
+
+/* Encode blst_fp object into byte array */
+static void fp_to_bytes(byte* out, const blst_fp* fp) {
+  for (size_t i = 0; i < 16; ++i) {
+    out[i] = 0;
+  }
+  blst_bendian_from_fp(out + 16, fp);
+}
+
+/* Decode a G1 point from the encoded 128 byte field element array */
+static EIP2537_ERROR decode_g1_point_uncached(blst_p1_affine* out,
+                                               const byte* in) {
+  /* Extract the x,y field elements from encoding */
+  int fp_x_status = fp_from_bytes(&(out->x), in);
+  int fp_y_status = fp_from_bytes(&(out->y), in + 64);
+
+  /* Ensure both field elements are valid */
+  if ((fp_x_status < 0) || (fp_y_status < 0)) {
+    return EIP2537_INVALID_ELEMENT;
+  }
+
+  /* If infinity then simply return */
+  if ((fp_x_status == 0) && (fp_y_status == 0)) {
+    return EIP2537_SUCCESS;
+  }
+
+  /* Check if point is on the curve */
+  if (!blst_p1_affine_on_curve(out)) {
+    return EIP2537_POINT_NOT_ON_CURVE; 
+  }
+
+  /* TODO - do we need a subgroup check as well? */
+
+  return EIP2537_SUCCESS;
+}
+
+/* Encode a G1 point into byte array from affine point representation */
+static void encode_g1_point(byte* out, const blst_p1_affine* in) {
+  /* TODO - need to check for infinity? */
+  fp_to_bytes(out, &(in->x));
+  fp_to_bytes(out + 64, &(in->y));
+}
+
+/* Decode a G1 point, served from the point cache when enabled */
+static EIP2537_ERROR decode_g1_point(blst_p1_affine* out, const byte* in) {
+  if (point_cache_lookup(&bls12_g1_cache, in, out) != 0) {
+    return EIP2537_SUCCESS;
+  }
+
+  EIP2537_ERROR ret = decode_g1_point_uncached(out, in);
+  if (ret == EIP2537_SUCCESS) {
+    point_cache_insert(&bls12_g1_cache, in, out, POINT_CACHE_ON_CURVE);
+  }
+
+  return ret;
+}
+
+/* Subgroup verdict for a decoded G1 point in cache state, checked and
+   stored in the cache unless it already holds one */
+static EIP2537_ERROR check_g1_point_in_g1(const blst_p1_affine* p,
+                                          const byte* in, byte state) {
+  if (state == POINT_CACHE_IN_GROUP) {
+    return EIP2537_SUCCESS;
+  }
+  if (state == POINT_CACHE_NOT_IN_GROUP) {
+    return EIP2537_POINT_NOT_IN_SUBGROUP;
+  }
+
+  state = blst_p1_affine_in_g1(p) ? POINT_CACHE_IN_GROUP :
+                                   POINT_CACHE_NOT_IN_GROUP;
+  point_cache_insert(&bls12_g1_cache, in, p, state);
+
+  if (state == POINT_CACHE_NOT_IN_GROUP) {
+    return EIP2537_POINT_NOT_IN_SUBGROUP;
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+/* Decode a G1 point and check it is in G1, a cache hit skips both */
+static EIP2537_ERROR decode_g1_point_in_g1(blst_p1_affine* out,
+                                           const byte* in) {
+  byte state = point_cache_lookup(&bls12_g1_cache, in, out);
+
+  if (state == 0) {
+    EIP2537_ERROR ret = decode_g1_point_uncached(out, in);
+    if (ret != EIP2537_SUCCESS) {
+      return ret;
+    }
+  }
+
+  return check_g1_point_in_g1(out, in, state);
+}
+
+
+
+
+
+
+/* Extract encoded field element byte array into blst_fp2 object */
+static int fp2_from_bytes(blst_fp2* fp2, const byte* in) {
+  /* Extract the c0 and c1 field elements from encoding */
+  int fp_c0_status = fp_from_bytes(&(fp2->fp[0]), in);
+  int fp_c1_status = fp_from_bytes(&(fp2->fp[1]), in + 64);
+
+  if ((fp_c0_status < 0) || (fp_c1_status < 0)) {
+    return -1;
+  }
+
+  return (fp_c0_status | fp_c1_status);
+}
+
+/* Encode blst_fp2 object into byte array */
+static void fp2_to_bytes(byte* out, const blst_fp2* fp2) {
+  for (size_t i = 0; i < 16; ++i) {
+    out[i] = 0;
+    out[i + 64] = 0;
+  }
+  blst_bendian_from_fp(out + 16, &(fp2->fp[0]));
+  blst_bendian_from_fp(out + 80, &(fp2->fp[1]));
+}
+
+/* Decode a G2 point from the encoded 256 byte field element array */
+static EIP2537_ERROR decode_g2_point_uncached(blst_p2_affine* out,
+                                               const byte* in) {
+  /* Extract the x,y field elements from encoding */
+  int fp_x_status = fp2_from_bytes(&(out->x), in);
+  int fp_y_status = fp2_from_bytes(&(out->y), in + 128);
+
+  /* Ensure both field elements are valid */
+  if ((fp_x_status < 0) || (fp_y_status < 0)) {
+    return EIP2537_INVALID_ELEMENT;
+  }
+
+  /* If infinity then simply return */
+  if ((fp_x_status == 0) && (fp_y_status == 0)) {
+    return EIP2537_SUCCESS;
+  }
+
+  /* Check if point is on the curve */
+  if (!blst_p2_affine_on_curve(out)) {
+    return EIP2537_POINT_NOT_ON_CURVE; 
+  }
+
+  /* TODO - do we need a subgroup check as well? */
+
+  return EIP2537_SUCCESS;
+}
+
+/* Encode a G2 point into byte array from affine point representation */
+static void encode_g2_point(byte* out, const blst_p2_affine* in) {
+  /* TODO - need to check for infinity? */
+  fp2_to_bytes(out, &(in->x));
+  fp2_to_bytes(out + 128, &(in->y));
+}
+
+/* Decode a G2 point, served from the point cache when enabled */
+static EIP2537_ERROR decode_g2_point(blst_p2_affine* out, const byte* in) {
+  if (point_cache_lookup(&bls12_g2_cache, in, out) != 0) {
+    return EIP2537_SUCCESS;
+  }
+
+  EIP2537_ERROR ret = decode_g2_point_uncached(out, in);
+  if (ret == EIP2537_SUCCESS) {
+    point_cache_insert(&bls12_g2_cache, in, out, POINT_CACHE_ON_CURVE);
+  }
+
+  return ret;
+}
+
+/* Subgroup verdict for a decoded G2 point in cache state, checked and
+   stored in the cache unless it already holds one */
+static EIP2537_ERROR check_g2_point_in_g2(const blst_p2_affine* p,
+                                          const byte* in, byte state) {
+  if (state == POINT_CACHE_IN_GROUP) {
+    return EIP2537_SUCCESS;
+  }
+  if (state == POINT_CACHE_NOT_IN_GROUP) {
+    return EIP2537_POINT_NOT_IN_SUBGROUP;
+  }
+
+  state = blst_p2_affine_in_g2(p) ? POINT_CACHE_IN_GROUP :
+                                   POINT_CACHE_NOT_IN_GROUP;
+  point_cache_insert(&bls12_g2_cache, in, p, state);
+
+  if (state == POINT_CACHE_NOT_IN_GROUP) {
+    return EIP2537_POINT_NOT_IN_SUBGROUP;
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+/* Decode a G2 point and check it is in G2, a cache hit skips both */
+static EIP2537_ERROR decode_g2_point_in_g2(blst_p2_affine* out,
+                                           const byte* in) {
+  byte state = point_cache_lookup(&bls12_g2_cache, in, out);
+
+  if (state == 0) {
+    EIP2537_ERROR ret = decode_g2_point_uncached(out, in);
+    if (ret != EIP2537_SUCCESS) {
+      return ret;
+    }
+  }
+
+  return check_g2_point_in_g2(out, in, state);
+}
+
+
+
+
+/* Bulk decoding for large inputs. A block of field element encodings is
+   transposed into a structure of arrays of 64 bit words so the padding,
+   byte swap and range checks run as independent lanes the compiler can
+   vectorize with the baseline ISA, then valid elements are converted to
+   Montgomery form and points checked on curve one by one in blst */
+#define FP_DECODE_BLOCK 64
+
+/* Decode up to FP_DECODE_BLOCK encodings in[i] into out[i] with status[i]
+   as fp_from_bytes, -1 invalid, 0 zero and 1 otherwise */
+static void fp_from_bytes_n(blst_fp* const* out, int* status,
+                            const byte* const* in, size_t num) {
+  uint64_t limbs[6][FP_DECODE_BLOCK];
+  uint64_t pad[FP_DECODE_BLOCK];
+  uint64_t below[FP_DECODE_BLOCK];
+  uint64_t nonzero[FP_DECODE_BLOCK];
+
+  /* Transpose, limb j is big endian word 5 - j after the padding */
+  for (size_t i = 0; i < num; ++i) {
+    pad[i] = load_be64(in[i]) | load_be64(in[i] + 8);
+    for (size_t j = 0; j < 6; ++j) {
+      limbs[j][i] = load_be64(in[i] + 16 + ((5 - j) * 8));
+    }
+    below[i]   = 0;
+    nonzero[i] = 0;
+  }
+
+  /* Borrow of element - p lane by lane, set when the element is below p */
+  for (size_t j = 0; j < 6; ++j) {
+    for (size_t i = 0; i < num; ++i) {
+      uint64_t l = limbs[j][i];
+      uint64_t t = l - bls12_p[j];
+      below[i]    = (l < bls12_p[j]) | (t < below[i]);
+      nonzero[i] |= l;
+    }
+  }
+
+  for (size_t i = 0; i < num; ++i) {
+    if ((pad[i] != 0) || (below[i] == 0)) {
+      status[i] = -1;
+      continue;
+    }
+
+    uint64_t l[6];
+    for (size_t j = 0; j < 6; ++j) {
+      l[j] = limbs[j][i];
+    }
+
+    /* Convert field element to Montgomery form */
+    fp_from_limbs(out[i], l);
+    status[i] = (nonzero[i] != 0);
+  }
+}
+
+/* Decode num G1 points at in + (i * stride) into out[i], returning the
+   error of the first failing point. Cached points skip decoding, states (if
+   not NULL) gets each point's cache state. Only the range checks and
+   Montgomery conversions are batched, blst has no batched curve equation
+   and the check is a few multiplications without an inversion, so it stays
+   per point */
+static EIP2537_ERROR decode_g1_points(blst_p1_affine* out, const byte* in,
+                                      size_t stride, size_t num,
+                                      byte* states) {
+  const byte* enc[FP_DECODE_BLOCK];
+  blst_fp*    fps[FP_DECODE_BLOCK];
+  int         status[FP_DECODE_BLOCK];
+  size_t      index[FP_DECODE_BLOCK / 2];
+
+  for (size_t start = 0; start < num; start += (FP_DECODE_BLOCK / 2)) {
+    size_t end        = start + (FP_DECODE_BLOCK / 2);
+    size_t num_misses = 0;
+    if (end > num) {
+      end = num;
+    }
+
+    for (size_t i = start; i < end; ++i) {
+      const byte* p = in + (i * stride);
+      byte state = point_cache_lookup(&bls12_g1_cache, p, &(out[i]));
+      if (states != NULL) {
+        states[i] = state;
+      }
+      if (state != 0) {
+        continue;
+      }
+
+      enc[(2 * num_misses)]     = p;
+      enc[(2 * num_misses) + 1] = p + 64;
+      fps[(2 * num_misses)]     = &(out[i].x);
+      fps[(2 * num_misses) + 1] = &(out[i].y);
+      index[num_misses++]       = i;
+    }
+
+    fp_from_bytes_n(fps, status, enc, 2 * num_misses);
+
+    for (size_t m = 0; m < num_misses; ++m) {
+      int fp_x_status = status[(2 * m)];
+      int fp_y_status = status[(2 * m) + 1];
+      size_t i        = index[m];
+
+      /* Same checks as decode_g1_point_uncached */
+      if ((fp_x_status < 0) || (fp_y_status < 0)) {
+        return EIP2537_INVALID_ELEMENT;
+      }
+
+      if (((fp_x_status != 0) || (fp_y_status != 0)) &&
+          !blst_p1_affine_on_curve(&(out[i]))) {
+        return EIP2537_POINT_NOT_ON_CURVE;
+      }
+
+      point_cache_insert(&bls12_g1_cache, in + (i * stride), &(out[i]),
+                         POINT_CACHE_ON_CURVE);
+      if (states != NULL) {
+        states[i] = POINT_CACHE_ON_CURVE;
+      }
+    }
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+/* Decode num G2 points at in + (i * stride) into out[i], returning the
+   error of the first failing point. Cached points skip decoding, states (if
+   not NULL) gets each point's cache state. Only the range checks and
+   Montgomery conversions are batched, blst has no batched curve equation
+   and the check is a few multiplications without an inversion, so it stays
+   per point */
+static EIP2537_ERROR decode_g2_points(blst_p2_affine* out, const byte* in,
+                                      size_t stride, size_t num,
+                                      byte* states) {
+  const byte* enc[FP_DECODE_BLOCK];
+  blst_fp*    fps[FP_DECODE_BLOCK];
+  int         status[FP_DECODE_BLOCK];
+  size_t      index[FP_DECODE_BLOCK / 4];
+
+  for (size_t start = 0; start < num; start += (FP_DECODE_BLOCK / 4)) {
+    size_t end        = start + (FP_DECODE_BLOCK / 4);
+    size_t num_misses = 0;
+    if (end > num) {
+      end = num;
+    }
+
+    for (size_t i = start; i < end; ++i) {
+      const byte* p = in + (i * stride);
+      byte state = point_cache_lookup(&bls12_g2_cache, p, &(out[i]));
+      if (states != NULL) {
+        states[i] = state;
+      }
+      if (state != 0) {
+        continue;
+      }
+
+      for (size_t f = 0; f < 4; ++f) {
+        enc[(4 * num_misses) + f] = p + (f * 64);
+      }
+      fps[(4 * num_misses)]     = &(out[i].x.fp[0]);
+      fps[(4 * num_misses) + 1] = &(out[i].x.fp[1]);
+      fps[(4 * num_misses) + 2] = &(out[i].y.fp[0]);
+      fps[(4 * num_misses) + 3] = &(out[i].y.fp[1]);
+      index[num_misses++]       = i;
+    }
+
+    fp_from_bytes_n(fps, status, enc, 4 * num_misses);
+
+    for (size_t m = 0; m < num_misses; ++m) {
+      const int* st = status + (4 * m);
+      size_t     i  = index[m];
+
+      /* Same checks as decode_g2_point_uncached */
+      if ((st[0] < 0) || (st[1] < 0) || (st[2] < 0) || (st[3] < 0)) {
+        return EIP2537_INVALID_ELEMENT;
+      }
+
+      if ((st[0] | st[1] | st[2] | st[3]) &&
+          !blst_p2_affine_on_curve(&(out[i]))) {
+        return EIP2537_POINT_NOT_ON_CURVE;
+      }
+
+      point_cache_insert(&bls12_g2_cache, in + (i * stride), &(out[i]),
+                         POINT_CACHE_ON_CURVE);
+      if (states != NULL) {
+        states[i] = POINT_CACHE_ON_CURVE;
+      }
+    }
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+/* Points decoded per bulk call by Straus and pairing, kept on the stack */
+#define POINT_DECODE_BLOCK 16
+
+/* Decode a 32 byte scalar from the encoded 32 byte array */
+static EIP2537_ERROR decode_scalar(blst_scalar* out, const byte* in) {
+  blst_scalar_from_bendian(out, in);
+  return EIP2537_SUCCESS;
+}
+
+/* Decode a block of num multiexp pairs for Pippenger, points in bulk and
+   then scalars, the first failing point gives the error */
+static EIP2537_ERROR blst_p1s_decode_pairs(void* bases, blst_scalar* scalars,
+                                           const byte* in, size_t num) {
+  EIP2537_ERROR ret = decode_g1_points((blst_p1_affine*)bases, in, 160, num,
+                                       NULL);
+
+  for (size_t i = 0; (ret == EIP2537_SUCCESS) && (i < num); ++i) {
+    ret = decode_scalar(&(scalars[i]), in + (i * 160) + 128);
+  }
+
+  return ret;
+}
+
+static EIP2537_ERROR blst_p2s_decode_pairs(void* bases, blst_scalar* scalars,
+                                           const byte* in, size_t num) {
+  EIP2537_ERROR ret = decode_g2_points((blst_p2_affine*)bases, in, 288, num,
+                                       NULL);
+
+  for (size_t i = 0; (ret == EIP2537_SUCCESS) && (i < num); ++i) {
+    ret = decode_scalar(&(scalars[i]), in + (i * 288) + 256);
+  }
+
+  return ret;
+}
+
+/* Fixed base scalar multiplication, Booth windows of FIXED_BASE_WINDOW bits
+   each with a table of the positive digit multiples, no doublings needed */
+#define FIXED_BASE_WINDOW      6
+#define FIXED_BASE_NUM_WINDOWS ((256 / FIXED_BASE_WINDOW) + 1)
+#define FIXED_BASE_NUM_ENTRIES (1 << (FIXED_BASE_WINDOW - 1))
+#define FIXED_BASE_TABLE_LEN   (FIXED_BASE_NUM_WINDOWS * FIXED_BASE_NUM_ENTRIES)
+#define FIXED_BASE_MAX         8
+
+/* G1 fixed bases, the generator first then registered bases */
+typedef struct {
+  byte            enc[128];
+  blst_p1_affine* table;
+} blst_p1_fixed_base;
+
+static blst_p1_fixed_base bls12_g1_fixed_bases[FIXED_BASE_MAX];
+static size_t             bls12_g1_num_fixed_bases = 0;
+static byte               bls12_g1_fixed_base_lock = 0;
+
+/* Fill table with j * 2^(i * w) * base for j in [1, 2^(w-1)], window i.
+   Entries are built projective and share one inversion to affine, base must
+   not be infinity */
+static int blst_p1_fixed_base_build(blst_p1_affine* table,
+                                    const blst_p1_affine* base) {
+  blst_p1*        points;
+  const blst_p1** ptrs;
+  points = (blst_p1*) malloc(FIXED_BASE_TABLE_LEN *
+                             (sizeof(blst_p1) + sizeof(blst_p1*)));
+  if (points == NULL) {
+    return 0;
+  }
+  ptrs = (const blst_p1**)(points + FIXED_BASE_TABLE_LEN);
+
+  blst_p1 window_base;
+  blst_p1_from_affine(&window_base, base);
+
+  for (size_t i = 0; i < FIXED_BASE_NUM_WINDOWS; ++i) {
+    blst_p1* row = points + (i * FIXED_BASE_NUM_ENTRIES);
+
+    row[0] = window_base;
+    for (size_t j = 1; j < FIXED_BASE_NUM_ENTRIES; ++j) {
+      blst_p1_add_or_double(&(row[j]), &(row[j - 1]), &window_base);
+    }
+
+    for (size_t k = 0; k < FIXED_BASE_WINDOW; ++k) {
+      blst_p1_double(&window_base, &window_base);
+    }
+  }
+
+  for (size_t i = 0; i < FIXED_BASE_TABLE_LEN; ++i) {
+    ptrs[i] = &(points[i]);
+  }
+  blst_p1s_to_affine(table, ptrs, FIXED_BASE_TABLE_LEN);
+
+  free(points);
+  return 1;
+}
+
+/* Build and publish a table for base, caller holds the lock */
+static EIP2537_ERROR blst_p1_fixed_base_add(const blst_p1_affine* base,
+                                            const byte* enc) {
+  size_t n = bls12_g1_num_fixed_bases;
+
+  if (n == FIXED_BASE_MAX) {
+    return EIP2537_FIXED_BASE_LIMIT;
+  }
+
+  blst_p1_affine* table;
+  table = (blst_p1_affine*) malloc(FIXED_BASE_TABLE_LEN *
+                                   sizeof(blst_p1_affine));
+  if (table == NULL) {
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  if (!blst_p1_fixed_base_build(table, base)) {
+    free(table);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  memcpy(bls12_g1_fixed_bases[n].enc, enc, 128);
+  bls12_g1_fixed_bases[n].table = table;
+  BLS12_ATOMIC_STORE_RELEASE(&bls12_g1_num_fixed_bases, n + 1);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Build the generator table on first use, retried if allocation failed */
+static void blst_p1_fixed_base_init() {
+  if (BLS12_ATOMIC_LOAD_ACQUIRE(&bls12_g1_num_fixed_bases) != 0) {
+    return;
+  }
+
+  bls12_spin_lock(&bls12_g1_fixed_base_lock);
+  if (bls12_g1_num_fixed_bases == 0) {
+    byte enc[128];
+    encode_g1_point(enc, blst_p1_affine_generator());
+    blst_p1_fixed_base_add(blst_p1_affine_generator(), enc);
+  }
+  bls12_spin_unlock(&bls12_g1_fixed_base_lock);
+}
+
+/* Table for an encoded G1 point, NULL if it is not a fixed base */
+static const blst_p1_affine* blst_p1_fixed_base_find(const byte* in) {
+  size_t n = BLS12_ATOMIC_LOAD_ACQUIRE(&bls12_g1_num_fixed_bases);
+
+  for (size_t i = 0; i < n; ++i) {
+    if (memcmp(bls12_g1_fixed_bases[i].enc, in, 128) == 0) {
+      return bls12_g1_fixed_bases[i].table;
+    }
+  }
+
+  return NULL;
+}
+
+static const blst_p1_affine* blst_p1_fixed_base_lookup(const byte* in) {
+  blst_p1_fixed_base_init();
+  return blst_p1_fixed_base_find(in);
+}
+
+/* Variable time fixed base multiplication, one table addition per Booth
+   window */
+static void blst_p1_mult_fixed_base(blst_p1* out, const blst_p1_affine* table,
+                                    const blst_scalar* scalar) {
+  blst_p1 result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+
+  for (size_t i = 0; i < FIXED_BASE_NUM_WINDOWS; ++i) {
+    int32_t digit = booth_encode(booth_get_wval(scalar->b,
+                                                i * FIXED_BASE_WINDOW,
+                                                FIXED_BASE_WINDOW),
+                                 FIXED_BASE_WINDOW);
+    const blst_p1_affine* row = table + (i * FIXED_BASE_NUM_ENTRIES);
+
+    if (digit > 0) {
+      blst_p1_add_or_double_affine(&result, &result, &(row[digit - 1]));
+    }
+    else if (digit < 0) {
+      blst_p1_affine neg = row[-digit - 1];
+      blst_fp_cneg(&(neg.y), &(neg.y), 1);
+      blst_p1_add_or_double_affine(&result, &result, &neg);
+    }
+  }
+
+  *out = result;
+}
+
+/* Row entry abs - 1 or infinity (all zero) for abs 0, reading every entry
+   under a mask so the access pattern does not depend on the digit */
+static void blst_p1_fixed_base_select(blst_p1_affine* out,
+                                       const blst_p1_affine* row,
+                                       uint32_t abs) {
+  limb_t* o = (limb_t*)out;
+
+  memset(out, 0, sizeof(blst_p1_affine));
+
+  for (uint32_t j = 0; j < FIXED_BASE_NUM_ENTRIES; ++j) {
+    /* All ones when abs == j + 1, without a branch */
+    const limb_t* r    = (const limb_t*)&(row[j]);
+    uint32_t      eq   = (((abs ^ (j + 1)) - 1) >> 31) & 1;
+    limb_t        mask = (limb_t)0 - (limb_t)eq;
+
+    for (size_t k = 0; k < (sizeof(blst_p1_affine) / sizeof(limb_t)); ++k) {
+      o[k] |= r[k] & mask;
+    }
+  }
+}
+
+/* Constant time fixed base multiplication for when variable time MUL is
+   off, every window selects its entry under a mask and negates it with
+   cneg, a zero digit adds infinity */
+static void blst_p1_mult_fixed_base_ct(blst_p1* out,
+                                        const blst_p1_affine* table,
+                                        const blst_scalar* scalar) {
+  memset(out, 0, sizeof(blst_p1)); /* Infinity */
+
+  for (size_t i = 0; i < FIXED_BASE_NUM_WINDOWS; ++i) {
+    uint32_t wval  = booth_get_wval(scalar->b, i * FIXED_BASE_WINDOW,
+                                    FIXED_BASE_WINDOW);
+    int32_t  digit = booth_encode(wval, FIXED_BASE_WINDOW);
+    uint32_t sign  = (wval >> FIXED_BASE_WINDOW) & 1;
+    uint32_t abs   = (uint32_t)((digit ^ -(int32_t)sign) + (int32_t)sign);
+
+    blst_p1_affine sel;
+    blst_p1_fixed_base_select(&sel, table + (i * FIXED_BASE_NUM_ENTRIES),
+                               abs);
+    blst_fp_cneg(&(sel.y), &(sel.y), sign);
+    blst_p1_add_or_double_affine(out, out, &sel);
+  }
+}
+
+EIP2537_ERROR bls12_g1_add_fixed_base(const byte base[128]) {
+  blst_p1_affine base_aff;
+  EIP2537_ERROR  ret = decode_g1_point_uncached(&base_aff, base);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  if (!blst_p1_affine_in_g1(&base_aff)) {
+    return EIP2537_POINT_NOT_IN_SUBGROUP;
+  }
+
+  /* Multiples of infinity need no table */
+  if (blst_p1_affine_is_inf(&base_aff)) {
+    return EIP2537_SUCCESS;
+  }
+
+  /* Generator keeps the first slot */
+  blst_p1_fixed_base_init();
+
+  bls12_spin_lock(&bls12_g1_fixed_base_lock);
+  if (bls12_g1_num_fixed_bases == 0) {
+    ret = EIP2537_MEMORY_ERROR;
+  }
+  else if (blst_p1_fixed_base_find(base) == NULL) {
+    ret = blst_p1_fixed_base_add(&base_aff, base);
+  }
+  bls12_spin_unlock(&bls12_g1_fixed_base_lock);
+
+  return ret;
+}
+
+/* G2 fixed bases, the generator first then registered bases */
+typedef struct {
+  byte            enc[256];
+  blst_p2_affine* table;
+} blst_p2_fixed_base;
+
+static blst_p2_fixed_base bls12_g2_fixed_bases[FIXED_BASE_MAX];
+static size_t             bls12_g2_num_fixed_bases = 0;
+static byte               bls12_g2_fixed_base_lock = 0;
+
+/* Fill table with j * 2^(i * w) * base for j in [1, 2^(w-1)], window i.
+   Entries are built projective and share one inversion to affine, base must
+   not be infinity */
+static int blst_p2_fixed_base_build(blst_p2_affine* table,
+                                    const blst_p2_affine* base) {
+  blst_p2*        points;
+  const blst_p2** ptrs;
+  points = (blst_p2*) malloc(FIXED_BASE_TABLE_LEN *
+                             (sizeof(blst_p2) + sizeof(blst_p2*)));
+  if (points == NULL) {
+    return 0;
+  }
+  ptrs = (const blst_p2**)(points + FIXED_BASE_TABLE_LEN);
+
+  blst_p2 window_base;
+  blst_p2_from_affine(&window_base, base);
+
+  for (size_t i = 0; i < FIXED_BASE_NUM_WINDOWS; ++i) {
+    blst_p2* row = points + (i * FIXED_BASE_NUM_ENTRIES);
+
+    row[0] = window_base;
+    for (size_t j = 1; j < FIXED_BASE_NUM_ENTRIES; ++j) {
+      blst_p2_add_or_double(&(row[j]), &(row[j - 1]), &window_base);
+    }
+
+    for (size_t k = 0; k < FIXED_BASE_WINDOW; ++k) {
+      blst_p2_double(&window_base, &window_base);
+    }
+  }
+
+  for (size_t i = 0; i < FIXED_BASE_TABLE_LEN; ++i) {
+    ptrs[i] = &(points[i]);
+  }
+  blst_p2s_to_affine(table, ptrs, FIXED_BASE_TABLE_LEN);
+
+  free(points);
+  return 1;
+}
+
+/* Build and publish a table for base, caller holds the lock */
+static EIP2537_ERROR blst_p2_fixed_base_add(const blst_p2_affine* base,
+                                            const byte* enc) {
+  size_t n = bls12_g2_num_fixed_bases;
+
+  if (n == FIXED_BASE_MAX) {
+    return EIP2537_FIXED_BASE_LIMIT;
+  }
+
+  blst_p2_affine* table;
+  table = (blst_p2_affine*) malloc(FIXED_BASE_TABLE_LEN *
+                                   sizeof(blst_p2_affine));
+  if (table == NULL) {
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  if (!blst_p2_fixed_base_build(table, base)) {
+    free(table);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  memcpy(bls12_g2_fixed_bases[n].enc, enc, 256);
+  bls12_g2_fixed_bases[n].table = table;
+  BLS12_ATOMIC_STORE_RELEASE(&bls12_g2_num_fixed_bases, n + 1);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Build the generator table on first use, retried if allocation failed */
+static void blst_p2_fixed_base_init() {
+  if (BLS12_ATOMIC_LOAD_ACQUIRE(&bls12_g2_num_fixed_bases) != 0) {
+    return;
+  }
+
+  bls12_spin_lock(&bls12_g2_fixed_base_lock);
+  if (bls12_g2_num_fixed_bases == 0) {
+    byte enc[256];
+    encode_g2_point(enc, blst_p2_affine_generator());
+    blst_p2_fixed_base_add(blst_p2_affine_generator(), enc);
+  }
+  bls12_spin_unlock(&bls12_g2_fixed_base_lock);
+}
+
+/* Table for an encoded G2 point, NULL if it is not a fixed base */
+static const blst_p2_affine* blst_p2_fixed_base_find(const byte* in) {
+  size_t n = BLS12_ATOMIC_LOAD_ACQUIRE(&bls12_g2_num_fixed_bases);
+
+  for (size_t i = 0; i < n; ++i) {
+    if (memcmp(bls12_g2_fixed_bases[i].enc, in, 256) == 0) {
+      return bls12_g2_fixed_bases[i].table;
+    }
+  }
+
+  return NULL;
+}
+
+static const blst_p2_affine* blst_p2_fixed_base_lookup(const byte* in) {
+  blst_p2_fixed_base_init();
+  return blst_p2_fixed_base_find(in);
+}
+
+/* Variable time fixed base multiplication, one table addition per Booth
+   window */
+static void blst_p2_mult_fixed_base(blst_p2* out, const blst_p2_affine* table,
+                                    const blst_scalar* scalar) {
+  /* Infinity */
+  blst_p2 result = { {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}} };
+
+  for (size_t i = 0; i < FIXED_BASE_NUM_WINDOWS; ++i) {
+    int32_t digit = booth_encode(booth_get_wval(scalar->b,
+                                                i * FIXED_BASE_WINDOW,
+                                                FIXED_BASE_WINDOW),
+                                 FIXED_BASE_WINDOW);
+    const blst_p2_affine* row = table + (i * FIXED_BASE_NUM_ENTRIES);
+
+    if (digit > 0) {
+      blst_p2_add_or_double_affine(&result, &result, &(row[digit - 1]));
+    }
+    else if (digit < 0) {
+      blst_p2_affine neg = row[-digit - 1];
+      blst_fp2_cneg(&(neg.y), &(neg.y), 1);
+      blst_p2_add_or_double_affine(&result, &result, &neg);
+    }
+  }
+
+  *out = result;
+}
+
+/* Row entry abs - 1 or infinity (all zero) for abs 0, reading every entry
+   under a mask so the access pattern does not depend on the digit */
+static void blst_p2_fixed_base_select(blst_p2_affine* out,
+                                       const blst_p2_affine* row,
+                                       uint32_t abs) {
+  limb_t* o = (limb_t*)out;
+
+  memset(out, 0, sizeof(blst_p2_affine));
+
+  for (uint32_t j = 0; j < FIXED_BASE_NUM_ENTRIES; ++j) {
+    /* All ones when abs == j + 1, without a branch */
+    const limb_t* r    = (const limb_t*)&(row[j]);
+    uint32_t      eq   = (((abs ^ (j + 1)) - 1) >> 31) & 1;
+    limb_t        mask = (limb_t)0 - (limb_t)eq;
+
+    for (size_t k = 0; k < (sizeof(blst_p2_affine) / sizeof(limb_t)); ++k) {
+      o[k] |= r[k] & mask;
+    }
+  }
+}
+
+/* Constant time fixed base multiplication for when variable time MUL is
+   off, every window selects its entry under a mask and negates it with
+   cneg, a zero digit adds infinity */
+static void blst_p2_mult_fixed_base_ct(blst_p2* out,
+                                        const blst_p2_affine* table,
+                                        const blst_scalar* scalar) {
+  memset(out, 0, sizeof(blst_p2)); /* Infinity */
+
+  for (size_t i = 0; i < FIXED_BASE_NUM_WINDOWS; ++i) {
+    uint32_t wval  = booth_get_wval(scalar->b, i * FIXED_BASE_WINDOW,
+                                    FIXED_BASE_WINDOW);
+    int32_t  digit = booth_encode(wval, FIXED_BASE_WINDOW);
+    uint32_t sign  = (wval >> FIXED_BASE_WINDOW) & 1;
+    uint32_t abs   = (uint32_t)((digit ^ -(int32_t)sign) + (int32_t)sign);
+
+    blst_p2_affine sel;
+    blst_p2_fixed_base_select(&sel, table + (i * FIXED_BASE_NUM_ENTRIES),
+                               abs);
+    blst_fp2_cneg(&(sel.y), &(sel.y), sign);
+    blst_p2_add_or_double_affine(out, out, &sel);
+  }
+}
+
+EIP2537_ERROR bls12_g2_add_fixed_base(const byte base[256]) {
+  blst_p2_affine base_aff;
+  EIP2537_ERROR  ret = decode_g2_point_uncached(&base_aff, base);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  if (!blst_p2_affine_in_g2(&base_aff)) {
+    return EIP2537_POINT_NOT_IN_SUBGROUP;
+  }
+
+  /* Multiples of infinity need no table */
+  if (blst_p2_affine_is_inf(&base_aff)) {
+    return EIP2537_SUCCESS;
+  }
+
+  /* Generator keeps the first slot */
+  blst_p2_fixed_base_init();
+
+  bls12_spin_lock(&bls12_g2_fixed_base_lock);
+  if (bls12_g2_num_fixed_bases == 0) {
+    ret = EIP2537_MEMORY_ERROR;
+  }
+  else if (blst_p2_fixed_base_find(base) == NULL) {
+    ret = blst_p2_fixed_base_add(&base_aff, base);
+  }
+  bls12_spin_unlock(&bls12_g2_fixed_base_lock);
+
+  return ret;
+}
+
+void bls12_fixed_base_init() {
+  blst_p1_fixed_base_init();
+  blst_p2_fixed_base_init();
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+/* Generator tables are built when the library is loaded so the first
+   multiplications do not wait on the build under the table lock */
+__attribute__((constructor)) static void bls12_fixed_base_load() {
+  bls12_fixed_base_init();
+}
+#endif
+
+/* Endomorphism scalar multiplication for points in the subgroups.
+   G1 uses phi(x, y) = (beta * x, y) = [lambda]P with lambda = z^2 - 1 and
+   G2 uses psi (untwist-Frobenius-twist) with psi(P) = [z]P, z = -u below.
+   Sub-scalars are width ENDO_WNAF_WINDOW NAF recoded and the multiples of
+   each base are walked jointly so doublings are shared across them */
+#define ENDO_WNAF_WINDOW     5
+#define ENDO_WNAF_TABLE_LEN  (1 << (ENDO_WNAF_WINDOW - 2))
+#define ENDO_WNAF_MAX_DIGITS (256 + 2)
+
+/* lambda, u = |z| and r as little endian limbs */
+static const uint64_t glv_lambda[2] = {
+  0x00000000ffffffff, 0xac45a4010001a402
+};
+static const uint64_t gls_u[1] = { 0xd201000000010000 };
+static const uint64_t bls12_r[4] = {
+  0xffffffff00000001, 0x53bda402fffe5bfe,
+  0x3339d80809a1d805, 0x73eda753299d7d48
+};
+
+/* beta, a cube root of unity in Fp, and the psi coefficients, not in
+   Montgomery form */
+static const uint64_t glv_beta[6] = {
+  0x8bfd00000000aaac, 0x409427eb4f49fffd, 0x897d29650fb85f9b,
+  0xaa0d857d89759ad4, 0xec02408663d4de85, 0x1a0111ea397fe699
+};
+static const uint64_t gls_cx1[6] = {
+  0x8bfd00000000aaad, 0x409427eb4f49fffd, 0x897d29650fb85f9b,
+  0xaa0d857d89759ad4, 0xec02408663d4de85, 0x1a0111ea397fe699
+};
+static const uint64_t gls_cy0[6] = {
+  0xf1ee7b04121bdea2, 0x304466cf3e67fa0a, 0xef396489f61eb45e,
+  0x1c3dedd930b1cf60, 0xe2e9c448d77a2cd9, 0x135203e60180a68e
+};
+static const uint64_t gls_cy1[6] = {
+  0xc81084fbede3cc09, 0xee67992f72ec05f4, 0x77f76e17009241c5,
+  0x48395dabc2d3435e, 0x6831e36d6bd17ffe, 0x06af0e0437ff400b
+};
+
+/* Little endian scalar bytes into 64 bit limbs */
+static void limbs_from_scalar(uint64_t out[4], const blst_scalar* k) {
+  for (size_t i = 0; i < 4; i++) {
+    out[i] = 0;
+    for (size_t j = 0; j < 8; j++) {
+      out[i] |= (uint64_t)k->b[(i * 8) + j] << (j * 8);
+    }
+  }
+}
+
+static int limbs_geq(const uint64_t* a, const uint64_t* b, size_t num_limbs) {
+  for (size_t i = num_limbs; i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] > b[i];
+    }
+  }
+  return 1;
+}
+
+static void limbs_sub(uint64_t* a, const uint64_t* b, size_t num_limbs) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < num_limbs; i++) {
+    uint64_t t = a[i] - b[i];
+    uint64_t next_borrow = (a[i] < b[i]) | (t < borrow);
+    a[i] = t - borrow;
+    borrow = next_borrow;
+  }
+}
+
+static int limbs_is_zero(const uint64_t* a, size_t num_limbs) {
+  uint64_t acc = 0;
+  for (size_t i = 0; i < num_limbs; i++) {
+    acc |= a[i];
+  }
+  return acc == 0;
+}
+
+static size_t limbs_num_bits(const uint64_t* a, size_t num_limbs) {
+  for (size_t i = num_limbs; i-- > 0;) {
+    for (size_t bit = 64; bit-- > 0;) {
+      if ((a[i] >> bit) & 1) {
+        return (i * 64) + bit + 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/* Bit serial long division, q = n / d and rem = n % d. Divisors are public
+   constants of up to 3 limbs, rem needs d_limbs + 1 limbs */
+static void limbs_divrem(uint64_t* q, uint64_t* rem, const uint64_t* n,
+                         size_t n_limbs, const uint64_t* d, size_t d_limbs) {
+  uint64_t d_ext[4] = { 0 };
+  memcpy(d_ext, d, d_limbs * sizeof(uint64_t));
+
+  memset(q, 0, n_limbs * sizeof(uint64_t));
+  memset(rem, 0, (d_limbs + 1) * sizeof(uint64_t));
+
+  for (size_t bit = n_limbs * 64; bit-- > 0;) {
+    for (size_t i = d_limbs; i > 0; i--) {
+      rem[i] = (rem[i] << 1) | (rem[i - 1] >> 63);
+    }
+    rem[0] = (rem[0] << 1) | ((n[bit / 64] >> (bit % 64)) & 1);
+
+    if (limbs_geq(rem, d_ext, d_limbs + 1)) {
+      limbs_sub(rem, d_ext, d_limbs + 1);
+      q[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+  }
+}
+
+/* Width window NAF of an up to 4 limb number, least significant digit
+   first, returns the number of digits */
+static size_t wnaf_encode(int8_t* naf, const uint64_t* k_in, size_t k_limbs,
+                          size_t window) {
+  const int32_t full = 1 << window;
+  const int32_t half = 1 << (window - 1);
+
+  /* Extra limb absorbs the carry from negative digits */
+  uint64_t k[5] = { 0 };
+  memcpy(k, k_in, k_limbs * sizeof(uint64_t));
+
+  size_t len = 0;
+  while (!limbs_is_zero(k, 5)) {
+    int32_t digit = 0;
+    if (k[0] & 1) {
+      digit = (int32_t)(k[0] & (uint64_t)(full - 1));
+      if (digit >= half) {
+        digit -= full;
+      }
+
+      if (digit > 0) {
+        k[0] -= (uint64_t)digit;
+      }
+      else {
+        uint64_t carry = (uint64_t)(-digit);
+        for (size_t i = 0; i < 5 && carry != 0; i++) {
+          k[i] += carry;
+          carry = k[i] < carry;
+        }
+      }
+    }
+    naf[len++] = (int8_t)digit;
+
+    for (size_t i = 0; i < 4; i++) {
+      k[i] = (k[i] >> 1) | (k[i + 1] << 63);
+    }
+    k[4] >>= 1;
+  }
+
+  return len;
+}
+
+/* Sum of [k_i]P_i from NAF digits and odd multiple tables of each P_i,
+   tables[i * ENDO_WNAF_TABLE_LEN + j] = (2j + 1)P_i */
+static void blst_p1s_mult_wnaf(blst_p1* out, const blst_p1* tables,
+                               const int8_t* nafs, const size_t* lens,
+                               size_t num_points) {
+  size_t max_len = 0;
+  for (size_t i = 0; i < num_points; i++) {
+    if (lens[i] > max_len) {
+      max_len = lens[i];
+    }
+  }
+
+  blst_p1 result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+  for (size_t bit = max_len; bit-- > 0;) {
+    blst_p1_double(&result, &result);
+
+    for (size_t i = 0; i < num_points; i++) {
+      if (bit >= lens[i]) {
+        continue;
+      }
+
+      int8_t digit = nafs[(i * ENDO_WNAF_MAX_DIGITS) + bit];
+      if (digit > 0) {
+        blst_p1_add_or_double(&result, &result,
+                              &(tables[(i * ENDO_WNAF_TABLE_LEN) +
+                                       (digit >> 1)]));
+      }
+      else if (digit < 0) {
+        blst_p1 neg = tables[(i * ENDO_WNAF_TABLE_LEN) + ((-digit) >> 1)];
+        blst_p1_cneg(&neg, 1);
+        blst_p1_add_or_double(&result, &result, &neg);
+      }
+    }
+  }
+
+  *out = result;
+}
+
+/* Odd multiples P, 3P, ..., (2 * len - 1)P */
+static void blst_p1_wnaf_table(blst_p1* table, const blst_p1* p,
+                               size_t len) {
+  table[0] = *p;
+  if (len < 2) {
+    return;
+  }
+
+  blst_p1 twice;
+  blst_p1_double(&twice, p);
+
+  for (size_t j = 1; j < len; j++) {
+    blst_p1_add_or_double(&(table[j]), &(table[j - 1]), &twice);
+  }
+}
+
+/* k = k1 + k2 * lambda with k1 under 128 bits and k2 under 130 bits, no
+   reduction mod r is needed for P in G1 */
+static void blst_p1_glv_split(uint64_t k1[3], uint64_t k2[4],
+                              const blst_scalar* scalar) {
+  uint64_t k[4];
+  limbs_from_scalar(k, scalar);
+  limbs_divrem(k2, k1, k, 4, glv_lambda, 2);
+}
+
+/* Odd multiple tables of P and phi(P), len entries each at a stride of
+   ENDO_WNAF_TABLE_LEN */
+static void blst_p1_glv_tables(blst_p1* tables, const blst_p1_affine* p,
+                               size_t len) {
+  blst_p1 a;
+  blst_p1_from_affine(&a, p);
+  blst_p1_wnaf_table(tables, &a, len);
+
+  /* phi is (beta * X, Y, Z) in Jacobian coordinates too */
+  blst_fp beta;
+  blst_fp_from_uint64(&beta, glv_beta);
+  for (size_t j = 0; j < len; j++) {
+    tables[ENDO_WNAF_TABLE_LEN + j] = tables[j];
+    blst_fp_mul(&(tables[ENDO_WNAF_TABLE_LEN + j].x), &(tables[j].x), &beta);
+  }
+}
+
+/* [k]P for P in G1 as [k1]P + [k2]phi(P) */
+static void blst_p1_mult_glv(blst_p1* out, const blst_p1_affine* p,
+                             const blst_scalar* scalar) {
+  uint64_t k1[3], k2[4];
+  blst_p1_glv_split(k1, k2, scalar);
+
+  int8_t nafs[2 * ENDO_WNAF_MAX_DIGITS];
+  size_t lens[2];
+  lens[0] = wnaf_encode(nafs, k1, 3, ENDO_WNAF_WINDOW);
+  lens[1] = wnaf_encode(nafs + ENDO_WNAF_MAX_DIGITS, k2, 4, ENDO_WNAF_WINDOW);
+
+  blst_p1 tables[2 * ENDO_WNAF_TABLE_LEN];
+  blst_p1_glv_tables(tables, p, ENDO_WNAF_TABLE_LEN);
+
+  blst_p1s_mult_wnaf(out, tables, nafs, lens, 2);
+}
+
+static void blst_p2s_mult_wnaf(blst_p2* out, const blst_p2* tables,
+                               const int8_t* nafs, const size_t* lens,
+                               size_t num_points) {
+  size_t max_len = 0;
+  for (size_t i = 0; i < num_points; i++) {
+    if (lens[i] > max_len) {
+      max_len = lens[i];
+    }
+  }
+
+  /* Infinity */
+  blst_p2 result = { {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}} };
+  for (size_t bit = max_len; bit-- > 0;) {
+    blst_p2_double(&result, &result);
+
+    for (size_t i = 0; i < num_points; i++) {
+      if (bit >= lens[i]) {
+        continue;
+      }
+
+      int8_t digit = nafs[(i * ENDO_WNAF_MAX_DIGITS) + bit];
+      if (digit > 0) {
+        blst_p2_add_or_double(&result, &result,
+                              &(tables[(i * ENDO_WNAF_TABLE_LEN) +
+                                       (digit >> 1)]));
+      }
+      else if (digit < 0) {
+        blst_p2 neg = tables[(i * ENDO_WNAF_TABLE_LEN) + ((-digit) >> 1)];
+        blst_p2_cneg(&neg, 1);
+        blst_p2_add_or_double(&result, &result, &neg);
+      }
+    }
+  }
+
+  *out = result;
+}
+
+static void blst_p2_wnaf_table(blst_p2* table, const blst_p2* p,
+                               size_t len) {
+  table[0] = *p;
+  if (len < 2) {
+    return;
+  }
+
+  blst_p2 twice;
+  blst_p2_double(&twice, p);
+
+  for (size_t j = 1; j < len; j++) {
+    blst_p2_add_or_double(&(table[j]), &(table[j - 1]), &twice);
+  }
+}
+
+/* psi in Jacobian coordinates, (conj(X) * cx, conj(Y) * cy, conj(Z)) */
+static void blst_p2_psi(blst_p2* out, const blst_p2* in, const blst_fp2* cx,
+                        const blst_fp2* cy) {
+  blst_p2 t = *in;
+  blst_fp_cneg(&(t.x.fp[1]), &(t.x.fp[1]), 1);
+  blst_fp_cneg(&(t.y.fp[1]), &(t.y.fp[1]), 1);
+  blst_fp_cneg(&(t.z.fp[1]), &(t.z.fp[1]), 1);
+
+  blst_fp2_mul(&(out->x), &(t.x), cx);
+  blst_fp2_mul(&(out->y), &(t.y), cy);
+  out->z = t.z;
+}
+
+/* k mod r = a0 + a1 u + a2 u^2 + a3 u^3 with 64 bit digits */
+static void blst_p2_gls_split(uint64_t digits[4], const blst_scalar* scalar) {
+  uint64_t k[4];
+  limbs_from_scalar(k, scalar);
+  while (limbs_geq(k, bls12_r, 4)) {
+    limbs_sub(k, bls12_r, 4);
+  }
+
+  for (size_t i = 0; i < 4; i++) {
+    uint64_t q[4], digit[2];
+    limbs_divrem(q, digit, k, 4, gls_u, 1);
+    digits[i] = digit[0];
+    memcpy(k, q, sizeof(k));
+  }
+}
+
+/* Odd multiple tables of P, -psi(P), psi^2(P) and -psi^3(P), len entries
+   each at a stride of ENDO_WNAF_TABLE_LEN. As psi(P) = [-u]P odd powers of
+   psi carry a negative sign */
+static void blst_p2_gls_tables(blst_p2* tables, const blst_p2_affine* p,
+                               size_t len) {
+  blst_fp2 cx, cy;
+  memset(&(cx.fp[0]), 0, sizeof(blst_fp));
+  blst_fp_from_uint64(&(cx.fp[1]), gls_cx1);
+  blst_fp_from_uint64(&(cy.fp[0]), gls_cy0);
+  blst_fp_from_uint64(&(cy.fp[1]), gls_cy1);
+
+  blst_p2 a;
+  blst_p2_from_affine(&a, p);
+  blst_p2_wnaf_table(tables, &a, len);
+
+  for (size_t i = 1; i < 4; i++) {
+    for (size_t j = 0; j < len; j++) {
+      blst_p2_psi(&(tables[(i * ENDO_WNAF_TABLE_LEN) + j]),
+                  &(tables[((i - 1) * ENDO_WNAF_TABLE_LEN) + j]), &cx, &cy);
+    }
+  }
+
+  for (size_t i = 1; i < 4; i += 2) {
+    for (size_t j = 0; j < len; j++) {
+      blst_p2_cneg(&(tables[(i * ENDO_WNAF_TABLE_LEN) + j]), 1);
+    }
+  }
+}
+
+/* [k]P for P in G2 as a0 P - a1 psi(P) + a2 psi^2(P) - a3 psi^3(P) */
+static void blst_p2_mult_gls(blst_p2* out, const blst_p2_affine* p,
+                             const blst_scalar* scalar) {
+  uint64_t digits[4];
+  blst_p2_gls_split(digits, scalar);
+
+  int8_t nafs[4 * ENDO_WNAF_MAX_DIGITS];
+  size_t lens[4];
+  for (size_t i = 0; i < 4; i++) {
+    lens[i] = wnaf_encode(nafs + (i * ENDO_WNAF_MAX_DIGITS), &(digits[i]), 1,
+                          ENDO_WNAF_WINDOW);
+  }
+
+  blst_p2 tables[4 * ENDO_WNAF_TABLE_LEN];
+  blst_p2_gls_tables(tables, p, ENDO_WNAF_TABLE_LEN);
+
+  blst_p2s_mult_wnaf(out, tables, nafs, lens, 4);
+}
+
+/* Variable time multiplication for MUL, inputs are public so the cost can
+   follow the scalar length. On unless built with __EIP2537_CT_MUL__ */
+#ifdef __EIP2537_CT_MUL__
+static int bls12_mul_vartime = 0;
+#else
+static int bls12_mul_vartime = 1;
+#endif
+
+void bls12_mul_set_vartime(int enable) {
+  BLS12_ATOMIC_STORE(&bls12_mul_vartime, (enable != 0));
+}
+
+/* Short scalars get a narrower window so the table does not dominate */
+static size_t vartime_wnaf_window(int num_bits) {
+  if (num_bits <= 8) {
+    return 2;
+  }
+  if (num_bits <= 32) {
+    return 3;
+  }
+  if (num_bits <= 96) {
+    return 4;
+  }
+  return ENDO_WNAF_WINDOW;
+}
+
+static void blst_p1_mult_vartime(blst_p1* out, const blst_p1_affine* p,
+                                 const blst_scalar* scalar) {
+  size_t window = vartime_wnaf_window(blst_scalar_num_bits(scalar));
+
+  uint64_t k[4];
+  limbs_from_scalar(k, scalar);
+
+  int8_t naf[ENDO_WNAF_MAX_DIGITS];
+  size_t len = wnaf_encode(naf, k, 4, window);
+
+  blst_p1 table[ENDO_WNAF_TABLE_LEN];
+  blst_p1 a;
+  blst_p1_from_affine(&a, p);
+  blst_p1_wnaf_table(table, &a, (size_t)1 << (window - 2));
+
+  blst_p1s_mult_wnaf(out, table, naf, &len, 1);
+}
+
+static void blst_p2_mult_vartime(blst_p2* out, const blst_p2_affine* p,
+                                 const blst_scalar* scalar) {
+  size_t window = vartime_wnaf_window(blst_scalar_num_bits(scalar));
+
+  uint64_t k[4];
+  limbs_from_scalar(k, scalar);
+
+  int8_t naf[ENDO_WNAF_MAX_DIGITS];
+  size_t len = wnaf_encode(naf, k, 4, window);
+
+  blst_p2 table[ENDO_WNAF_TABLE_LEN];
+  blst_p2 a;
+  blst_p2_from_affine(&a, p);
+  blst_p2_wnaf_table(table, &a, (size_t)1 << (window - 2));
+
+  blst_p2s_mult_wnaf(out, table, naf, &len, 1);
+}
+
+/*
+  ABI for G1 addition
+
+  G1 addition call expects 256 bytes as an input that is interpreted as byte
+    concatenation of two G1 points (128 bytes each). Output is an encoding of
+    addition operation result - single G1 point (128 bytes).
+
+  Error cases:
+    Either of points being not on the curve must result in error
+    Field elements encoding rules apply (obviously)
+    Input has invalid length
+*/
+static EIP2537_ERROR bls12_g1add_projective(blst_p1* out, const byte* in,
+                                            size_t in_len) {
+  /* Check length, is this even necessary? */
+  if (in_len != 256) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret;
+
+  /* Decode inputs */
+  blst_p1_affine a_aff;
+  ret = decode_g1_point(&a_aff, in);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  blst_p1_affine b_aff;
+  ret = decode_g1_point(&b_aff, in + 128);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* One of the inputs needs to be projective for point addition function */
+  blst_p1 b;
+  blst_p1_from_affine(&b, &b_aff);
+
+  /* P = A + B */
+  blst_p1_add_or_double_affine(out, &b, &a_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_g1add(byte out[128], const byte in[256], size_t in_len) {
+  blst_p1 p;
+  EIP2537_ERROR ret = bls12_g1add_projective(&p, in, in_len);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* Convert point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &p);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+/* 
+  ABI for G1 multiplication
+
+  G1 multiplication call expects 160 bytes as an input that is interpreted as
+    byte concatenation of encoding of G1 point (128 bytes) and encoding of a
+    scalar value (32 bytes). Output is an encoding of multiplication operation
+    result - single G1 point (128 bytes).
+
+  Error cases:
+    Point being not on the curve must result in error
+    Field elements encoding rules apply (obviously)
+    Input has invalid length
+
+*/
+static EIP2537_ERROR bls12_g1mul_projective(blst_p1* out, const byte* in,
+                                            size_t in_len) {
+  /* Check length, is this even necessary? */
+  if (in_len != 160) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret;
+
+  /* Generator and registered bases already validated, use their tables */
+  const blst_p1_affine* table = blst_p1_fixed_base_lookup(in);
+
+  /* Decode inputs */
+  blst_p1_affine a_aff;
+  if (table == NULL) {
+    ret = decode_g1_point(&a_aff, in);
+    if (ret != EIP2537_SUCCESS) {
+      return ret;
+    }
+  }
+
+  blst_scalar scalar;
+  ret = decode_scalar(&scalar, in + 128);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* P = A * scalar, fixed bases walk their table in constant time when
+     variable time MUL is off */
+  int vartime = BLS12_ATOMIC_LOAD(&bls12_mul_vartime);
+  if ((table != NULL) && vartime) {
+    blst_p1_mult_fixed_base(out, table, &scalar);
+  }
+  else if (table != NULL) {
+    blst_p1_mult_fixed_base_ct(out, table, &scalar);
+  }
+  else if (vartime) {
+    blst_p1_mult_vartime(out, &a_aff, &scalar);
+  }
+  else {
+    /* Input needs to be projective for scalar multiplication function */
+    blst_p1 a;
+    blst_p1_from_affine(&a, &a_aff);
+
+    blst_p1_mult(out, &a, scalar.b, 256);
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_g1mul(byte out[128], const byte in[160], size_t in_len) {
+  blst_p1 p;
+  EIP2537_ERROR ret = bls12_g1mul_projective(&p, in, in_len);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* Convert point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &p);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+/* G1 multiplication through the GLV endomorphism for points in G1, other
+   points on the curve take the regular double and add path. The subgroup
+   check costs more than GLV saves, a loss against bls12_g1mul unless the
+   point cache holds the verdict */
+EIP2537_ERROR bls12_g1mul_glv(byte out[128], const byte in[160],
+                              size_t in_len) {
+  /* Check length, is this even necessary? */
+  if (in_len != 160) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Decode inputs, the subgroup verdict comes from the cache when enabled */
+  blst_p1_affine a_aff;
+  EIP2537_ERROR ret = decode_g1_point_in_g1(&a_aff, in);
+  if ((ret != EIP2537_SUCCESS) && (ret != EIP2537_POINT_NOT_IN_SUBGROUP)) {
+    return ret;
+  }
+  int in_group = (ret == EIP2537_SUCCESS);
+
+  blst_scalar scalar;
+  ret = decode_scalar(&scalar, in + 128);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* P = A * scalar */
+  blst_p1 p;
+  if (in_group) {
+    blst_p1_mult_glv(&p, &a_aff, &scalar);
+  }
+  else {
+    blst_p1 a;
+    blst_p1_from_affine(&a, &a_aff);
+
+    blst_p1_mult(&p, &a, scalar.b, 256);
+  }
+
+  /* Convert point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &p);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Batched ADD/MUL, each chunk of results shares one inversion to affine */
+#define BLS12_BATCH_CHUNK 64
+
+typedef EIP2537_ERROR (*blst_p1_op)(blst_p1* out, const byte* in,
+                                     size_t in_len);
+
+/* Run op over n independent inputs, failed calls and points at infinity are
+   left as zeros and the rest converted to affine with one inversion per
+   chunk. Returns the error of the first failed call */
+static EIP2537_ERROR blst_p1s_batch(byte* out, EIP2537_ERROR* errs,
+                                    const byte* const* in,
+                                    const size_t* in_len, size_t n,
+                                    blst_p1_op op) {
+  blst_p1        points[BLS12_BATCH_CHUNK];
+  const blst_p1* finite[BLS12_BATCH_CHUNK];
+  blst_p1_affine affine[BLS12_BATCH_CHUNK];
+  size_t         index[BLS12_BATCH_CHUNK];
+
+  EIP2537_ERROR ret = EIP2537_SUCCESS;
+
+  for (size_t start = 0; start < n; start += BLS12_BATCH_CHUNK) {
+    size_t num_calls  = n - start;
+    size_t num_finite = 0;
+    if (num_calls > BLS12_BATCH_CHUNK) {
+      num_calls = BLS12_BATCH_CHUNK;
+    }
+
+    for (size_t i = 0; i < num_calls; ++i) {
+      size_t call = start + i;
+      memset(out + (call * 128), 0, 128);
+
+      errs[call] = op(&(points[i]), in[call], in_len[call]);
+      if (errs[call] != EIP2537_SUCCESS) {
+        if (ret == EIP2537_SUCCESS) {
+          ret = errs[call];
+        }
+        continue;
+      }
+
+      /* Infinity encodes as zeros and would zero the shared inverse */
+      if (!blst_p1_is_inf(&(points[i]))) {
+        finite[num_finite] = &(points[i]);
+        index[num_finite]  = call;
+        ++num_finite;
+      }
+    }
+
+    if (num_finite == 0) {
+      continue;
+    }
+
+    /* Montgomery batch inversion of all Z coordinates in the chunk */
+    blst_p1s_to_affine(affine, finite, num_finite);
+
+    for (size_t i = 0; i < num_finite; ++i) {
+      encode_g1_point(out + (index[i] * 128), &(affine[i]));
+    }
+  }
+
+  return ret;
+}
+
+/* Batched G1 addition, n inputs of 256 bytes each with 128 byte outputs
+   written back to back in out and per call errors in errs */
+EIP2537_ERROR bls12_g1add_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n) {
+  return blst_p1s_batch(out, errs, in, in_len, n, bls12_g1add_projective);
+}
+
+/* Batched G1 multiplication, as bls12_g1add_batch with 160 byte inputs */
+EIP2537_ERROR bls12_g1mul_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n) {
+  return blst_p1s_batch(out, errs, in, in_len, n, bls12_g1mul_projective);
+}
+
+/*
+  ABI for G1 multiexponentiation
+
+  G1 multiexponentiation call expects 160*k bytes as an input that is
+    interpreted as byte concatenation of k slices each of them being a byte
+    concatenation of encoding of G1 point (128 bytes) and encoding of a scalar
+    value (32 bytes). Output is an encoding of multiexponentiation operation
+    result - single G1 point (128 bytes).
+
+  Error cases:
+    Any of G1 points being not on the curve must result in error
+    Field elements encoding rules apply (obviously)
+    Input has invalid length
+    Input is empty
+*/
+EIP2537_ERROR bls12_g1multiexp(byte out[128], byte* in, size_t in_len) {
+  return bls12_g1multiexp_with_scratch(out, in, in_len, NULL, 0);
+}
+
+/* Scratch for any engine bls12_g1multiexp may select, so the buffer stays
+   valid when the selection table changes or gets calibrated */
+size_t bls12_g1multiexp_scratch_size(size_t in_len) {
+  size_t size = bls12_g1multiexp_bc_scratch_size(in_len);
+
+  if (size < bls12_g1multiexp_straus_scratch_size(in_len)) {
+    size = bls12_g1multiexp_straus_scratch_size(in_len);
+  }
+  if (size < bls12_g1multiexp_pippenger_scratch_size(in_len)) {
+    size = bls12_g1multiexp_pippenger_scratch_size(in_len);
+  }
+
+  return size;
+}
+
+/* Run a given engine, naive needs no scratch */
+static EIP2537_ERROR bls12_g1multiexp_engine(bls12_msm_engine engine,
+                                             byte out[128], byte* in,
+                                             size_t in_len, void* scratch,
+                                             size_t scratch_len) {
+  switch (engine) {
+    case BLS12_MSM_BC:
+      return bls12_g1multiexp_bc_with_scratch(out, in, in_len, scratch,
+                                              scratch_len);
+    case BLS12_MSM_STRAUS:
+      return bls12_g1multiexp_straus_with_scratch(out, in, in_len, scratch,
+                                                  scratch_len);
+    case BLS12_MSM_PIPPENGER:
+      return bls12_g1multiexp_pippenger_with_scratch(out, in, in_len, scratch,
+                                                     scratch_len);
+    default:
+      return bls12_g1multiexp_naive(out, in, in_len);
+  }
+}
+
+EIP2537_ERROR bls12_g1multiexp_with_scratch(byte out[128], byte* in,
+                                           size_t in_len, void* scratch,
+                                           size_t scratch_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 160) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 160;
+
+  if (num_pairs == 1) {
+    return bls12_g1mul(out, in, in_len);
+  }
+
+  /* Engine from the selection table, calibrated or default */
+  return bls12_g1multiexp_engine(bls12_msm_select(&bls12_g1_msm_selection,
+                                                   num_pairs),
+                                 out, in, in_len, scratch, scratch_len);
+}
+
+/* Naive implementation of MSM */
+EIP2537_ERROR bls12_g1multiexp_naive(byte out[128], byte* in, size_t in_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 160) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 160;
+
+  if (num_pairs == 1) {
+    return bls12_g1mul(out, in, in_len);
+  }
+
+  EIP2537_ERROR ret;
+  blst_p1 result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+
+  for (size_t i = 0; i < num_pairs; ++i) {
+    /* Decode inputs */
+    blst_p1_affine a_aff;
+    ret = decode_g1_point(&a_aff, in);
+    if (ret != EIP2537_SUCCESS) {
+      return ret;
+    }
+
+    blst_scalar scalar;
+    ret = decode_scalar(&scalar, in + 128);
+    if (ret != EIP2537_SUCCESS) {
+      return ret;
+    }
+
+    in += 160;
+
+    /* Input needs to be projective for scalar multiplication function */
+    blst_p1 a;
+    blst_p1_from_affine(&a, &a_aff);
+
+    /* P = A * scalar */
+    blst_p1 p;
+    blst_p1_mult(&p, &a, scalar.b, 256);
+
+    /* result = result + P */
+    blst_p1_add_or_double(&result, &result, &p);
+  }
+
+  /* Convert result point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Scratch for Straus, odd multiple tables, NAF lengths and digits for up to
+   two points (P and phi(P)) per pair */
+static size_t blst_p1s_straus_scratch_size(size_t num_pairs) {
+  return 2 * num_pairs * ((ENDO_WNAF_TABLE_LEN * sizeof(blst_p1)) +
+                          sizeof(size_t) + ENDO_WNAF_MAX_DIGITS);
+}
+
+size_t bls12_g1multiexp_straus_scratch_size(size_t in_len) {
+  if ((in_len == 0) || ((in_len % 160) != 0) || (in_len == 160)) {
+    return 0;
+  }
+  return bls12_scratch_padded(blst_p1s_straus_scratch_size(in_len / 160));
+}
+
+/* Straus (interleaved wNAF) implementation of MSM, one doubling chain shared
+   by all pairs with each pair's window following its scalar length */
+EIP2537_ERROR bls12_g1multiexp_straus(byte out[128], byte* in,
+                                      size_t in_len) {
+  return bls12_g1multiexp_straus_with_scratch(out, in, in_len, NULL, 0);
+}
+
+EIP2537_ERROR bls12_g1multiexp_straus_with_scratch(byte out[128],
+                                                   byte* in, size_t in_len,
+                                                   void* scratch,
+                                                   size_t scratch_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 160) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 160;
+
+  if (num_pairs == 1) {
+    return bls12_g1mul(out, in, in_len);
+  }
+
+  /* Tables, NAF lengths and digits live in the scratch */
+  byte* owned;
+  byte* mem = bls12_scratch_get(scratch, scratch_len,
+                                blst_p1s_straus_scratch_size(num_pairs),
+                                &owned);
+  if (mem == NULL) {
+    free(owned);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  blst_p1* tables = (blst_p1*)mem;
+  size_t*  lens   = (size_t*)(tables + (2 * num_pairs * ENDO_WNAF_TABLE_LEN));
+  int8_t*  nafs   = (int8_t*)(lens + (2 * num_pairs));
+  size_t   num_points = 0;
+
+  EIP2537_ERROR ret;
+
+  blst_p1_affine points[POINT_DECODE_BLOCK];
+  byte           states[POINT_DECODE_BLOCK];
+
+  /* Decode inputs, recode scalars and build odd multiple tables. Points the
+     cache already knows to be in G1 enter as P and phi(P) with the GLV
+     halves of the scalar, so they only add to half of the doubling chain */
+  for (size_t i = 0; i < num_pairs; ++i) {
+    size_t b = i % POINT_DECODE_BLOCK;
+    if (b == 0) {
+      size_t num = num_pairs - i;
+      if (num > POINT_DECODE_BLOCK) {
+        num = POINT_DECODE_BLOCK;
+      }
+
+      ret = decode_g1_points(points, in, 160, num, states);
+      if (ret != EIP2537_SUCCESS) {
+        free(owned);
+        return ret;
+      }
+    }
+
+    const blst_p1_affine* a_aff    = &(points[b]);
+    int                   in_group = (states[b] == POINT_CACHE_IN_GROUP);
+
+    blst_scalar scalar;
+    ret = decode_scalar(&scalar, in + 128);
+    if (ret != EIP2537_SUCCESS) {
+      free(owned);
+      return ret;
+    }
+
+    in += 160;
+
+    int8_t*  naf   = nafs + (num_points * ENDO_WNAF_MAX_DIGITS);
+    blst_p1* table = tables + (num_points * ENDO_WNAF_TABLE_LEN);
+
+    if (in_group) {
+      uint64_t k1[3], k2[4];
+      blst_p1_glv_split(k1, k2, &scalar);
+
+      size_t num_bits = limbs_num_bits(k2, 4);
+      if (num_bits < limbs_num_bits(k1, 3)) {
+        num_bits = limbs_num_bits(k1, 3);
+      }
+      size_t window = vartime_wnaf_window((int)num_bits);
+
+      lens[num_points]     = wnaf_encode(naf, k1, 3, window);
+      lens[num_points + 1] = wnaf_encode(naf + ENDO_WNAF_MAX_DIGITS, k2, 4,
+                                         window);
+      blst_p1_glv_tables(table, a_aff, (size_t)1 << (window - 2));
+      num_points += 2;
+      continue;
+    }
+
+    size_t window = vartime_wnaf_window(blst_scalar_num_bits(&scalar));
+
+    uint64_t k[4];
+    limbs_from_scalar(k, &scalar);
+    lens[num_points] = wnaf_encode(naf, k, 4, window);
+
+    blst_p1 a;
+    blst_p1_from_affine(&a, a_aff);
+    blst_p1_wnaf_table(table, &a, (size_t)1 << (window - 2));
+    num_points++;
+  }
+
+  /* P = sum of A_i * scalar_i */
+  blst_p1 result;
+  blst_p1s_mult_wnaf(&result, tables, nafs, lens, num_points);
+
+  /* Convert result point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  /* Free allocated memory */
+  free(owned);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Scratch for Bos-Coster, modifiable bases and the scalar heap */
+static size_t blst_p1s_bc_scratch_size(size_t num_pairs) {
+  return num_pairs * (sizeof(blst_p1) + sizeof(blst_msm_scalar));
+}
+
+size_t bls12_g1multiexp_bc_scratch_size(size_t in_len) {
+  if ((in_len == 0) || ((in_len % 160) != 0) || (in_len == 160)) {
+    return 0;
+  }
+  return bls12_scratch_padded(blst_p1s_bc_scratch_size(in_len / 160));
+}
+
+/* Bos-Coster implementation of MSM */
+EIP2537_ERROR bls12_g1multiexp_bc(byte out[128], byte* in, size_t in_len) {
+  return bls12_g1multiexp_bc_with_scratch(out, in, in_len, NULL, 0);
+}
+
+EIP2537_ERROR bls12_g1multiexp_bc_with_scratch(byte out[128], byte* in,
+                                              size_t in_len, void* scratch,
+                                              size_t scratch_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 160) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 160;
+
+  if (num_pairs == 1) {
+    return bls12_g1mul(out, in, in_len);
+  }
+
+  /* Scalars and bases live in the scratch */
+  byte* owned;
+  byte* mem = bls12_scratch_get(scratch, scratch_len,
+                                blst_p1s_bc_scratch_size(num_pairs), &owned);
+  if (mem == NULL) {
+    free(owned);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  blst_p1*         bases   = (blst_p1*)mem;
+  blst_msm_scalar* scalars = (blst_msm_scalar*)(bases + num_pairs);
+
+  EIP2537_ERROR ret;
+
+  /* Decode all inputs and copy into arrays that can be modified */
+  for (size_t i = 0; i < num_pairs; ++i) {
+    /* Decode inputs */
+    blst_p1_affine a_aff;
+    ret = decode_g1_point(&a_aff, in);
+    if (ret != EIP2537_SUCCESS) {
+      free(owned);
+      return ret;
+    }
+
+    /* Input needs to be projective for scalar multiplication function */
+    blst_p1_from_affine(&(bases[i]), &a_aff);
+
+    ret = decode_scalar(&(scalars[i].k), in + 128);
+    if (ret != EIP2537_SUCCESS) {
+      free(owned);
+      return ret;
+    }
+    scalars[i].base_index = i;
+
+    in += 160;
+  }
+
+  /* Build heap */
+  blst_scalars_max_heapify(scalars, num_pairs);
+
+  blst_p1 skipped_result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+
+  /* Loop until there is only one pair left */
+  while (blst_scalars_max_heapreplace_p1(&skipped_result, bases,
+                                         scalars, num_pairs));
+
+  /* Down to only one point/scalar pair, perform final scalar mul */
+
+  int num_bits_left = blst_scalar_num_bits(&(scalars[0].k));
+  blst_p1 result;
+  blst_p1_mult(&result, &(bases[scalars[0].base_index]),
+               (scalars[0].k).b, num_bits_left);
+
+  /* In case any values needed to be skipped over in bc due to deltas */
+  if (!blst_p1_is_inf(&skipped_result)) {
+    /* result = result + skipped_result */
+    blst_p1_add_or_double(&result, &result, &skipped_result);
+  }
+
+  /* Convert result point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  /* Free allocated memory */
+  free(owned);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Scratch for Pippenger, decoded inputs then per task sums, per thread
+   work and buckets, and the decode block states */
+static size_t blst_p1s_pippenger_scratch_size(const pippenger_plan* plan,
+                                              size_t num_pairs) {
+  size_t num_buckets = (size_t)1 << (plan->window - 1);
+
+  return (num_pairs * (sizeof(blst_scalar) + sizeof(blst_p1_affine))) +
+         (plan->num_tasks * sizeof(blst_p1)) +
+         (plan->num_threads * ((num_buckets * sizeof(blst_p1)) +
+                               sizeof(blst_p1s_pippenger_work))) +
+         pippenger_decode_size(num_pairs);
+}
+
+/* Pippenger (bucket method) implementation of MSM with Booth recoding */
+EIP2537_ERROR bls12_g1multiexp_pippenger(byte out[128], byte* in,
+                                         size_t in_len) {
+  return bls12_g1multiexp_pippenger_with_scratch(out, in, in_len, NULL, 0);
+}
+
+size_t bls12_g1multiexp_pippenger_scratch_size(size_t in_len) {
+  if ((in_len == 0) || ((in_len % 160) != 0) || (in_len == 160)) {
+    return 0;
+  }
+
+  pippenger_plan plan;
+  pippenger_plan_init(&plan, in_len / 160);
+
+  return bls12_scratch_padded(blst_p1s_pippenger_scratch_size(&plan,
+                                                              in_len / 160));
+}
+
+EIP2537_ERROR bls12_g1multiexp_pippenger_with_scratch(byte out[128],
+                                                     byte* in, size_t in_len,
+                                                     void* scratch,
+                                                     size_t scratch_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 160) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 160;
+
+  if (num_pairs == 1) {
+    return bls12_g1mul(out, in, in_len);
+  }
+
+  pippenger_plan plan;
+  pippenger_plan_init(&plan, num_pairs);
+
+  /* Caller scratch may have been sized under fewer threads, run with as many
+     as it holds rather than failing */
+  if (scratch != NULL) {
+    while ((plan.num_threads > 1) &&
+           (bls12_scratch_padded(blst_p1s_pippenger_scratch_size(
+                &plan, num_pairs)) > scratch_len)) {
+      pippenger_plan_init_threads(&plan, num_pairs, plan.num_threads - 1);
+    }
+  }
+
+  size_t window      = plan.window;
+  size_t num_windows = plan.num_windows;
+  size_t num_buckets = (size_t)1 << (window - 1);
+  size_t num_chunks  = plan.num_chunks;
+  size_t num_tasks   = plan.num_tasks;
+  size_t num_threads = plan.num_threads;
+
+  /* Scalars, bases and per task state live in the scratch */
+  byte* owned;
+  byte* mem = bls12_scratch_get(scratch, scratch_len,
+                                blst_p1s_pippenger_scratch_size(&plan,
+                                                                num_pairs),
+                                &owned);
+  if (mem == NULL) {
+    free(owned);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  blst_scalar*    scalars  = (blst_scalar*)mem;
+  blst_p1_affine* bases    = (blst_p1_affine*)(scalars + num_pairs);
+  byte*           task_mem = (byte*)(bases + num_pairs);
+
+  blst_p1s_pippenger_ctx   ctx;
+  blst_p1s_pippenger_work* work;
+  pippenger_decode         decode;
+
+  ctx.bases       = bases;
+  ctx.scalars     = scalars;
+  ctx.num_pairs   = num_pairs;
+  ctx.window      = window;
+  ctx.num_chunks  = num_chunks;
+  ctx.num_tasks   = num_tasks;
+  ctx.num_threads = num_threads;
+  ctx.sums        = (blst_p1*)task_mem;
+  ctx.decode      = &decode;
+
+  work = (blst_p1s_pippenger_work*)(ctx.sums + num_tasks);
+  for (size_t t = 0; t < num_threads; ++t) {
+    work[t].ctx     = &ctx;
+    work[t].thread  = t;
+    work[t].buckets = (blst_p1*)(work + num_threads) + (t * num_buckets);
+  }
+
+  /* Inputs are decoded by the bucket threads as they reach them, bases stay
+     affine for cheaper bucket additions */
+  pippenger_decode_init(&decode,
+                        (blst_p1*)(work + num_threads) +
+                        (num_threads * num_buckets),
+                        blst_p1s_decode_pairs, bases, sizeof(blst_p1_affine),
+                        scalars, in, 160, num_pairs);
+
+  if (!bls12_run_tasks(blst_p1s_pippenger_worker, work,
+                       sizeof(blst_p1s_pippenger_work), num_threads)) {
+    free(owned);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  EIP2537_ERROR ret = pippenger_decode_result(&decode);
+  if (ret != EIP2537_SUCCESS) {
+    free(owned);
+    return ret;
+  }
+
+  blst_p1 result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+
+  /* Combine windows from most to least significant */
+  for (size_t w = num_windows; w-- > 0;) {
+    if (w != (num_windows - 1)) {
+      for (size_t i = 0; i < window; ++i) {
+        blst_p1_double(&result, &result);
+      }
+    }
+
+    /* result = result + sum of the window's chunks */
+    const blst_p1* sums = ctx.sums + (w * num_chunks);
+    for (size_t c = 0; c < num_chunks; ++c) {
+      blst_p1_add_or_double(&result, &result, &(sums[c]));
+    }
+  }
+
+  /* Convert result point to affine */
+  blst_p1_affine p_aff;
+  blst_p1_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g1_point(out, &p_aff);
+
+  /* Free allocated memory */
+  free(owned);
+
+  return EIP2537_SUCCESS;
+}
+
+/*
+  ABI for G2 addition
+
+  G2 addition call expects 512 bytes as an input that is interpreted as byte
+    concatenation of two G2 points (256 bytes each). Output is an encoding of
+    addition operation result - single G2 point (256 bytes).
+
+  Error cases:
+    Either of points being not on the curve must result in error
+    Field elements encoding rules apply (obviously)
+    Input has invalid length
+*/
+static EIP2537_ERROR bls12_g2add_projective(blst_p2* out, const byte* in,
+                                            size_t in_len) {
+  /* Check length, is this even necessary? */
+  if (in_len != 512) {
+    return EIP2537_INVALID_LENGTH;
   }
 
   EIP2537_ERROR ret;
 
   /* Decode inputs */
-  blst_p1_affine a_aff;
-  ret = decode_g1_point(&a_aff, in);
+  blst_p2_affine a_aff;
+  ret = decode_g2_point(&a_aff, in);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  blst_p2_affine b_aff;
+  ret = decode_g2_point(&b_aff, in + 256);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* One of the inputs needs to be projective for point addition function */
+  blst_p2 b;
+  blst_p2_from_affine(&b, &b_aff);
+
+  /* P = A + B */
+  blst_p2_add_or_double_affine(out, &b, &a_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_g2add(byte out[256], const byte in[512], size_t in_len) {
+  blst_p2 p;
+  EIP2537_ERROR ret = bls12_g2add_projective(&p, in, in_len);
   if (ret != EIP2537_SUCCESS) {
     return ret;
   }
 
+  /* Convert point to affine */
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &p);
+
+  /* Encode affine point to EIP format */
+  encode_g2_point(out, &p_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+/*
+  ABI for G2 multiplication
+
+  G2 multiplication call expects 288 bytes as an input that is interpreted as
+    byte concatenation of encoding of G2 point (256 bytes) and encoding of a
+    scalar value (32 bytes). Output is an encoding of multiplication operation
+    result - single G2 point (256 bytes).
+
+  Error cases:
+    Point being not on the curve must result in error
+    Field elements encoding rules apply (obviously)
+    Input has invalid length
+*/
+
+static EIP2537_ERROR bls12_g2mul_projective(blst_p2* out, const byte* in,
+                                            size_t in_len) {
+  /* Check length, is this even necessary? */
+  if (in_len != 288) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret;
+
+  /* Generator and registered bases already validated, use their tables */
+  const blst_p2_affine* table = blst_p2_fixed_base_lookup(in);
+
+  /* Decode inputs */
+  blst_p2_affine a_aff;
+  if (table == NULL) {
+    ret = decode_g2_point(&a_aff, in);
+    if (ret != EIP2537_SUCCESS) {
+      return ret;
+    }
+  }
+
   blst_scalar scalar;
-  ret = decode_scalar(&scalar, in + 128);
+  ret = decode_scalar(&scalar, in + 256);
   if (ret != EIP2537_SUCCESS) {
     return ret;
   }
 
-  /* Input needs to be projective for scalar multiplication function */
-  blst_p1 a;
-  blst_p1_from_affine(&a, &a_aff);
+  /* P = A * scalar, fixed bases walk their table in constant time when
+     variable time MUL is off */
+  int vartime = BLS12_ATOMIC_LOAD(&bls12_mul_vartime);
+  if ((table != NULL) && vartime) {
+    blst_p2_mult_fixed_base(out, table, &scalar);
+  }
+  else if (table != NULL) {
+    blst_p2_mult_fixed_base_ct(out, table, &scalar);
+  }
+  else if (vartime) {
+    blst_p2_mult_vartime(out, &a_aff, &scalar);
+  }
+  else {
+    /* Input needs to be projective for scalar multiplication function */
+    blst_p2 a;
+    blst_p2_from_affine(&a, &a_aff);
+
+    blst_p2_mult(out, &a, scalar.b, 256);
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_g2mul(byte out[256], const byte in[288], size_t in_len) {
+  blst_p2 p;
+  EIP2537_ERROR ret = bls12_g2mul_projective(&p, in, in_len);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  /* Convert point to affine */
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &p);
+
+  /* Encode affine point to EIP format */
+  encode_g2_point(out, &p_aff);
+
+  return EIP2537_SUCCESS;
+}
+
+/* G2 multiplication through the GLS endomorphism for points in G2, other
+   points on the curve take the regular double and add path. The subgroup
+   check costs more than GLS saves, a loss against bls12_g2mul unless the
+   point cache holds the verdict */
+EIP2537_ERROR bls12_g2mul_gls(byte out[256], const byte in[288],
+                              size_t in_len) {
+  /* Check length, is this even necessary? */
+  if (in_len != 288) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Decode inputs, the subgroup verdict comes from the cache when enabled */
+  blst_p2_affine a_aff;
+  EIP2537_ERROR ret = decode_g2_point_in_g2(&a_aff, in);
+  if ((ret != EIP2537_SUCCESS) && (ret != EIP2537_POINT_NOT_IN_SUBGROUP)) {
+    return ret;
+  }
+  int in_group = (ret == EIP2537_SUCCESS);
+
+  blst_scalar scalar;
+  ret = decode_scalar(&scalar, in + 256);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
 
   /* P = A * scalar */
-  blst_p1 p;
-  blst_p1_mult(&p, &a, scalar.b, 256);
+  blst_p2 p;
+  if (in_group) {
+    blst_p2_mult_gls(&p, &a_aff, &scalar);
+  }
+  else {
+    blst_p2 a;
+    blst_p2_from_affine(&a, &a_aff);
+
+    blst_p2_mult(&p, &a, scalar.b, 256);
+  }
 
   /* Convert point to affine */
-  blst_p1_affine p_aff;
-  blst_p1_to_affine(&p_aff, &p);
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &p);
 
   /* Encode affine point to EIP format */
-  encode_g1_point(out, &p_aff);
+  encode_g2_point(out, &p_aff);
 
   return EIP2537_SUCCESS;
 }
 
+typedef EIP2537_ERROR (*blst_p2_op)(blst_p2* out, const byte* in,
+                                     size_t in_len);
+
+/* Run op over n independent inputs, failed calls and points at infinity are
+   left as zeros and the rest converted to affine with one inversion per
+   chunk. Returns the error of the first failed call */
+static EIP2537_ERROR blst_p2s_batch(byte* out, EIP2537_ERROR* errs,
+                                    const byte* const* in,
+                                    const size_t* in_len, size_t n,
+                                    blst_p2_op op) {
+  blst_p2        points[BLS12_BATCH_CHUNK];
+  const blst_p2* finite[BLS12_BATCH_CHUNK];
+  blst_p2_affine affine[BLS12_BATCH_CHUNK];
+  size_t         index[BLS12_BATCH_CHUNK];
+
+  EIP2537_ERROR ret = EIP2537_SUCCESS;
+
+  for (size_t start = 0; start < n; start += BLS12_BATCH_CHUNK) {
+    size_t num_calls  = n - start;
+    size_t num_finite = 0;
+    if (num_calls > BLS12_BATCH_CHUNK) {
+      num_calls = BLS12_BATCH_CHUNK;
+    }
+
+    for (size_t i = 0; i < num_calls; ++i) {
+      size_t call = start + i;
+      memset(out + (call * 256), 0, 256);
+
+      errs[call] = op(&(points[i]), in[call], in_len[call]);
+      if (errs[call] != EIP2537_SUCCESS) {
+        if (ret == EIP2537_SUCCESS) {
+          ret = errs[call];
+        }
+        continue;
+      }
+
+      /* Infinity encodes as zeros and would zero the shared inverse */
+      if (!blst_p2_is_inf(&(points[i]))) {
+        finite[num_finite] = &(points[i]);
+        index[num_finite]  = call;
+        ++num_finite;
+      }
+    }
+
+    if (num_finite == 0) {
+      continue;
+    }
+
+    /* Montgomery batch inversion of all Z coordinates in the chunk */
+    blst_p2s_to_affine(affine, finite, num_finite);
+
+    for (size_t i = 0; i < num_finite; ++i) {
+      encode_g2_point(out + (index[i] * 256), &(affine[i]));
+    }
+  }
+
+  return ret;
+}
+
+/* Batched G2 addition, n inputs of 512 bytes each with 256 byte outputs
+   written back to back in out and per call errors in errs */
+EIP2537_ERROR bls12_g2add_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n) {
+  return blst_p2s_batch(out, errs, in, in_len, n, bls12_g2add_projective);
+}
+
+/* Batched G2 multiplication, as bls12_g2add_batch with 288 byte inputs */
+EIP2537_ERROR bls12_g2mul_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n) {
+  return blst_p2s_batch(out, errs, in, in_len, n, bls12_g2mul_projective);
+}
+
 /*
-  ABI for G1 multiexponentiation
+  ABI for G2 multiexponentiation
 
-  G1 multiexponentiation call expects 160*k bytes as an input that is
+  G2 multiexponentiation call expects 288*k bytes as an input that is
     interpreted as byte concatenation of k slices each of them being a byte
-    concatenation of encoding of G1 point (128 bytes) and encoding of a scalar
+    concatenation of encoding of G2 point (256 bytes) and encoding of a scalar
     value (32 bytes). Output is an encoding of multiexponentiation operation
-    result - single G1 point (128 bytes).
+    result - single G2 point (256 bytes).
 
   Error cases:
-    Any of G1 points being not on the curve must result in error
+    Any of G2 points being not on the curve must result in error
     Field elements encoding rules apply (obviously)
     Input has invalid length
     Input is empty
 */
-EIP2537_ERROR bls12_g1multiexp(byte out[128], byte* in, size_t in_len) {
+EIP2537_ERROR bls12_g2multiexp(byte out[256], byte* in, size_t in_len) {
+  return bls12_g2multiexp_with_scratch(out, in, in_len, NULL, 0);
+}
+
+/* Scratch for any engine bls12_g2multiexp may select, so the buffer stays
+   valid when the selection table changes or gets calibrated */
+size_t bls12_g2multiexp_scratch_size(size_t in_len) {
+  size_t size = bls12_g2multiexp_bc_scratch_size(in_len);
+
+  if (size < bls12_g2multiexp_straus_scratch_size(in_len)) {
+    size = bls12_g2multiexp_straus_scratch_size(in_len);
+  }
+  if (size < bls12_g2multiexp_pippenger_scratch_size(in_len)) {
+    size = bls12_g2multiexp_pippenger_scratch_size(in_len);
+  }
+
+  return size;
+}
+
+/* Run a given engine, naive needs no scratch */
+static EIP2537_ERROR bls12_g2multiexp_engine(bls12_msm_engine engine,
+                                             byte out[256], byte* in,
+                                             size_t in_len, void* scratch,
+                                             size_t scratch_len) {
+  switch (engine) {
+    case BLS12_MSM_BC:
+      return bls12_g2multiexp_bc_with_scratch(out, in, in_len, scratch,
+                                              scratch_len);
+    case BLS12_MSM_STRAUS:
+      return bls12_g2multiexp_straus_with_scratch(out, in, in_len, scratch,
+                                                  scratch_len);
+    case BLS12_MSM_PIPPENGER:
+      return bls12_g2multiexp_pippenger_with_scratch(out, in, in_len, scratch,
+                                                     scratch_len);
+    default:
+      return bls12_g2multiexp_naive(out, in, in_len);
+  }
+}
+
+EIP2537_ERROR bls12_g2multiexp_with_scratch(byte out[256], byte* in,
+                                           size_t in_len, void* scratch,
+                                           size_t scratch_len) {
   /* Check length, is this even necessary? */
-  if ((in_len == 0) || ((in_len % 160) != 0)) {
+  if ((in_len == 0) || ((in_len % 288) != 0)) {
     return EIP2537_INVALID_LENGTH;
   }
 
   /* Get the number of point/scalar pairs to process */
-  size_t num_pairs = in_len / 160;
+  size_t num_pairs = in_len / 288;
 
   if (num_pairs == 1) {
-    return bls12_g1mul(out, in, in_len);
+    return bls12_g2mul(out, in, in_len);
   }
 
-  /* Choose naive approach if same number of pairs */
-  if (num_pairs <= 4) {
-    return bls12_g1multiexp_naive(out, in, in_len);
-  }
-  else {
-    return bls12_g1multiexp_bc(out, in, in_len);
-  }
+  /* Engine from the selection table, calibrated or default */
+  return bls12_g2multiexp_engine(bls12_msm_select(&bls12_g2_msm_selection,
+                                                   num_pairs),
+                                 out, in, in_len, scratch, scratch_len);
 }
 
-/* Naive implementation of MSM */
-EIP2537_ERROR bls12_g1multiexp_naive(byte out[128], byte* in, size_t in_len) {
+EIP2537_ERROR bls12_g2multiexp_naive(byte out[256], byte* in, size_t in_len) {
   /* Check length, is this even necessary? */
-  if ((in_len == 0) || ((in_len % 160) != 0)) {
+  if ((in_len == 0) || ((in_len % 288) != 0)) {
     return EIP2537_INVALID_LENGTH;
   }
 
   /* Get the number of point/scalar pairs to process */
-  size_t num_pairs = in_len / 160;
+  size_t num_pairs = in_len / 288;
 
   if (num_pairs == 1) {
-    return bls12_g1mul(out, in, in_len);
+    return bls12_g2mul(out, in, in_len);
   }
 
   EIP2537_ERROR ret;
-  blst_p1 result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+
+  /* Infinity */
+  blst_p2 result = { {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}} };
 
   for (size_t i = 0; i < num_pairs; ++i) {
     /* Decode inputs */
-    blst_p1_affine a_aff;
-    ret = decode_g1_point(&a_aff, in);
+    blst_p2_affine a_aff;
+    ret = decode_g2_point(&a_aff, in);
     if (ret != EIP2537_SUCCESS) {
       return ret;
     }
 
     blst_scalar scalar;
-    ret = decode_scalar(&scalar, in + 128);
+    ret = decode_scalar(&scalar, in + 256);
     if (ret != EIP2537_SUCCESS) {
       return ret;
     }
 
-    in += 160;
+    in += 288;
 
     /* Input needs to be projective for scalar multiplication function */
-    blst_p1 a;
-    blst_p1_from_affine(&a, &a_aff);
+    blst_p2 a;
+    blst_p2_from_affine(&a, &a_aff);
 
     /* P = A * scalar */
-    blst_p1 p;
-    blst_p1_mult(&p, &a, scalar.b, 256);
+    blst_p2 p;
+    blst_p2_mult(&p, &a, scalar.b, 256);
 
     /* result = result + P */
-    blst_p1_add_or_double(&result, &result, &p);
+    blst_p2_add_or_double(&result, &result, &p);
   }
 
   /* Convert result point to affine */
-  blst_p1_affine p_aff;
-  blst_p1_to_affine(&p_aff, &result);
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &result);
 
   /* Encode affine point to EIP format */
-  encode_g1_point(out, &p_aff);
+  encode_g2_point(out, &p_aff);
 
   return EIP2537_SUCCESS;
 }
 
-/* Bos-Coster implementation of MSM */
-EIP2537_ERROR bls12_g1multiexp_bc(byte out[128], byte* in, size_t in_len) {
+/* Scratch for Straus, odd multiple tables, NAF lengths and digits for up to
+   four points (P and its psi powers) per pair */
+static size_t blst_p2s_straus_scratch_size(size_t num_pairs) {
+  return 4 * num_pairs * ((ENDO_WNAF_TABLE_LEN * sizeof(blst_p2)) +
+                          sizeof(size_t) + ENDO_WNAF_MAX_DIGITS);
+}
+
+size_t bls12_g2multiexp_straus_scratch_size(size_t in_len) {
+  if ((in_len == 0) || ((in_len % 288) != 0) || (in_len == 288)) {
+    return 0;
+  }
+  return bls12_scratch_padded(blst_p2s_straus_scratch_size(in_len / 288));
+}
+
+/* Straus (interleaved wNAF) implementation of MSM, one doubling chain shared
+   by all pairs with each pair's window following its scalar length */
+EIP2537_ERROR bls12_g2multiexp_straus(byte out[256], byte* in,
+                                      size_t in_len) {
+  return bls12_g2multiexp_straus_with_scratch(out, in, in_len, NULL, 0);
+}
+
+EIP2537_ERROR bls12_g2multiexp_straus_with_scratch(byte out[256],
+                                                   byte* in, size_t in_len,
+                                                   void* scratch,
+                                                   size_t scratch_len) {
   /* Check length, is this even necessary? */
-  if ((in_len == 0) || ((in_len % 160) != 0)) {
+  if ((in_len == 0) || ((in_len % 288) != 0)) {
     return EIP2537_INVALID_LENGTH;
   }
 
   /* Get the number of point/scalar pairs to process */
-  size_t num_pairs = in_len / 160;
+  size_t num_pairs = in_len / 288;
 
   if (num_pairs == 1) {
-    return bls12_g1mul(out, in, in_len);
+    return bls12_g2mul(out, in, in_len);
   }
 
-  /* Allocate memory for scalars and bases */
-  blst_p1* bases;
-  blst_msm_scalar* scalars;
-
-  bases = (blst_p1*) malloc(num_pairs * sizeof(blst_p1));
-  if (bases == NULL) {
+  /* Tables, NAF lengths and digits live in the scratch */
+  byte* owned;
+  byte* mem = bls12_scratch_get(scratch, scratch_len,
+                                blst_p2s_straus_scratch_size(num_pairs),
+                                &owned);
+  if (mem == NULL) {
+    free(owned);
     return EIP2537_MEMORY_ERROR;
   }
 
-  scalars = (blst_msm_scalar*) malloc(num_pairs * sizeof(blst_msm_scalar));
-  if (scalars == NULL) {
-    free(bases);
+  blst_p2* tables = (blst_p2*)mem;
+  size_t*  lens   = (size_t*)(tables + (4 * num_pairs * ENDO_WNAF_TABLE_LEN));
+  int8_t*  nafs   = (int8_t*)(lens + (4 * num_pairs));
+  size_t   num_points = 0;
+
+  EIP2537_ERROR ret;
+
+  blst_p2_affine points[POINT_DECODE_BLOCK];
+  byte           states[POINT_DECODE_BLOCK];
+
+  /* Decode inputs, recode scalars and build odd multiple tables. Points the
+     cache already knows to be in G2 enter as P and its psi powers with the
+     64 bit GLS digits of the scalar, a quarter of the doubling chain */
+  for (size_t i = 0; i < num_pairs; ++i) {
+    size_t b = i % POINT_DECODE_BLOCK;
+    if (b == 0) {
+      size_t num = num_pairs - i;
+      if (num > POINT_DECODE_BLOCK) {
+        num = POINT_DECODE_BLOCK;
+      }
+
+      ret = decode_g2_points(points, in, 288, num, states);
+      if (ret != EIP2537_SUCCESS) {
+        free(owned);
+        return ret;
+      }
+    }
+
+    const blst_p2_affine* a_aff    = &(points[b]);
+    int                   in_group = (states[b] == POINT_CACHE_IN_GROUP);
+
+    blst_scalar scalar;
+    ret = decode_scalar(&scalar, in + 256);
+    if (ret != EIP2537_SUCCESS) {
+      free(owned);
+      return ret;
+    }
+
+    in += 288;
+
+    int8_t*  naf   = nafs + (num_points * ENDO_WNAF_MAX_DIGITS);
+    blst_p2* table = tables + (num_points * ENDO_WNAF_TABLE_LEN);
+
+    if (in_group) {
+      uint64_t digits[4];
+      blst_p2_gls_split(digits, &scalar);
+
+      size_t num_bits = 0;
+      for (size_t d = 0; d < 4; d++) {
+        if (num_bits < limbs_num_bits(&(digits[d]), 1)) {
+          num_bits = limbs_num_bits(&(digits[d]), 1);
+        }
+      }
+      size_t window = vartime_wnaf_window((int)num_bits);
+
+      for (size_t d = 0; d < 4; d++) {
+        lens[num_points + d] = wnaf_encode(naf + (d * ENDO_WNAF_MAX_DIGITS),
+                                           &(digits[d]), 1, window);
+      }
+      blst_p2_gls_tables(table, a_aff, (size_t)1 << (window - 2));
+      num_points += 4;
+      continue;
+    }
+
+    size_t window = vartime_wnaf_window(blst_scalar_num_bits(&scalar));
+
+    uint64_t k[4];
+    limbs_from_scalar(k, &scalar);
+    lens[num_points] = wnaf_encode(naf, k, 4, window);
+
+    blst_p2 a;
+    blst_p2_from_affine(&a, a_aff);
+    blst_p2_wnaf_table(table, &a, (size_t)1 << (window - 2));
+    num_points++;
+  }
+
+  /* P = sum of A_i * scalar_i */
+  blst_p2 result;
+  blst_p2s_mult_wnaf(&result, tables, nafs, lens, num_points);
+
+  /* Convert result point to affine */
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g2_point(out, &p_aff);
+
+  /* Free allocated memory */
+  free(owned);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Scratch for Bos-Coster, modifiable bases and the scalar heap */
+static size_t blst_p2s_bc_scratch_size(size_t num_pairs) {
+  return num_pairs * (sizeof(blst_p2) + sizeof(blst_msm_scalar));
+}
+
+size_t bls12_g2multiexp_bc_scratch_size(size_t in_len) {
+  if ((in_len == 0) || ((in_len % 288) != 0) || (in_len == 288)) {
+    return 0;
+  }
+  return bls12_scratch_padded(blst_p2s_bc_scratch_size(in_len / 288));
+}
+
+/* Bos-Coster implementation of MSM */
+EIP2537_ERROR bls12_g2multiexp_bc(byte out[256], byte* in, size_t in_len) {
+  return bls12_g2multiexp_bc_with_scratch(out, in, in_len, NULL, 0);
+}
+
+EIP2537_ERROR bls12_g2multiexp_bc_with_scratch(byte out[256], byte* in,
+                                              size_t in_len, void* scratch,
+                                              size_t scratch_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 288) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 288;
+
+  if (num_pairs == 1) {
+    return bls12_g2mul(out, in, in_len);
+  }
+
+  /* Scalars and bases live in the scratch */
+  byte* owned;
+  byte* mem = bls12_scratch_get(scratch, scratch_len,
+                                blst_p2s_bc_scratch_size(num_pairs), &owned);
+  if (mem == NULL) {
+    free(owned);
     return EIP2537_MEMORY_ERROR;
   }
 
+  blst_p2*         bases   = (blst_p2*)mem;
+  blst_msm_scalar* scalars = (blst_msm_scalar*)(bases + num_pairs);
+
   EIP2537_ERROR ret;
 
   /* Decode all inputs and copy into arrays that can be modified */
   for (size_t i = 0; i < num_pairs; ++i) {
     /* Decode inputs */
-    blst_p1_affine a_aff;
-    ret = decode_g1_point(&a_aff, in);
+    blst_p2_affine a_aff;
+    ret = decode_g2_point(&a_aff, in);
     if (ret != EIP2537_SUCCESS) {
-      free(bases);
-      free(scalars);
+      free(owned);
       return ret;
     }
 
     /* Input needs to be projective for scalar multiplication function */
-    blst_p1_from_affine(&(bases[i]), &a_aff);
+    blst_p2_from_affine(&(bases[i]), &a_aff);
 
-    ret = decode_scalar(&(scalars[i].k), in + 128);
+    ret = decode_scalar(&(scalars[i].k), in + 256);
     if (ret != EIP2537_SUCCESS) {
-      free(bases);
-      free(scalars);
+      free(owned);
       return ret;
     }
     scalars[i].base_index = i;
 
-    in += 160;
+    in += 288;
   }
 
   /* Build heap */
   blst_scalars_max_heapify(scalars, num_pairs);
 
-  blst_p1 skipped_result = { {{0}}, {{0}}, {{0}} }; /* Infinity */
+  blst_p2 skipped_result = { {{{{0}}, {{0}}}},
+                             {{{{0}}, {{0}}}},
+                             {{{{0}}, {{0}}}} }; /* Infinity */
 
   /* Loop until there is only one pair left */
-  while (blst_scalars_max_heapreplace_p1(&skipped_result, bases,
+  while (blst_scalars_max_heapreplace_p2(&skipped_result, bases,
                                          scalars, num_pairs));
 
   /* Down to only one point/scalar pair, perform final scalar mul */
-
   int num_bits_left = blst_scalar_num_bits(&(scalars[0].k));
-  blst_p1 result;
-  blst_p1_mult(&result, &(bases[scalars[0].base_index]),
+  blst_p2 result;
+  blst_p2_mult(&result, &(bases[scalars[0].base_index]),
                (scalars[0].k).b, num_bits_left);
 
   /* In case any values needed to be skipped over in bc due to deltas */
-  if (!blst_p1_is_inf(&skipped_result)) {
+  if (!blst_p2_is_inf(&skipped_result)) {
     /* result = result + skipped_result */
-    blst_p1_add_or_double(&result, &result, &skipped_result);
+    blst_p2_add_or_double(&result, &result, &skipped_result);
+  }
+
+  /* Convert result point to affine */
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g2_point(out, &p_aff);
+
+  /* Free allocated memory */
+  free(owned);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Scratch for Pippenger, decoded inputs then per task sums, per thread
+   work and buckets, and the decode block states */
+static size_t blst_p2s_pippenger_bucket_size(size_t window) {
+  /* Rounded up to keep the next thread's buckets aligned */
+  return (blst_p2_buckets_sizeof(window) + 7) & ~(size_t)7;
+}
+
+static size_t blst_p2s_pippenger_scratch_size(const pippenger_plan* plan,
+                                              size_t num_pairs) {
+  return (num_pairs * (sizeof(blst_scalar) + sizeof(blst_p2_affine))) +
+         (plan->num_tasks * sizeof(blst_p2)) +
+         (plan->num_threads * (blst_p2s_pippenger_bucket_size(plan->window) +
+                               sizeof(blst_p2s_pippenger_work))) +
+         pippenger_decode_size(num_pairs);
+}
+
+/* Pippenger (bucket method) implementation of MSM with Booth recoding,
+   buckets accumulated in affine form with batched inversion when wide */
+EIP2537_ERROR bls12_g2multiexp_pippenger(byte out[256], byte* in,
+                                         size_t in_len) {
+  return bls12_g2multiexp_pippenger_with_scratch(out, in, in_len, NULL, 0);
+}
+
+size_t bls12_g2multiexp_pippenger_scratch_size(size_t in_len) {
+  if ((in_len == 0) || ((in_len % 288) != 0) || (in_len == 288)) {
+    return 0;
+  }
+
+  pippenger_plan plan;
+  pippenger_plan_init(&plan, in_len / 288);
+
+  return bls12_scratch_padded(blst_p2s_pippenger_scratch_size(&plan,
+                                                              in_len / 288));
+}
+
+EIP2537_ERROR bls12_g2multiexp_pippenger_with_scratch(byte out[256],
+                                                     byte* in, size_t in_len,
+                                                     void* scratch,
+                                                     size_t scratch_len) {
+  /* Check length, is this even necessary? */
+  if ((in_len == 0) || ((in_len % 288) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  /* Get the number of point/scalar pairs to process */
+  size_t num_pairs = in_len / 288;
+
+  if (num_pairs == 1) {
+    return bls12_g2mul(out, in, in_len);
+  }
+
+  pippenger_plan plan;
+  pippenger_plan_init(&plan, num_pairs);
+
+  /* Caller scratch may have been sized under fewer threads, run with as many
+     as it holds rather than failing */
+  if (scratch != NULL) {
+    while ((plan.num_threads > 1) &&
+           (bls12_scratch_padded(blst_p2s_pippenger_scratch_size(
+                &plan, num_pairs)) > scratch_len)) {
+      pippenger_plan_init_threads(&plan, num_pairs, plan.num_threads - 1);
+    }
+  }
+
+  size_t window      = plan.window;
+  size_t num_windows = plan.num_windows;
+  size_t bucket_size = blst_p2s_pippenger_bucket_size(window);
+  size_t num_chunks  = plan.num_chunks;
+  size_t num_tasks   = plan.num_tasks;
+  size_t num_threads = plan.num_threads;
+
+  /* Scalars, bases and per task state live in the scratch */
+  byte* owned;
+  byte* mem = bls12_scratch_get(scratch, scratch_len,
+                                blst_p2s_pippenger_scratch_size(&plan,
+                                                                num_pairs),
+                                &owned);
+  if (mem == NULL) {
+    free(owned);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  blst_scalar*    scalars  = (blst_scalar*)mem;
+  blst_p2_affine* bases    = (blst_p2_affine*)(scalars + num_pairs);
+  byte*           task_mem = (byte*)(bases + num_pairs);
+
+  blst_p2s_pippenger_ctx   ctx;
+  blst_p2s_pippenger_work* work;
+  pippenger_decode         decode;
+
+  ctx.bases       = bases;
+  ctx.scalars     = scalars;
+  ctx.num_pairs   = num_pairs;
+  ctx.window      = window;
+  ctx.num_chunks  = num_chunks;
+  ctx.num_tasks   = num_tasks;
+  ctx.num_threads = num_threads;
+  ctx.sums        = (blst_p2*)task_mem;
+  ctx.decode      = &decode;
+
+  work = (blst_p2s_pippenger_work*)(ctx.sums + num_tasks);
+  for (size_t t = 0; t < num_threads; ++t) {
+    work[t].ctx    = &ctx;
+    work[t].thread = t;
+    blst_p2_buckets_init(&(work[t].buckets),
+                         (byte*)(work + num_threads) + (t * bucket_size),
+                         window);
+  }
+
+  /* Inputs are decoded by the bucket threads as they reach them, bases stay
+     affine for cheaper bucket additions */
+  pippenger_decode_init(&decode,
+                        (byte*)(work + num_threads) +
+                        (num_threads * bucket_size),
+                        blst_p2s_decode_pairs, bases, sizeof(blst_p2_affine),
+                        scalars, in, 288, num_pairs);
+
+  if (!bls12_run_tasks(blst_p2s_pippenger_worker, work,
+                       sizeof(blst_p2s_pippenger_work), num_threads)) {
+    free(owned);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  EIP2537_ERROR ret = pippenger_decode_result(&decode);
+  if (ret != EIP2537_SUCCESS) {
+    free(owned);
+    return ret;
+  }
+
+  /* Infinity */
+  blst_p2 result = { {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}} };
+
+  /* Combine windows from most to least significant */
+  for (size_t w = num_windows; w-- > 0;) {
+    if (w != (num_windows - 1)) {
+      for (size_t i = 0; i < window; ++i) {
+        blst_p2_double(&result, &result);
+      }
+    }
+
+    /* result = result + sum of the window's chunks */
+    const blst_p2* sums = ctx.sums + (w * num_chunks);
+    for (size_t c = 0; c < num_chunks; ++c) {
+      blst_p2_add_or_double(&result, &result, &(sums[c]));
+    }
+  }
+
+  /* Convert result point to affine */
+  blst_p2_affine p_aff;
+  blst_p2_to_affine(&p_aff, &result);
+
+  /* Encode affine point to EIP format */
+  encode_g2_point(out, &p_aff);
+
+  /* Free allocated memory */
+  free(owned);
+
+  return EIP2537_SUCCESS;
+}
+
+/* Multiexp calibration, every engine is timed on the host across input
+   sizes and scalar distributions. Each size takes the engine with the best
+   worst case over distributions, since callers pick the scalars. Engines
+   over BLS12_MSM_CALIBRATE_DROP times the best are not timed at larger
+   sizes */
+#define BLS12_MSM_CALIBRATE_DISTS 3
+#define BLS12_MSM_CALIBRATE_RUNS  5
+#define BLS12_MSM_CALIBRATE_DROP  4
+
+typedef EIP2537_ERROR (*bls12_msm_engine_fn)(bls12_msm_engine engine,
+                                             byte* out, byte* in,
+                                             size_t in_len, void* scratch,
+                                             size_t scratch_len);
+
+static uint64_t bls12_msm_calibrate_rand(uint64_t* state) {
+  /* splitmix64 */
+  uint64_t z = (*state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+static void bls12_msm_calibrate_scalar(byte out[32], uint64_t* state) {
+  for (size_t i = 0; i < 32; i += 8) {
+    uint64_t r = bls12_msm_calibrate_rand(state);
+    memcpy(out + i, &r, 8);
+  }
+}
+
+/* Fill the scalars of max_pairs pairs for each distribution, full width,
+   64 bit, and one full width scalar among 64 bit ones */
+static void bls12_msm_calibrate_scalars(byte* in, size_t pair_len,
+                                        size_t point_len, size_t max_pairs) {
+  uint64_t state = 0x2537;
+
+  for (size_t d = 0; d < BLS12_MSM_CALIBRATE_DISTS; ++d) {
+    for (size_t i = 0; i < max_pairs; ++i) {
+      byte* k = in + (((d * max_pairs) + i) * pair_len) + point_len;
+      bls12_msm_calibrate_scalar(k, &state);
+      if ((d == 1) || ((d == 2) && (i != 0))) {
+        memset(k, 0, 24);
+      }
+    }
+  }
+}
+
+static uint64_t bls12_msm_calibrate_now() {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ((uint64_t)ts.tv_sec * 1000000000) + (uint64_t)ts.tv_nsec;
+}
+
+/* Best of several runs, 0 if the engine failed */
+static uint64_t bls12_msm_calibrate_time(bls12_msm_engine_fn fn,
+                                         bls12_msm_engine engine, byte* in,
+                                         size_t in_len) {
+  byte     out[256];
+  uint64_t best = UINT64_MAX;
+
+  for (size_t r = 0; r < BLS12_MSM_CALIBRATE_RUNS; ++r) {
+    uint64_t start = bls12_msm_calibrate_now();
+    if (fn(engine, out, in, in_len, NULL, 0) != EIP2537_SUCCESS) {
+      return 0;
+    }
+    uint64_t elapsed = bls12_msm_calibrate_now() - start;
+    if (elapsed < best) {
+      best = elapsed;
+    }
   }
 
-  /* Convert result point to affine */
-  blst_p1_affine p_aff;
-  blst_p1_to_affine(&p_aff, &result);
+  return best;
+}
 
-  /* Encode affine point to EIP format */
-  encode_g1_point(out, &p_aff);
+/* Time engines on 2, 4, ..., max_pairs pairs and merge the winners into
+   a selection table, returns the number of entries */
+static size_t bls12_msm_calibrate(bls12_msm_selection* table, byte* in,
+                                  size_t pair_len, size_t max_pairs,
+                                  bls12_msm_engine_fn fn) {
+  int    active[BLS12_MSM_PIPPENGER + 1] = { 1, 1, 1, 1 };
+  size_t num_entries = 0;
+
+  for (size_t num_pairs = 2; num_pairs <= max_pairs; num_pairs *= 2) {
+    uint64_t worst[BLS12_MSM_PIPPENGER + 1] = { 0 };
+
+    for (int e = BLS12_MSM_NAIVE; e <= BLS12_MSM_PIPPENGER; ++e) {
+      if (!active[e]) {
+        continue;
+      }
+
+      for (size_t d = 0; d < BLS12_MSM_CALIBRATE_DISTS; ++d) {
+        uint64_t t = bls12_msm_calibrate_time(fn, (bls12_msm_engine)e,
+                                              in + (d * max_pairs * pair_len),
+                                              num_pairs * pair_len);
+        if (t == 0) {
+          active[e] = 0;
+          break;
+        }
+        if (t > worst[e]) {
+          worst[e] = t;
+        }
+      }
+    }
 
-  /* Free allocated memory */
-  free(bases);
-  free(scalars);
+    int best = -1;
+    for (int e = BLS12_MSM_NAIVE; e <= BLS12_MSM_PIPPENGER; ++e) {
+      if (active[e] && ((best < 0) || (worst[e] < worst[best]))) {
+        best = e;
+      }
+    }
+    if (best < 0) {
+      return 0;
+    }
 
-  return EIP2537_SUCCESS;
+    for (int e = BLS12_MSM_NAIVE; e <= BLS12_MSM_PIPPENGER; ++e) {
+      if (active[e] && (worst[e] > (worst[best] * BLS12_MSM_CALIBRATE_DROP))) {
+        active[e] = 0;
+      }
+    }
+
+    /* Extend the previous entry when the winner is unchanged */
+    if ((num_entries > 0) &&
+        (table[num_entries - 1].engine == (bls12_msm_engine)best)) {
+      table[num_entries - 1].max_pairs = num_pairs;
+    }
+    else if (num_entries < BLS12_MSM_MAX_SELECTIONS) {
+      table[num_entries].max_pairs = num_pairs;
+      table[num_entries].engine    = (bls12_msm_engine)best;
+      ++num_entries;
+    }
+    else {
+      break;
+    }
+  }
+
+  return num_entries;
 }
 
-/*
-  ABI for G2 addition
+static EIP2537_ERROR bls12_g1multiexp_engine_fn(bls12_msm_engine engine,
+                                                byte* out, byte* in,
+                                                size_t in_len, void* scratch,
+                                                size_t scratch_len) {
+  return bls12_g1multiexp_engine(engine, out, in, in_len, scratch,
+                                 scratch_len);
+}
 
-  G2 addition call expects 512 bytes as an input that is interpreted as byte
-    concatenation of two G2 points (256 bytes each). Output is an encoding of
-    addition operation result - single G2 point (256 bytes).
+static EIP2537_ERROR bls12_g2multiexp_engine_fn(bls12_msm_engine engine,
+                                                byte* out, byte* in,
+                                                size_t in_len, void* scratch,
+                                                size_t scratch_len) {
+  return bls12_g2multiexp_engine(engine, out, in, in_len, scratch,
+                                 scratch_len);
+}
 
-  Error cases:
-    Either of points being not on the curve must result in error
-    Field elements encoding rules apply (obviously)
-    Input has invalid length
-*/
-EIP2537_ERROR bls12_g2add(byte out[256], const byte in[512], size_t in_len) {
-  /* Check length, is this even necessary? */
-  if (in_len != 512) {
+/* Benchmark every engine on this host up to max_pairs pairs (at least 2)
+   and install the resulting G1 and G2 selection tables */
+EIP2537_ERROR bls12_multiexp_calibrate(size_t max_pairs) {
+  if (max_pairs < 2) {
     return EIP2537_INVALID_LENGTH;
   }
 
-  EIP2537_ERROR ret;
+  size_t num_inputs = BLS12_MSM_CALIBRATE_DISTS * max_pairs;
 
-  /* Decode inputs */
-  blst_p2_affine a_aff;
-  ret = decode_g2_point(&a_aff, in);
-  if (ret != EIP2537_SUCCESS) {
-    return ret;
+  byte*    in     = (byte*) malloc(num_inputs * 288);
+  blst_p2* points = (blst_p2*) malloc(num_inputs * sizeof(blst_p2));
+  const void** ptrs = (const void**) malloc(num_inputs * sizeof(void*));
+  if ((in == NULL) || (points == NULL) || (ptrs == NULL)) {
+    free(in);
+    free(points);
+    free(ptrs);
+    return EIP2537_MEMORY_ERROR;
   }
 
-  blst_p2_affine b_aff;
-  ret = decode_g2_point(&b_aff, in + 256);
-  if (ret != EIP2537_SUCCESS) {
-    return ret;
+  bls12_msm_selection table[BLS12_MSM_MAX_SELECTIONS];
+  size_t              num_entries;
+  EIP2537_ERROR       ret = EIP2537_SUCCESS;
+  uint64_t            state = 0x12381;
+  byte                k[32];
+
+  /* G1 points G + i * H for a random H, one batch inversion to affine */
+  blst_p1* p1s = (blst_p1*)points;
+  blst_p1  h1;
+  bls12_msm_calibrate_scalar(k, &state);
+  blst_p1_from_affine(&(p1s[0]), blst_p1_affine_generator());
+  blst_p1_mult(&h1, &(p1s[0]), k, 256);
+  for (size_t i = 0; i < num_inputs; ++i) {
+    if (i > 0) {
+      blst_p1_add_or_double(&(p1s[i]), &(p1s[i - 1]), &h1);
+    }
+    ptrs[i] = &(p1s[i]);
   }
 
-  /* One of the inputs needs to be projective for point addition function */
-  blst_p2 b;
-  blst_p2_from_affine(&b, &b_aff);
+  blst_p1_affine* a1s = (blst_p1_affine*)in; /* Encoded from the back */
+  blst_p1s_to_affine(a1s, (const blst_p1* const*)ptrs, num_inputs);
+  for (size_t i = num_inputs; i-- > 0;) {
+    blst_p1_affine a = a1s[i];
+    encode_g1_point(in + (i * 160), &a);
+  }
 
-  /* P = A + B */
-  blst_p2 p;
-  blst_p2_add_or_double_affine(&p, &b, &a_aff);
+  bls12_msm_calibrate_scalars(in, 160, 128, max_pairs);
+  num_entries = bls12_msm_calibrate(table, in, 160, max_pairs,
+                                    bls12_g1multiexp_engine_fn);
+  if (num_entries == 0) {
+    ret = EIP2537_MEMORY_ERROR;
+  }
+  else {
+    ret = bls12_g1multiexp_set_selection(table, num_entries);
+  }
 
-  /* Convert point to affine */
-  blst_p2_affine p_aff;
-  blst_p2_to_affine(&p_aff, &p);
+  /* G2 the same way */
+  blst_p2 h2;
+  bls12_msm_calibrate_scalar(k, &state);
+  blst_p2_from_affine(&(points[0]), blst_p2_affine_generator());
+  blst_p2_mult(&h2, &(points[0]), k, 256);
+  for (size_t i = 0; i < num_inputs; ++i) {
+    if (i > 0) {
+      blst_p2_add_or_double(&(points[i]), &(points[i - 1]), &h2);
+    }
+    ptrs[i] = &(points[i]);
+  }
 
-  /* Encode affine point to EIP format */
-  encode_g2_point(out, &p_aff);
+  blst_p2_affine* a2s = (blst_p2_affine*)in;
+  blst_p2s_to_affine(a2s, (const blst_p2* const*)ptrs, num_inputs);
+  for (size_t i = num_inputs; i-- > 0;) {
+    blst_p2_affine a = a2s[i];
+    encode_g2_point(in + (i * 288), &a);
+  }
 
-  return EIP2537_SUCCESS;
+  bls12_msm_calibrate_scalars(in, 288, 256, max_pairs);
+  num_entries = bls12_msm_calibrate(table, in, 288, max_pairs,
+                                    bls12_g2multiexp_engine_fn);
+  if (num_entries == 0) {
+    ret = EIP2537_MEMORY_ERROR;
+  }
+  else if (ret == EIP2537_SUCCESS) {
+    ret = bls12_g2multiexp_set_selection(table, num_entries);
+  }
+
+  free(in);
+  free(points);
+  free(ptrs);
+
+  return ret;
 }
 
 /*
-  ABI for G2 multiplication
+  ABI for pairing
 
-  G2 multiplication call expects 288 bytes as an input that is interpreted as
-    byte concatenation of encoding of G2 point (256 bytes) and encoding of a
-    scalar value (32 bytes). Output is an encoding of multiplication operation
-    result - single G2 point (256 bytes).
+  Pairing call expects 384*k bytes as an inputs that is interpreted as byte
+    concatenation of k slices. Each slice has the following structure:
+      128 bytes of G1 point encoding
+      256 bytes of G2 point encoding
+
+  Output is a 32 bytes where first 31 bytes are equal to 0x00 and the last
+    byte is 0x01 if pairing result is equal to multiplicative identity in a
+    pairing target field and 0x00 otherwise.
 
   Error cases:
-    Point being not on the curve must result in error
+    Any of G1 or G2 points being not on the curve must result in error
+    Any of G1 or G2 points are not in the correct subgroup
     Field elements encoding rules apply (obviously)
     Input has invalid length
+    Input is empty
 */
+/* Pairs removed from pairing input by normalization, summed over all calls */
+static uint64_t bls12_pairing_eliminated = 0;
 
-EIP2537_ERROR bls12_g2mul(byte out[256], const byte in[288], size_t in_len) {
-  /* Check length, is this even necessary? */
-  if (in_len != 288) {
-    return EIP2537_INVALID_LENGTH;
-  }
+uint64_t bls12_pairing_eliminated_pairs() {
+  return BLS12_ATOMIC_LOAD(&bls12_pairing_eliminated);
+}
 
-  EIP2537_ERROR ret;
+/* Fixed argument pairing, cache of precomputed Miller loop lines for G2
+   points seen again. A point is admitted on first sight without lines, its
+   lines are computed when it is seen a second time. Points hash to a set of
+   LINE_CACHE_WAYS entries with LRU inside the set, sets are guarded by
+   striped locks and lines are shared immutable buffers with a reference
+   count so hits never copy them under a lock */
 
-  /* Decode inputs */
-  blst_p2_affine a_aff;
-  ret = decode_g2_point(&a_aff, in);
-  if (ret != EIP2537_SUCCESS) {
-    return ret;
-  }
+#define LINE_CACHE_WAYS      4
+#define LINE_CACHE_NUM_LOCKS 64
 
-  blst_scalar scalar;
-  ret = decode_scalar(&scalar, in + 256);
-  if (ret != EIP2537_SUCCESS) {
-    return ret;
-  }
+#define LINE_CACHE_MISS      0  /* unknown point, now admitted */
+#define LINE_CACHE_NO_LINES  1  /* seen before, caller computes the lines */
+#define LINE_CACHE_HIT       2  /* reference to the lines handed out */
 
-  /* Input needs to be projective for scalar multiplication function */
-  blst_p2 a;
-  blst_p2_from_affine(&a, &a_aff);
+typedef struct {
+  uint64_t refs;
+  blst_fp6 lines[68];
+} bls12_line_cache_lines;
 
-  /* P = A * scalar */
-  blst_p2 p;
-  blst_p2_mult(&p, &a, scalar.b, 256);
+typedef struct {
+  blst_p2_affine          q;
+  uint64_t                last_used; /* 0 when the way is free */
+  bls12_line_cache_lines* lines;     /* NULL until computed */
+} bls12_line_cache_entry;
 
-  /* Convert point to affine */
-  blst_p2_affine p_aff;
-  blst_p2_to_affine(&p_aff, &p);
+typedef struct {
+  uint64_t               tick;
+  bls12_line_cache_entry ways[LINE_CACHE_WAYS];
+} bls12_line_cache_set;
 
-  /* Encode affine point to EIP format */
-  encode_g2_point(out, &p_aff);
+typedef struct {
+  bls12_line_cache_set* sets;
+  size_t                num_sets;  /* power of two, 0 when disabled */
+  uint64_t              hits;
+  uint64_t              misses;
+  byte                  locks[LINE_CACHE_NUM_LOCKS];
+} bls12_line_cache;
+
+static bls12_line_cache bls12_g2_line_cache = { NULL, 0, 0, 0, {0} };
+
+/* Lines with one reference held by the caller, NULL on memory error */
+static bls12_line_cache_lines* line_cache_lines_new() {
+  bls12_line_cache_lines* lines;
+  lines = (bls12_line_cache_lines*) malloc(sizeof(bls12_line_cache_lines));
+  if (lines != NULL) {
+    lines->refs = 1;
+  }
+  return lines;
+}
 
-  return EIP2537_SUCCESS;
+/* Drop a reference, the last one frees the lines */
+static void line_cache_lines_release(bls12_line_cache_lines* lines) {
+  if ((lines != NULL) && (BLS12_ATOMIC_SUB_ACQ_REL(&(lines->refs), 1) == 0)) {
+    free(lines);
+  }
 }
 
-/*
-  ABI for G2 multiexponentiation
+/* Lock the set q hashes to and return it, NULL with no lock held when the
+   cache is disabled. Each set has one lock, the set count is checked again
+   under the lock in case the cache was reconfigured */
+static bls12_line_cache_set* line_cache_lock_set(const blst_p2_affine* q,
+                                                 byte** lock) {
+  bls12_line_cache* cache = &bls12_g2_line_cache;
+  uint64_t          h     = point_cache_hash((const byte*)q,
+                                             sizeof(blst_p2_affine));
+
+  for (;;) {
+    size_t num_sets = BLS12_ATOMIC_LOAD(&(cache->num_sets));
+    if (num_sets == 0) {
+      return NULL;
+    }
 
-  G2 multiexponentiation call expects 288*k bytes as an input that is
-    interpreted as byte concatenation of k slices each of them being a byte
-    concatenation of encoding of G2 point (256 bytes) and encoding of a scalar
-    value (32 bytes). Output is an encoding of multiexponentiation operation
-    result - single G2 point (256 bytes).
+    size_t set = (size_t)h & (num_sets - 1);
+    *lock = &(cache->locks[set % LINE_CACHE_NUM_LOCKS]);
 
-  Error cases:
-    Any of G2 points being not on the curve must result in error
-    Field elements encoding rules apply (obviously)
-    Input has invalid length
-    Input is empty
-*/
-EIP2537_ERROR bls12_g2multiexp(byte out[256], byte* in, size_t in_len) {
-  /* Check length, is this even necessary? */
-  if ((in_len == 0) || ((in_len % 288) != 0)) {
-    return EIP2537_INVALID_LENGTH;
+    bls12_spin_lock(*lock);
+    if (cache->num_sets == num_sets) {
+      return &(cache->sets[set]);
+    }
+    bls12_spin_unlock(*lock);
   }
+}
 
-  /* Get the number of point/scalar pairs to process */
-  size_t num_pairs = in_len / 288;
+/* Find the cached lines for q, admitting q on a miss. A hit hands out a
+   reference in *lines that the caller releases */
+static int line_cache_lookup(const blst_p2_affine* q,
+                             bls12_line_cache_lines** lines) {
+  bls12_line_cache*     cache = &bls12_g2_line_cache;
+  int                   state = LINE_CACHE_MISS;
+  byte*                 lock;
+  bls12_line_cache_set* set   = line_cache_lock_set(q, &lock);
+
+  *lines = NULL;
+
+  if (set != NULL) {
+    size_t lru = 0;
+    size_t i;
+    for (i = 0; i < LINE_CACHE_WAYS; ++i) {
+      if ((set->ways[i].last_used != 0) &&
+          (memcmp(&(set->ways[i].q), q, sizeof(blst_p2_affine)) == 0)) {
+        break;
+      }
+      if (set->ways[i].last_used < set->ways[lru].last_used) {
+        lru = i;
+      }
+    }
 
-  if (num_pairs == 1) {
-    return bls12_g2mul(out, in, in_len);
+    if (i < LINE_CACHE_WAYS) {
+      bls12_line_cache_entry* entry = &(set->ways[i]);
+
+      entry->last_used = ++(set->tick);
+      if (entry->lines != NULL) {
+        BLS12_ATOMIC_ADD(&(entry->lines->refs), 1);
+        *lines = entry->lines;
+        state  = LINE_CACHE_HIT;
+      }
+      else {
+        state = LINE_CACHE_NO_LINES;
+      }
+    }
+    else {
+      /* Admit over a free or the least recently used way */
+      bls12_line_cache_entry* entry = &(set->ways[lru]);
+
+      line_cache_lines_release(entry->lines);
+      entry->q         = *q;
+      entry->last_used = ++(set->tick);
+      entry->lines     = NULL;
+    }
+
+    bls12_spin_unlock(lock);
   }
 
-  /* Choose naive approach if same number of pairs */
-  if (num_pairs <= 4) {
-    return bls12_g2multiexp_naive(out, in, in_len);
+  if (state == LINE_CACHE_HIT) {
+    BLS12_ATOMIC_ADD(&(cache->hits), 1);
   }
   else {
-    return bls12_g2multiexp_bc(out, in, in_len);
+    BLS12_ATOMIC_ADD(&(cache->misses), 1);
   }
+
+  return state;
 }
 
-EIP2537_ERROR bls12_g2multiexp_naive(byte out[256], byte* in, size_t in_len) {
-  /* Check length, is this even necessary? */
-  if ((in_len == 0) || ((in_len % 288) != 0)) {
-    return EIP2537_INVALID_LENGTH;
+/* Share lines for q if it is still cached without lines */
+static void line_cache_store(const blst_p2_affine* q,
+                             bls12_line_cache_lines* lines) {
+  byte*                 lock;
+  bls12_line_cache_set* set = line_cache_lock_set(q, &lock);
+
+  if (set != NULL) {
+    for (size_t i = 0; i < LINE_CACHE_WAYS; ++i) {
+      bls12_line_cache_entry* entry = &(set->ways[i]);
+
+      if ((entry->last_used != 0) && (entry->lines == NULL) &&
+          (memcmp(&(entry->q), q, sizeof(blst_p2_affine)) == 0)) {
+        BLS12_ATOMIC_ADD(&(lines->refs), 1);
+        entry->lines = lines;
+        break;
+      }
+    }
+
+    bls12_spin_unlock(lock);
   }
+}
 
-  /* Get the number of point/scalar pairs to process */
-  size_t num_pairs = in_len / 288;
+EIP2537_ERROR bls12_pairing_line_cache_configure(size_t num_entries) {
+  bls12_line_cache*     cache    = &bls12_g2_line_cache;
+  bls12_line_cache_set* sets     = NULL;
+  size_t                num_sets = 0;
 
-  if (num_pairs == 1) {
-    return bls12_g2mul(out, in, in_len);
+  if (num_entries > 0) {
+    num_sets = 1;
+    while ((num_sets << 1) <= (num_entries / LINE_CACHE_WAYS)) {
+      num_sets <<= 1;
+    }
+
+    sets = (bls12_line_cache_set*) calloc(num_sets,
+                                          sizeof(bls12_line_cache_set));
+    if (sets == NULL) {
+      return EIP2537_MEMORY_ERROR;
+    }
   }
 
-  EIP2537_ERROR ret;
+  for (size_t i = 0; i < LINE_CACHE_NUM_LOCKS; ++i) {
+    bls12_spin_lock(&(cache->locks[i]));
+  }
 
-  /* Infinity */
-  blst_p2 result = { {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}}, {{{{0}}, {{0}}}} };
+  bls12_line_cache_set* old_sets     = cache->sets;
+  size_t                old_num_sets = cache->num_sets;
+  cache->sets = sets;
+  BLS12_ATOMIC_STORE(&(cache->num_sets), num_sets);
+  BLS12_ATOMIC_STORE(&(cache->hits), 0);
+  BLS12_ATOMIC_STORE(&(cache->misses), 0);
+
+  for (size_t i = 0; i < LINE_CACHE_NUM_LOCKS; ++i) {
+    bls12_spin_unlock(&(cache->locks[i]));
+  }
+
+  /* Lines still referenced by running pairings are freed by their release */
+  for (size_t i = 0; i < old_num_sets; ++i) {
+    for (size_t j = 0; j < LINE_CACHE_WAYS; ++j) {
+      line_cache_lines_release(old_sets[i].ways[j].lines);
+    }
+  }
+  free(old_sets);
+
+  return EIP2537_SUCCESS;
+}
+
+void bls12_pairing_line_cache_get_stats(uint64_t* hits, uint64_t* misses) {
+  *hits   = BLS12_ATOMIC_LOAD(&(bls12_g2_line_cache.hits));
+  *misses = BLS12_ATOMIC_LOAD(&(bls12_g2_line_cache.misses));
+}
+
+/* Pairing work over a contiguous range of pairs, one per thread */
+typedef struct {
+  const byte*            in;         /* encoding of the first pair */
+  size_t                 num_pairs;  /* number of pairs in the range */
+  blst_p1_affine*        p1s;        /* decoded G1 points, one per pair */
+  blst_p2_affine*        p2s;        /* decoded G2 points, one per pair */
+  const blst_p1_affine** p1_ptrs;    /* G1 points for the Miller loop */
+  const blst_p2_affine** p2_ptrs;    /* G2 points for the Miller loop */
+  blst_p1*               sums;       /* normalization scratch, per pair */
+  byte*                  merged;
+  size_t*                slots;      /* repeated G2 table of the range */
+  size_t                 table_size;
+  byte*                  failed;     /* set once any range fails */
+  size_t                 eliminated; /* pairs removed by normalization */
+  blst_fp12              result;     /* multi Miller loop over the range */
+  EIP2537_ERROR          ret;        /* first error encountered in range */
+} bls12_pairing_work;
+
+/* Small checks stay on the calling thread */
+static size_t bls12_pairing_num_threads(size_t num_pairs) {
+  size_t num_threads = 1;
+
+  if (num_pairs >= BLS12_ATOMIC_LOAD(&bls12_pairing_parallel_threshold)) {
+    num_threads = bls12_get_num_threads();
+    if (num_threads > num_pairs) {
+      num_threads = num_pairs;
+    }
+  }
+
+  return num_threads;
+}
 
+/* Decode and validate pairs one by one, gives the exact first error */
+static EIP2537_ERROR bls12_pairing_decode_serial(blst_p1_affine* p1s,
+                                                 blst_p2_affine* p2s,
+                                                 const byte* in,
+                                                 size_t num_pairs) {
   for (size_t i = 0; i < num_pairs; ++i) {
-    /* Decode inputs */
-    blst_p2_affine a_aff;
-    ret = decode_g2_point(&a_aff, in);
+    /* Decode inputs and check subgroups */
+    EIP2537_ERROR ret = decode_g1_point_in_g1(&(p1s[i]), in);
     if (ret != EIP2537_SUCCESS) {
       return ret;
     }
 
-    blst_scalar scalar;
-    ret = decode_scalar(&scalar, in + 256);
+    ret = decode_g2_point_in_g2(&(p2s[i]), in + 128);
     if (ret != EIP2537_SUCCESS) {
       return ret;
     }
 
-    in += 288;
+    in += 384;
+  }
 
-    /* Input needs to be projective for scalar multiplication function */
-    blst_p2 a;
-    blst_p2_from_affine(&a, &a_aff);
+  return EIP2537_SUCCESS;
+}
 
-    /* P = A * scalar */
-    blst_p2 p;
-    blst_p2_mult(&p, &a, scalar.b, 256);
+/* Decode and validate a range of pairs. Points are decoded in bulk a block
+   at a time, then subgroup checked per pair. A block with a bad point is
+   redone pair by pair so the error is the one the serial order gives */
+static EIP2537_ERROR bls12_pairing_decode(blst_p1_affine* p1s,
+                                          blst_p2_affine* p2s,
+                                          const byte* in, size_t num_pairs) {
+  byte states1[POINT_DECODE_BLOCK];
+  byte states2[POINT_DECODE_BLOCK];
+
+  for (size_t start = 0; start < num_pairs; start += POINT_DECODE_BLOCK) {
+    const byte* block = in + (start * 384);
+    size_t      num   = num_pairs - start;
+    if (num > POINT_DECODE_BLOCK) {
+      num = POINT_DECODE_BLOCK;
+    }
 
-    /* result = result + P */
-    blst_p2_add_or_double(&result, &result, &p);
-  }
+    EIP2537_ERROR ret = decode_g1_points(p1s + start, block, 384, num,
+                                         states1);
+    if (ret == EIP2537_SUCCESS) {
+      ret = decode_g2_points(p2s + start, block + 128, 384, num, states2);
+    }
+    if (ret != EIP2537_SUCCESS) {
+      return bls12_pairing_decode_serial(p1s + start, p2s + start, block,
+                                         num);
+    }
 
-  /* Convert result point to affine */
-  blst_p2_affine p_aff;
-  blst_p2_to_affine(&p_aff, &result);
+    for (size_t i = 0; i < num; ++i) {
+      const byte* pair = block + (i * 384);
 
-  /* Encode affine point to EIP format */
-  encode_g2_point(out, &p_aff);
+      ret = check_g1_point_in_g1(&(p1s[start + i]), pair, states1[i]);
+      if (ret != EIP2537_SUCCESS) {
+        return ret;
+      }
+
+      ret = check_g2_point_in_g2(&(p2s[start + i]), pair + 128, states2[i]);
+      if (ret != EIP2537_SUCCESS) {
+        return ret;
+      }
+    }
+  }
 
   return EIP2537_SUCCESS;
 }
 
-/* Bos-Coster implementation of MSM */
-EIP2537_ERROR bls12_g2multiexp_bc(byte out[256], byte* in, size_t in_len) {
-  /* Check length, is this even necessary? */
-  if ((in_len == 0) || ((in_len % 288) != 0)) {
-    return EIP2537_INVALID_LENGTH;
+/* Run Miller loops over num_pairs (at least one) pairs. Pairs with cached
+   G2 lines only evaluate the lines at the G1 point, the rest share one
+   multi Miller loop with the Fp12 accumulator squarings common to all */
+static void bls12_pairing_miller(blst_fp12* out,
+                                 const blst_p1_affine** p1_ptrs,
+                                 const blst_p2_affine** p2_ptrs,
+                                 size_t num_pairs) {
+  size_t    n = num_pairs;
+  blst_fp12 lines_result;
+  int       have_lines = 0;
+
+  if (BLS12_ATOMIC_LOAD(&(bls12_g2_line_cache.num_sets)) != 0) {
+    n = 0;
+    for (size_t i = 0; i < num_pairs; ++i) {
+      bls12_line_cache_lines* cached;
+      int state = line_cache_lookup(p2_ptrs[i], &cached);
+
+      if (state == LINE_CACHE_MISS) {
+        p1_ptrs[n] = p1_ptrs[i];
+        p2_ptrs[n] = p2_ptrs[i];
+        n++;
+        continue;
+      }
+
+      /* Lines computed here are shared with the cache, or left to the
+         multi Miller loop when they cannot be allocated */
+      if (state == LINE_CACHE_NO_LINES) {
+        cached = line_cache_lines_new();
+        if (cached == NULL) {
+          p1_ptrs[n] = p1_ptrs[i];
+          p2_ptrs[n] = p2_ptrs[i];
+          n++;
+          continue;
+        }
+        blst_precompute_lines(cached->lines, p2_ptrs[i]);
+        line_cache_store(p2_ptrs[i], cached);
+      }
+
+      if (have_lines) {
+        blst_fp12 cur_ml;
+        blst_miller_loop_lines(&cur_ml, cached->lines, p1_ptrs[i]);
+        blst_fp12_mul(&lines_result, &lines_result, &cur_ml);
+      }
+      else {
+        blst_miller_loop_lines(&lines_result, cached->lines, p1_ptrs[i]);
+        have_lines = 1;
+      }
+
+      line_cache_lines_release(cached);
+    }
   }
 
-  /* Get the number of point/scalar pairs to process */
-  size_t num_pairs = in_len / 288;
-
-  if (num_pairs == 1) {
-    return bls12_g2mul(out, in, in_len);
+  if (n > 0) {
+    /* TODO - may not exist in SWIG instances */
+    blst_miller_loop_n(out, p2_ptrs, p1_ptrs, n);
+    if (have_lines) {
+      blst_fp12_mul(out, out, &lines_result);
+    }
+  }
+  else {
+    *out = lines_result;
   }
+}
 
-  /* Allocate memory for scalars and bases */
-  blst_p2* bases;
-  blst_msm_scalar* scalars;
+/* Hash of a G2 point used to find repeated points in pairing input */
+static size_t blst_p2_affine_hash(const blst_p2_affine* p) {
+  uint64_t h = 0;
 
-  bases = (blst_p2*) malloc(num_pairs * sizeof(blst_p2));
-  if (bases == NULL) {
-    return EIP2537_MEMORY_ERROR;
+  for (size_t i = 0; i < (sizeof(blst_fp) / sizeof(limb_t)); ++i) {
+    h ^= (uint64_t)p->x.fp[0].l[i] ^ ((uint64_t)p->x.fp[1].l[i] << 1);
   }
 
-  scalars = (blst_msm_scalar*) malloc(num_pairs * sizeof(blst_msm_scalar));
-  if (scalars == NULL) {
-    free(bases);
-    return EIP2537_MEMORY_ERROR;
-  }
+  return (size_t)((h * 0x9e3779b97f4a7c15ULL) >> 32);
+}
 
-  EIP2537_ERROR ret;
+/* Drop pairs with a point at infinity and merge pairs sharing a G2 point by
+   adding their G1 points, e(a, Q) * e(b, Q) = e(a + b, Q). Remaining pairs
+   are written to p1_ptrs/p2_ptrs and their number returned */
+static size_t bls12_pairing_normalize(blst_p1_affine* p1s,
+                                      const blst_p2_affine* p2s, size_t k,
+                                      const blst_p1_affine** p1_ptrs,
+                                      const blst_p2_affine** p2_ptrs,
+                                      blst_p1* sums, byte* merged,
+                                      size_t* slots, size_t table_size) {
+  size_t n = 0;
 
-  /* Decode all inputs and copy into arrays that can be modified */
-  for (size_t i = 0; i < num_pairs; ++i) {
-    /* Decode inputs */
-    blst_p2_affine a_aff;
-    ret = decode_g2_point(&a_aff, in);
-    if (ret != EIP2537_SUCCESS) {
-      free(bases);
-      free(scalars);
-      return ret;
+  /* Open addressing on the G2 point, slot holds index of pair plus one */
+  memset(slots, 0, table_size * sizeof(size_t));
+
+  for (size_t i = 0; i < k; ++i) {
+    if (blst_p1_affine_is_inf(&(p1s[i])) ||
+        blst_p2_affine_is_inf(&(p2s[i]))) {
+      continue;
     }
 
-    /* Input needs to be projective for scalar multiplication function */
-    blst_p2_from_affine(&(bases[i]), &a_aff);
+    size_t h = blst_p2_affine_hash(&(p2s[i])) & (table_size - 1);
+    while ((slots[h] != 0) &&
+           (memcmp(p2_ptrs[slots[h] - 1], &(p2s[i]),
+                   sizeof(blst_p2_affine)) != 0)) {
+      h = (h + 1) & (table_size - 1);
+    }
+
+    if (slots[h] == 0) {
+      slots[h]   = n + 1;
+      p1_ptrs[n] = &(p1s[i]);
+      p2_ptrs[n] = &(p2s[i]);
+      merged[n]  = 0;
+      n++;
+    }
+    else {
+      size_t j = slots[h] - 1;
+
+      if (!merged[j]) {
+        blst_p1_from_affine(&(sums[j]), p1_ptrs[j]);
+        merged[j] = 1;
+      }
+      blst_p1_add_or_double_affine(&(sums[j]), &(sums[j]), &(p1s[i]));
+    }
+  }
+
+  /* Merged G1 sums replace the first G1 point, sums at infinity drop out */
+  size_t m = 0;
 
-    ret = decode_scalar(&(scalars[i].k), in + 256);
-    if (ret != EIP2537_SUCCESS) {
-      free(bases);
-      free(scalars);
-      return ret;
+  for (size_t j = 0; j < n; ++j) {
+    if (merged[j]) {
+      if (blst_p1_is_inf(&(sums[j]))) {
+        continue;
+      }
+      blst_p1_to_affine(&(p1s[p1_ptrs[j] - p1s]), &(sums[j]));
     }
-    scalars[i].base_index = i;
 
-    in += 288;
+    p1_ptrs[m] = p1_ptrs[j];
+    p2_ptrs[m] = p2_ptrs[j];
+    m++;
   }
 
-  /* Build heap */
-  blst_scalars_max_heapify(scalars, num_pairs);
-
-  blst_p2 skipped_result = { {{{{0}}, {{0}}}},
-                             {{{{0}}, {{0}}}},
-                             {{{{0}}, {{0}}}} }; /* Infinity */
+  return m;
+}
 
-  /* Loop until there is only one pair left */
-  while (blst_scalars_max_heapreplace_p2(&skipped_result, bases,
-                                         scalars, num_pairs));
+/* Decode, normalize and run the Miller loop over a range of pairs on one
+   thread, so a pairing spawns its threads once. Repeated G2 points only
+   merge within a range, ranges stop before the Miller loop once any range
+   has failed */
+static void* bls12_pairing_worker(void* arg) {
+  bls12_pairing_work* work = (bls12_pairing_work*)arg;
 
-  /* Down to only one point/scalar pair, perform final scalar mul */
-  int num_bits_left = blst_scalar_num_bits(&(scalars[0].k));
-  blst_p2 result;
-  blst_p2_mult(&result, &(bases[scalars[0].base_index]),
-               (scalars[0].k).b, num_bits_left);
+  work->result = *blst_fp12_one();
 
-  /* In case any values needed to be skipped over in bc due to deltas */
-  if (!blst_p2_is_inf(&skipped_result)) {
-    /* result = result + skipped_result */
-    blst_p2_add_or_double(&result, &result, &skipped_result);
+  work->ret = bls12_pairing_decode(work->p1s, work->p2s, work->in,
+                                   work->num_pairs);
+  if (work->ret != EIP2537_SUCCESS) {
+    BLS12_ATOMIC_STORE(work->failed, 1);
+    return NULL;
   }
 
-  /* Convert result point to affine */
-  blst_p2_affine p_aff;
-  blst_p2_to_affine(&p_aff, &result);
+  size_t n = bls12_pairing_normalize(work->p1s, work->p2s, work->num_pairs,
+                                     work->p1_ptrs, work->p2_ptrs,
+                                     work->sums, work->merged, work->slots,
+                                     work->table_size);
 
-  /* Encode affine point to EIP format */
-  encode_g2_point(out, &p_aff);
+  work->eliminated = work->num_pairs - n;
 
-  /* Free allocated memory */
-  free(bases);
-  free(scalars);
+  if ((n > 0) && !BLS12_ATOMIC_LOAD(work->failed)) {
+    bls12_pairing_miller(&(work->result), work->p1_ptrs, work->p2_ptrs, n);
+  }
 
-  return EIP2537_SUCCESS;
+  return NULL;
 }
 
-/*
-  ABI for pairing
-
-  Pairing call expects 384*k bytes as an inputs that is interpreted as byte
-    concatenation of k slices. Each slice has the following structure:
-      128 bytes of G1 point encoding
-      256 bytes of G2 point encoding
-
-  Output is a 32 bytes where first 31 bytes are equal to 0x00 and the last
-    byte is 0x01 if pairing result is equal to multiplicative identity in a
-    pairing target field and 0x00 otherwise.
-
-  Error cases:
-    Any of G1 or G2 points being not on the curve must result in error
-    Any of G1 or G2 points are not in the correct subgroup
-    Field elements encoding rules apply (obviously)
-    Input has invalid length
-    Input is empty
-*/
-/* TODO - parallelize if better performance is required */
 EIP2537_ERROR bls12_pairing(byte out[32], byte* in, size_t in_len) {
   /* Check length, is this even necessary? */
   if ((in_len == 0) || ((in_len % 384) != 0)) {
@@ -1026,48 +5128,95 @@ EIP2537_ERROR bls12_pairing(byte out[32], byte* in, size_t in_len) {
   /* Get the number of point pairs to process */
   size_t k = in_len / 384;
 
-  EIP2537_ERROR ret;
+  size_t num_threads = bls12_pairing_num_threads(k);
 
-  blst_fp12 result;
+  bls12_pairing_work* work;
+  work = (bls12_pairing_work*) malloc(num_threads * sizeof(bls12_pairing_work));
+  if (work == NULL) {
+    return EIP2537_MEMORY_ERROR;
+  }
 
-  for (size_t i = 0; i < k; ++i) {
-    /* Decode inputs */
-    blst_p1_affine p1_aff;
-    ret = decode_g1_point(&p1_aff, in);
-    if (ret != EIP2537_SUCCESS) {
-      return ret;
+  /* Split pairs into contiguous ranges, earlier ranges take the remainder,
+     each with a hash table for repeated G2 points at most half full */
+  size_t num_slots = 0;
+  for (size_t t = 0; t < num_threads; ++t) {
+    work[t].num_pairs  = (k / num_threads) + (t < (k % num_threads));
+    work[t].table_size = 2;
+    while (work[t].table_size < (2 * work[t].num_pairs)) {
+      work[t].table_size <<= 1;
     }
+    num_slots += work[t].table_size;
+  }
 
-    if(!blst_p1_affine_in_g1(&p1_aff)) {
-      return EIP2537_POINT_NOT_IN_SUBGROUP;
-    }
+  /* Decoded points, normalized pairs and normalization scratch */
+  byte* pair_mem;
+  pair_mem = (byte*) malloc((k * (sizeof(blst_p1_affine) +
+                                  sizeof(blst_p2_affine) +
+                                  sizeof(blst_p1_affine*) +
+                                  sizeof(blst_p2_affine*) +
+                                  sizeof(blst_p1) + 1)) +
+                            (num_slots * sizeof(size_t)));
+  if (pair_mem == NULL) {
+    free(work);
+    return EIP2537_MEMORY_ERROR;
+  }
 
-    blst_p2_affine p2_aff;
-    ret = decode_g2_point(&p2_aff, in + 128);
-    if (ret != EIP2537_SUCCESS) {
+  blst_p1_affine*        p1s     = (blst_p1_affine*)pair_mem;
+  blst_p2_affine*        p2s     = (blst_p2_affine*)(p1s + k);
+  const blst_p1_affine** p1_ptrs = (const blst_p1_affine**)(p2s + k);
+  const blst_p2_affine** p2_ptrs = (const blst_p2_affine**)(p1_ptrs + k);
+  blst_p1*               sums    = (blst_p1*)(p2_ptrs + k);
+  size_t*                slots   = (size_t*)(sums + k);
+  byte*                  merged  = (byte*)(slots + num_slots);
+  byte                   failed  = 0;
+
+  for (size_t t = 0, start = 0; t < num_threads; ++t) {
+    work[t].in      = in + (start * 384);
+    work[t].p1s     = p1s + start;
+    work[t].p2s     = p2s + start;
+    work[t].p1_ptrs = p1_ptrs + start;
+    work[t].p2_ptrs = p2_ptrs + start;
+    work[t].sums    = sums + start;
+    work[t].merged  = merged + start;
+    work[t].slots   = slots;
+    work[t].failed  = &failed;
+    slots          += work[t].table_size;
+    start          += work[t].num_pairs;
+  }
+
+  if (!bls12_run_tasks(bls12_pairing_worker, work,
+                       sizeof(bls12_pairing_work), num_threads)) {
+    free(work);
+    free(pair_mem);
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  /* Report the error of the earliest failing pair, as a serial loop would */
+  for (size_t t = 0; t < num_threads; ++t) {
+    if (work[t].ret != EIP2537_SUCCESS) {
+      EIP2537_ERROR ret = work[t].ret;
+      free(work);
+      free(pair_mem);
       return ret;
     }
+  }
 
-    if(!blst_p2_affine_in_g2(&p2_aff)) {
-      return EIP2537_POINT_NOT_IN_SUBGROUP;
-    }
+  blst_fp12 result     = work[0].result;
+  size_t    eliminated = work[0].eliminated;
+  for (size_t t = 1; t < num_threads; ++t) {
+    blst_fp12_mul(&result, &result, &(work[t].result));
+    eliminated += work[t].eliminated;
+  }
 
-    in += 384;
+  BLS12_ATOMIC_ADD(&bls12_pairing_eliminated, (uint64_t)eliminated);
 
-    if (i > 0) {
-      blst_fp12 cur_ml;
-      /* TODO - may not exist in SWIG instances */
-      blst_miller_loop(&cur_ml, &p2_aff, &p1_aff);
-      blst_fp12_mul(&result, &result, &cur_ml);
-    }
-    else {
-      /* TODO - may not exist in SWIG instances */
-      blst_miller_loop(&result, &p2_aff, &p1_aff);
-    }
+  if (eliminated < k) {
+    /* TODO - may not exist in SWIG instances */
+    blst_final_exp(&result, &result);
   }
 
-  /* TODO - may not exist in SWIG instances */
-  blst_final_exp(&result, &result);
+  free(work);
+  free(pair_mem);
 
   for (size_t i = 0; i < 32; ++i) {
     out[i] = 0;
@@ -1091,8 +5240,9 @@ EIP2537_ERROR bls12_pairing(byte out[32], byte* in, size_t in_len) {
     Input has invalid length
     Input is not a valid field element
 */
-EIP2537_ERROR bls12_map_fp_to_g1(byte out[128], const byte in[64],
-                                 size_t in_len) {
+static EIP2537_ERROR bls12_map_fp_to_g1_projective(blst_p1* out,
+                                                   const byte* in,
+                                                   size_t in_len) {
   /* Check length, is this even necessary? */
   if (in_len != 64) {
     return EIP2537_INVALID_LENGTH;
@@ -1108,9 +5258,19 @@ EIP2537_ERROR bls12_map_fp_to_g1(byte out[128], const byte in[64],
   }
 
   /* Map To G1 */
-  blst_p1 p;
   /* TODO - may not exist in SWIG instances */
-  blst_map_to_g1(&p, &fp, NULL);
+  blst_map_to_g1(out, &fp, NULL);
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_map_fp_to_g1(byte out[128], const byte in[64],
+                                 size_t in_len) {
+  blst_p1 p;
+  EIP2537_ERROR ret = bls12_map_fp_to_g1_projective(&p, in, in_len);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
 
   /* Convert point to affine */
   blst_p1_affine p_aff;
@@ -1133,8 +5293,9 @@ EIP2537_ERROR bls12_map_fp_to_g1(byte out[128], const byte in[64],
     Input has invalid length
     Input is not a valid field element
 */
-EIP2537_ERROR bls12_map_fp2_to_g2(byte out[256], const byte in[128],
-                                  size_t in_len) {
+static EIP2537_ERROR bls12_map_fp2_to_g2_projective(blst_p2* out,
+                                                    const byte* in,
+                                                    size_t in_len) {
   /* Check length, is this even necessary? */
   if (in_len != 128) {
     return EIP2537_INVALID_LENGTH;
@@ -1150,9 +5311,19 @@ EIP2537_ERROR bls12_map_fp2_to_g2(byte out[256], const byte in[128],
   }
 
   /* Map To G2 */
-  blst_p2 p;
   /* TODO - may not exist in SWIG instances */
-  blst_map_to_g2(&p, &fp2, NULL);
+  blst_map_to_g2(out, &fp2, NULL);
+
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_map_fp2_to_g2(byte out[256], const byte in[128],
+                                  size_t in_len) {
+  blst_p2 p;
+  EIP2537_ERROR ret = bls12_map_fp2_to_g2_projective(&p, in, in_len);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
 
   /* Convert point to affine */
   blst_p2_affine p_aff;
@@ -1164,6 +5335,89 @@ EIP2537_ERROR bls12_map_fp2_to_g2(byte out[256], const byte in[128],
   return EIP2537_SUCCESS;
 }
 
+/* Batched maps, calls are split into contiguous ranges across threads and
+   each range shares the inversion to affine as the ADD/MUL batches */
+#define BLS12_MAP_TASK_MIN 4
+
+typedef struct {
+  byte*              out;
+  EIP2537_ERROR*     errs;
+  const byte* const* in;
+  const size_t*      in_len;
+  size_t             n;
+  EIP2537_ERROR      ret;
+} bls12_map_work;
+
+static void* blst_p1s_map_worker(void* arg) {
+  bls12_map_work* work = (bls12_map_work*)arg;
+  work->ret = blst_p1s_batch(work->out, work->errs, work->in, work->in_len,
+                             work->n, bls12_map_fp_to_g1_projective);
+  return NULL;
+}
+
+static void* blst_p2s_map_worker(void* arg) {
+  bls12_map_work* work = (bls12_map_work*)arg;
+  work->ret = blst_p2s_batch(work->out, work->errs, work->in, work->in_len,
+                             work->n, bls12_map_fp2_to_g2_projective);
+  return NULL;
+}
+
+static EIP2537_ERROR bls12_map_batch(void* (*worker)(void*), byte* out,
+                                     size_t out_len, EIP2537_ERROR* errs,
+                                     const byte* const* in,
+                                     const size_t* in_len, size_t n) {
+  bls12_map_work work[BLS12_STACK_TASKS];
+  size_t num_tasks = bls12_get_num_threads();
+  if (num_tasks > (n / BLS12_MAP_TASK_MIN)) {
+    num_tasks = n / BLS12_MAP_TASK_MIN;
+  }
+  if (num_tasks > BLS12_STACK_TASKS) {
+    num_tasks = BLS12_STACK_TASKS;
+  }
+  if (num_tasks == 0) {
+    num_tasks = 1;
+  }
+
+  size_t start = 0;
+  for (size_t t = 0; t < num_tasks; ++t) {
+    work[t].n      = (n / num_tasks) + (t < (n % num_tasks));
+    work[t].out    = out + (start * out_len);
+    work[t].errs   = errs + start;
+    work[t].in     = in + start;
+    work[t].in_len = in_len + start;
+    start         += work[t].n;
+  }
+
+  if (!bls12_run_tasks(worker, work, sizeof(bls12_map_work), num_tasks)) {
+    return EIP2537_MEMORY_ERROR;
+  }
+
+  /* First failed call in input order */
+  for (size_t t = 0; t < num_tasks; ++t) {
+    if (work[t].ret != EIP2537_SUCCESS) {
+      return work[t].ret;
+    }
+  }
+
+  return EIP2537_SUCCESS;
+}
+
+/* Batched map to G1, n inputs of 64 bytes with 128 byte outputs written back
+   to back in out and per call errors in errs */
+EIP2537_ERROR bls12_map_fp_to_g1_batch(byte* out, EIP2537_ERROR* errs,
+                                       const byte* const* in,
+                                       const size_t* in_len, size_t n) {
+  return bls12_map_batch(blst_p1s_map_worker, out, 128, errs, in, in_len, n);
+}
+
+/* Batched map to G2, as bls12_map_fp_to_g1_batch with 128 byte inputs and
+   256 byte outputs */
+EIP2537_ERROR bls12_map_fp2_to_g2_batch(byte* out, EIP2537_ERROR* errs,
+                                        const byte* const* in,
+                                        const size_t* in_len, size_t n) {
+  return bls12_map_batch(blst_p2s_map_worker, out, 256, errs, in, in_len, n);
+}
+
 
 /* Gas Costs */
 const uint64_t BLS12_G1ADD_GAS         = 600;
@@ -1270,3 +5524,260 @@ uint64_t bls12_map_fp2_to_g2_gas() {
   return BLS12_MAP_FP2_TO_G2_GAS;
 };
 
+/* Gas budgeted calls, nothing is decoded before the cost is charged */
+/* Out of gas consumes the whole limit, so gas_used never exceeds it */
+static EIP2537_ERROR bls12_charge_gas(uint64_t cost, uint64_t gas_limit,
+                                      uint64_t* gas_used) {
+  if (cost > gas_limit) {
+    *gas_used = gas_limit;
+    return EIP2537_OUT_OF_GAS;
+  }
+
+  *gas_used = cost;
+  return EIP2537_SUCCESS;
+}
+
+EIP2537_ERROR bls12_g1add_with_gas(byte out[128], const byte in[256],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if (in_len != 256) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_g1add_gas(),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_g1add(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_g1mul_with_gas(byte out[128], const byte in[160],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if (in_len != 160) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_g1mul_gas(),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_g1mul(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_g1multiexp_with_gas(byte out[128], byte* in,
+                                        size_t in_len, uint64_t gas_limit,
+                                        uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if ((in_len == 0) || ((in_len % 160) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_g1multiexp_gas(in_len),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_g1multiexp(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_g2add_with_gas(byte out[256], const byte in[512],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if (in_len != 512) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_g2add_gas(),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_g2add(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_g2mul_with_gas(byte out[256], const byte in[288],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if (in_len != 288) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_g2mul_gas(),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_g2mul(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_g2multiexp_with_gas(byte out[256], byte* in,
+                                        size_t in_len, uint64_t gas_limit,
+                                        uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if ((in_len == 0) || ((in_len % 288) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_g2multiexp_gas(in_len),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_g2multiexp(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_pairing_with_gas(byte out[32], byte* in,
+                                     size_t in_len, uint64_t gas_limit,
+                                     uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if ((in_len == 0) || ((in_len % 384) != 0)) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_pairing_gas(in_len),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_pairing(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_map_fp_to_g1_with_gas(byte out[128], const byte in[64],
+                                          size_t in_len, uint64_t gas_limit,
+                                          uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if (in_len != 64) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_map_fp_to_g1_gas(),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_map_fp_to_g1(out, in, in_len);
+}
+
+EIP2537_ERROR bls12_map_fp2_to_g2_with_gas(byte out[256], const byte in[128],
+                                           size_t in_len, uint64_t gas_limit,
+                                           uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if (in_len != 128) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  EIP2537_ERROR ret = bls12_charge_gas(bls12_map_fp2_to_g2_gas(),
+                                       gas_limit, gas_used);
+  if (ret != EIP2537_SUCCESS) {
+    return ret;
+  }
+
+  return bls12_map_fp2_to_g2(out, in, in_len);
+}
+
+/* Precompile table indexed by address - BLS12_G1ADD_ADDRESS, inputs of the
+   multiexp and pairing calls are not written to */
+static EIP2537_ERROR bls12_g1multiexp_run(byte* out, const byte* in,
+                                          size_t in_len, uint64_t gas_limit,
+                                          uint64_t* gas_used) {
+  return bls12_g1multiexp_with_gas(out, (byte*)in, in_len, gas_limit,
+                                   gas_used);
+}
+
+static EIP2537_ERROR bls12_g2multiexp_run(byte* out, const byte* in,
+                                          size_t in_len, uint64_t gas_limit,
+                                          uint64_t* gas_used) {
+  return bls12_g2multiexp_with_gas(out, (byte*)in, in_len, gas_limit,
+                                   gas_used);
+}
+
+static EIP2537_ERROR bls12_pairing_run(byte* out, const byte* in,
+                                       size_t in_len, uint64_t gas_limit,
+                                       uint64_t* gas_used) {
+  return bls12_pairing_with_gas(out, (byte*)in, in_len, gas_limit, gas_used);
+}
+
+typedef struct {
+  size_t        out_len;
+  EIP2537_ERROR (*run)(byte* out, const byte* in, size_t in_len,
+                       uint64_t gas_limit, uint64_t* gas_used);
+} bls12_precompile;
+
+static const bls12_precompile bls12_precompiles[] = {
+  { 128, bls12_g1add_with_gas },
+  { 128, bls12_g1mul_with_gas },
+  { 128, bls12_g1multiexp_run },
+  { 256, bls12_g2add_with_gas },
+  { 256, bls12_g2mul_with_gas },
+  { 256, bls12_g2multiexp_run },
+  {  32, bls12_pairing_run },
+  { 128, bls12_map_fp_to_g1_with_gas },
+  { 256, bls12_map_fp2_to_g2_with_gas },
+};
+
+EIP2537_ERROR eip2537_run(uint64_t address, const byte* in, size_t in_len,
+                          byte* out, size_t out_len, uint64_t gas_limit,
+                          uint64_t* gas_used) {
+  *gas_used = 0;
+
+  if ((address < BLS12_G1ADD_ADDRESS) ||
+      (address > BLS12_MAP_FP2_TO_G2_ADDRESS)) {
+    return EIP2537_UNKNOWN_ADDRESS;
+  }
+
+  const bls12_precompile* precompile =
+    &(bls12_precompiles[address - BLS12_G1ADD_ADDRESS]);
+
+  if (out_len < precompile->out_len) {
+    return EIP2537_INVALID_LENGTH;
+  }
+
+  return precompile->run(out, in, in_len, gas_limit, gas_used);
+}
+
+/* Many calls in one, for bindings where each call across the boundary is
+   expensive */
+EIP2537_ERROR eip2537_run_batch(const uint64_t* address, const byte* in,
+                                const size_t* in_offset, byte* out,
+                                const size_t* out_offset,
+                                const uint64_t* gas_limit, uint64_t* gas_used,
+                                EIP2537_ERROR* errs, size_t n) {
+  EIP2537_ERROR ret = EIP2537_SUCCESS;
+
+  for (size_t i = 0; i < n; ++i) {
+    errs[i] = eip2537_run(address[i], in + in_offset[i],
+                          in_offset[i + 1] - in_offset[i],
+                          out + out_offset[i],
+                          out_offset[i + 1] - out_offset[i], gas_limit[i],
+                          &(gas_used[i]));
+    if ((errs[i] != EIP2537_SUCCESS) && (ret == EIP2537_SUCCESS)) {
+      ret = errs[i];
+    }
+  }
+
+  return ret;
+}
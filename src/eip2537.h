@@ -15,18 +15,18 @@
 extern void blst_fp_to(blst_fp* ret, const blst_fp* a);
 extern void blst_fp_from(blst_fp* ret, const blst_fp* a);
 
-/*
-Addresses - do we need to do anything here?
-BLS12_G1ADD         0x0a
-BLS12_G1MUL         0x0b
-BLS12_G1MULTIEXP    0x0c
-BLS12_G2ADD         0x0d
-BLS12_G2MUL         0x0e
-BLS12_G2MULTIEXP    0x0f
-BLS12_PAIRING       0x10
-BLS12_MAP_FP_TO_G1 	0x11
-BLS12_MAP_FP2_TO_G2 0x12
-*/
+/* Precompile addresses, see eip2537_run */
+typedef enum {
+  BLS12_G1ADD_ADDRESS         = 0x0a,
+  BLS12_G1MUL_ADDRESS         = 0x0b,
+  BLS12_G1MULTIEXP_ADDRESS    = 0x0c,
+  BLS12_G2ADD_ADDRESS         = 0x0d,
+  BLS12_G2MUL_ADDRESS         = 0x0e,
+  BLS12_G2MULTIEXP_ADDRESS    = 0x0f,
+  BLS12_PAIRING_ADDRESS       = 0x10,
+  BLS12_MAP_FP_TO_G1_ADDRESS  = 0x11,
+  BLS12_MAP_FP2_TO_G2_ADDRESS = 0x12,
+} EIP2537_ADDRESS;
 
 typedef enum {
   EIP2537_SUCCESS = 0,
@@ -37,6 +37,10 @@ typedef enum {
   EIP2537_INVALID_LENGTH,
   EIP2537_EMPTY_INPUT,
   EIP2537_MEMORY_ERROR,
+  EIP2537_OUT_OF_GAS,
+  EIP2537_UNKNOWN_ADDRESS,
+  EIP2537_FIXED_BASE_LIMIT,
+  EIP2537_INVALID_SELECTION,
 } EIP2537_ERROR;
 
 EIP2537_ERROR bls12_g1add(byte out[128], const byte in[256], size_t in_len);
@@ -44,20 +48,193 @@ EIP2537_ERROR bls12_g1mul(byte out[128], const byte in[160], size_t in_len);
 EIP2537_ERROR bls12_g1multiexp(byte out[128], byte* in, size_t in_len);
 EIP2537_ERROR bls12_g1multiexp_naive(byte out[128], byte* in, size_t in_len);
 EIP2537_ERROR bls12_g1multiexp_bc(byte out[128], byte* in, size_t in_len);
+EIP2537_ERROR bls12_g1multiexp_pippenger(byte out[128], byte* in,
+                                         size_t in_len);
+EIP2537_ERROR bls12_g1multiexp_straus(byte out[128], byte* in,
+                                      size_t in_len);
+/* GLV (G1) and GLS (G2) MUL for points in the subgroup. Each call runs the
+   full subgroup check unless the point cache already holds the verdict, so
+   without the cache they are a net loss against bls12_g1mul/bls12_g2mul.
+   Straus multiexp takes the same split for points with a cached verdict */
+EIP2537_ERROR bls12_g1mul_glv(byte out[128], const byte in[160],
+                              size_t in_len);
 
 EIP2537_ERROR bls12_g2add(byte out[256], const byte in[512], size_t in_len);
 EIP2537_ERROR bls12_g2mul(byte out[256], const byte in[288], size_t in_len);
 EIP2537_ERROR bls12_g2multiexp(byte out[256], byte* in, size_t in_len);
 EIP2537_ERROR bls12_g2multiexp_naive(byte out[256], byte* in, size_t in_len);
 EIP2537_ERROR bls12_g2multiexp_bc(byte out[256], byte* in, size_t in_len);
+EIP2537_ERROR bls12_g2multiexp_pippenger(byte out[256], byte* in,
+                                         size_t in_len);
+EIP2537_ERROR bls12_g2multiexp_straus(byte out[256], byte* in,
+                                      size_t in_len);
+EIP2537_ERROR bls12_g2mul_gls(byte out[256], const byte in[288],
+                              size_t in_len);
 
 EIP2537_ERROR bls12_pairing(byte out[32], byte* in, size_t in_len);
 
+/* Batches of independent ADD/MUL calls sharing the inversion to affine.
+   Outputs are written back to back in out (128 or 256 bytes each) with the
+   status of each call in errs, failed calls leave zeros. The return value is
+   the error of the first failed call */
+EIP2537_ERROR bls12_g1add_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n);
+EIP2537_ERROR bls12_g1mul_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n);
+EIP2537_ERROR bls12_g2add_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n);
+EIP2537_ERROR bls12_g2mul_batch(byte* out, EIP2537_ERROR* errs,
+                                const byte* const* in, const size_t* in_len,
+                                size_t n);
+
+/* Pairs dropped or merged away before the Miller loop, over all calls.
+   Threaded pairings only merge repeated G2 points within a thread's range */
+uint64_t bls12_pairing_eliminated_pairs();
+
+/* Cache of validated points keyed on their encoding, off by default.
+   Entries are rounded down to a power of two, 0 disables that group, and
+   reconfiguring clears the cache and its counters */
+typedef struct {
+  uint64_t g1_hits;
+  uint64_t g1_misses;
+  uint64_t g2_hits;
+  uint64_t g2_misses;
+} bls12_point_cache_stats;
+
+EIP2537_ERROR bls12_point_cache_configure(size_t g1_entries,
+                                          size_t g2_entries);
+void bls12_point_cache_get_stats(bls12_point_cache_stats* stats);
+
+/* Fixed argument pairing, cache of precomputed lines for repeated G2
+   points, off by default and 0 entries disables it. Entries are rounded
+   down to a power of two sets of 4, at least one set, and each entry with
+   lines takes about 20KB */
+EIP2537_ERROR bls12_pairing_line_cache_configure(size_t num_entries);
+void bls12_pairing_line_cache_get_stats(uint64_t* hits, uint64_t* misses);
+
+/* Fixed base tables used by g1mul/g2mul, the generator is always included
+   and up to 7 more well-known bases per group can be registered. Generator
+   tables are built when the library is loaded with GCC and Clang, other
+   compilers build them on first use unless bls12_fixed_base_init is called
+   at startup. Registering builds the table in the calling thread, an
+   already registered base is accepted again and a new base past the limit
+   returns EIP2537_FIXED_BASE_LIMIT */
+void bls12_fixed_base_init();
+EIP2537_ERROR bls12_g1_add_fixed_base(const byte base[128]);
+EIP2537_ERROR bls12_g2_add_fixed_base(const byte base[256]);
+
+/* Multiexp with caller owned scratch, scratch_size gives the bytes needed
+   for an input length at any alignment (0 when none is needed). The
+   dispatcher size covers every engine, and Pippenger runs with fewer threads
+   when the buffer was sized under a smaller thread count, so a buffer stays
+   valid across threading and selection changes. A NULL scratch uses the
+   thread local arena when the call fits in max_bytes, otherwise the heap for
+   that call only. The arena is off (0) by default and arena_release frees
+   the calling thread's buffer */
+size_t bls12_g1multiexp_scratch_size(size_t in_len);
+size_t bls12_g1multiexp_bc_scratch_size(size_t in_len);
+size_t bls12_g1multiexp_pippenger_scratch_size(size_t in_len);
+size_t bls12_g1multiexp_straus_scratch_size(size_t in_len);
+EIP2537_ERROR bls12_g1multiexp_with_scratch(byte out[128], byte* in,
+                                           size_t in_len, void* scratch,
+                                           size_t scratch_len);
+EIP2537_ERROR bls12_g1multiexp_bc_with_scratch(byte out[128], byte* in,
+                                              size_t in_len, void* scratch,
+                                              size_t scratch_len);
+EIP2537_ERROR bls12_g1multiexp_pippenger_with_scratch(byte out[128],
+                                                     byte* in, size_t in_len,
+                                                     void* scratch,
+                                                     size_t scratch_len);
+EIP2537_ERROR bls12_g1multiexp_straus_with_scratch(byte out[128],
+                                                   byte* in, size_t in_len,
+                                                   void* scratch,
+                                                   size_t scratch_len);
+
+size_t bls12_g2multiexp_scratch_size(size_t in_len);
+size_t bls12_g2multiexp_bc_scratch_size(size_t in_len);
+size_t bls12_g2multiexp_pippenger_scratch_size(size_t in_len);
+size_t bls12_g2multiexp_straus_scratch_size(size_t in_len);
+EIP2537_ERROR bls12_g2multiexp_with_scratch(byte out[256], byte* in,
+                                           size_t in_len, void* scratch,
+                                           size_t scratch_len);
+EIP2537_ERROR bls12_g2multiexp_bc_with_scratch(byte out[256], byte* in,
+                                              size_t in_len, void* scratch,
+                                              size_t scratch_len);
+EIP2537_ERROR bls12_g2multiexp_pippenger_with_scratch(byte out[256],
+                                                     byte* in, size_t in_len,
+                                                     void* scratch,
+                                                     size_t scratch_len);
+EIP2537_ERROR bls12_g2multiexp_straus_with_scratch(byte out[256],
+                                                   byte* in, size_t in_len,
+                                                   void* scratch,
+                                                   size_t scratch_len);
+
+void bls12_scratch_arena_configure(size_t max_bytes);
+void bls12_scratch_arena_release();
+
+/* Engine bls12_g1multiexp/bls12_g2multiexp use for inputs of up to
+   max_pairs pairs. Tables list entries in increasing max_pairs order, at
+   most 16, and the last entry also covers any larger input. Setting NULL
+   restores the default, an unknown engine or out of order max_pairs returns
+   EIP2537_INVALID_SELECTION, get returns the number of entries in the table.
+   Tables are swapped whole, so set is safe while other threads run.
+   bls12_multiexp_calibrate times every engine on this host up to max_pairs
+   and installs the fastest for each size, to be read back and set at init */
+typedef enum {
+  BLS12_MSM_NAIVE = 0,
+  BLS12_MSM_BC,
+  BLS12_MSM_STRAUS,
+  BLS12_MSM_PIPPENGER,
+} bls12_msm_engine;
+
+typedef struct {
+  size_t           max_pairs;
+  bls12_msm_engine engine;
+} bls12_msm_selection;
+
+EIP2537_ERROR bls12_g1multiexp_set_selection(const bls12_msm_selection* table,
+                                             size_t num_entries);
+EIP2537_ERROR bls12_g2multiexp_set_selection(const bls12_msm_selection* table,
+                                             size_t num_entries);
+size_t bls12_g1multiexp_get_selection(bls12_msm_selection* table,
+                                      size_t max_entries);
+size_t bls12_g2multiexp_get_selection(bls12_msm_selection* table,
+                                      size_t max_entries);
+EIP2537_ERROR bls12_multiexp_calibrate(size_t max_pairs);
+
+/* g1mul/g2mul cost follows the scalar length by default (inputs are public),
+   0 restores the constant time path. __EIP2537_CT_MUL__ changes the default.
+   Fixed bases keep their tables either way, walked with a masked select and
+   cneg per window in constant time */
+void bls12_mul_set_vartime(int enable);
+
+/* Threading configuration, num_threads of 0 uses all online cores */
+void bls12_set_num_threads(size_t num_threads);
+
+/* Thread count for calls made from the calling thread only, 1 keeps them
+   on that thread as pools running precompiles side by side want and 0
+   goes back to bls12_set_num_threads. Returns the previous value */
+size_t bls12_set_thread_num_threads(size_t num_threads);
+void bls12_pairing_set_parallel_threshold(size_t min_pairs);
+void bls12_multiexp_set_parallel_threshold(size_t min_pairs);
+
 EIP2537_ERROR bls12_map_fp_to_g1(byte out[128], const byte in[64],
                                  size_t in_len);
 EIP2537_ERROR bls12_map_fp2_to_g2(byte out[256], const byte in[128],
                                   size_t in_len);
 
+/* Batches of independent map calls, as the ADD/MUL batches. Calls are split
+   across threads (see bls12_set_num_threads) */
+EIP2537_ERROR bls12_map_fp_to_g1_batch(byte* out, EIP2537_ERROR* errs,
+                                       const byte* const* in,
+                                       const size_t* in_len, size_t n);
+EIP2537_ERROR bls12_map_fp2_to_g2_batch(byte* out, EIP2537_ERROR* errs,
+                                        const byte* const* in,
+                                        const size_t* in_len, size_t n);
+
 
 extern const uint64_t BLS12_G1ADD_GAS;
 extern const uint64_t BLS12_G1MUL_GAS;
@@ -81,4 +258,54 @@ uint64_t bls12_pairing_gas(uint64_t input_len);
 uint64_t bls12_map_fp_to_g1_gas();
 uint64_t bls12_map_fp2_to_g2_gas();
 
+/* Gas budgeted calls. The length is checked and the cost charged against
+   gas_limit before any input is decoded, EIP2537_OUT_OF_GAS is returned if
+   it does not fit. gas_used is the cost of the call once the length is
+   valid, gas_limit when out of gas (all gas given is consumed, as in the
+   EVM) and 0 for an invalid length */
+EIP2537_ERROR bls12_g1add_with_gas(byte out[128], const byte in[256],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used);
+EIP2537_ERROR bls12_g1mul_with_gas(byte out[128], const byte in[160],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used);
+EIP2537_ERROR bls12_g1multiexp_with_gas(byte out[128], byte* in,
+                                        size_t in_len, uint64_t gas_limit,
+                                        uint64_t* gas_used);
+EIP2537_ERROR bls12_g2add_with_gas(byte out[256], const byte in[512],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used);
+EIP2537_ERROR bls12_g2mul_with_gas(byte out[256], const byte in[288],
+                                   size_t in_len, uint64_t gas_limit,
+                                   uint64_t* gas_used);
+EIP2537_ERROR bls12_g2multiexp_with_gas(byte out[256], byte* in,
+                                        size_t in_len, uint64_t gas_limit,
+                                        uint64_t* gas_used);
+EIP2537_ERROR bls12_pairing_with_gas(byte out[32], byte* in, size_t in_len,
+                                     uint64_t gas_limit, uint64_t* gas_used);
+EIP2537_ERROR bls12_map_fp_to_g1_with_gas(byte out[128], const byte in[64],
+                                          size_t in_len, uint64_t gas_limit,
+                                          uint64_t* gas_used);
+EIP2537_ERROR bls12_map_fp2_to_g2_with_gas(byte out[256],
+                                           const byte in[128],
+                                           size_t in_len, uint64_t gas_limit,
+                                           uint64_t* gas_used);
+
+/* Run the precompile at address with the gas budgeted call for it, out must
+   hold out_len >= 128 (G1), 256 (G2) or 32 (pairing) bytes. Unknown
+   addresses return EIP2537_UNKNOWN_ADDRESS */
+EIP2537_ERROR eip2537_run(uint64_t address, const byte* in, size_t in_len,
+                          byte* out, size_t out_len, uint64_t gas_limit,
+                          uint64_t* gas_used);
+
+/* n calls of eip2537_run over contiguous arenas, call i reads
+   in[in_offset[i]..in_offset[i + 1]) and writes
+   out[out_offset[i]..out_offset[i + 1]) with its own gas limit, gas used and
+   status in errs. Returns the error of the first failed call */
+EIP2537_ERROR eip2537_run_batch(const uint64_t* address, const byte* in,
+                                const size_t* in_offset, byte* out,
+                                const size_t* out_offset,
+                                const uint64_t* gas_limit, uint64_t* gas_used,
+                                EIP2537_ERROR* errs, size_t n);
+
 #endif /* __EIP2537_H__ */
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "blst.h"
 #include "eip2537.h"
 
@@ -46,6 +47,70 @@ static int bytes_are_equal(const byte* a, const byte* b, size_t num) {
   return (~acc & (acc - 1)) >> ((sizeof(limb_t) * 8)- 1);
 }
 
+/* Encode a field element as 64 bytes, 16 zero bytes then big endian */
+static void fp_to_bytes(byte out[64], const blst_fp* in) {
+  memset(out, 0, 16);
+  blst_bendian_from_fp(out + 16, in);
+}
+
+static void g1_to_bytes(byte out[128], const blst_p1* in) {
+  blst_p1_affine aff;
+  blst_p1_to_affine(&aff, in);
+  fp_to_bytes(out, &(aff.x));
+  fp_to_bytes(out + 64, &(aff.y));
+}
+
+static void g2_to_bytes(byte out[256], const blst_p2* in) {
+  blst_p2_affine aff;
+  blst_p2_to_affine(&aff, in);
+  fp_to_bytes(out, &(aff.x.fp[0]));
+  fp_to_bytes(out + 64, &(aff.x.fp[1]));
+  fp_to_bytes(out + 128, &(aff.y.fp[0]));
+  fp_to_bytes(out + 192, &(aff.y.fp[1]));
+}
+
+/* Batch entry point shared by the ADD, MUL and map batches */
+typedef EIP2537_ERROR (*batch_func)(byte* out, EIP2537_ERROR* errs,
+                                    const byte* const* in,
+                                    const size_t* in_len, size_t n);
+
+/* Previous row, a copy of the current row with an invalid element and the
+   current row as one batch. Only the middle call may fail, leaving zeros,
+   and the others must match their vectors */
+static int check_batch(batch_func f, const byte* prev_in,
+                       const byte* prev_out, const byte* in, const byte* out,
+                       size_t in_len, size_t out_len) {
+  byte          bad_in[512];
+  byte          batch_out[3 * 256];
+  byte          zeros[256] = { 0 };
+  EIP2537_ERROR batch_err[3];
+  EIP2537_ERROR err;
+
+  memcpy(bad_in, in, in_len);
+  bad_in[0] = 1; /* Top bytes of the first field element must be zero */
+
+  const byte* batch_in[3]  = { prev_in, bad_in, in };
+  size_t      batch_len[3] = { in_len, in_len, in_len };
+  err = f(batch_out, batch_err, batch_in, batch_len, 3);
+  if ((err != EIP2537_INVALID_ELEMENT) ||
+      (batch_err[0] != EIP2537_SUCCESS) ||
+      (batch_err[1] != EIP2537_INVALID_ELEMENT) ||
+      (batch_err[2] != EIP2537_SUCCESS)) {
+    printf("ERROR batch %d - %d %d %d\n", err, batch_err[0], batch_err[1],
+           batch_err[2]);
+    return -1;
+  }
+
+  if (!bytes_are_equal(prev_out, batch_out, out_len) ||
+      !bytes_are_equal(zeros, batch_out + out_len, out_len) ||
+      !bytes_are_equal(out, batch_out + (2 * out_len), out_len)) {
+    printf("ERROR not equal\n");
+    return -1;
+  }
+
+  return 0;
+}
+
 /* Test Functions */
 int test_g1_add() {
   FILE* f = fopen("test_vectors/g1_add.csv", "r");
@@ -58,7 +123,10 @@ int test_g1_add() {
   byte in[256];
   byte out[128];
   byte act_out[128];
+  byte prev_in[256];
+  byte prev_out[128];
   EIP2537_ERROR err;
+  int have_prev = 0;
 
   fgets(row, 771, f); /* Skip first row */
   while (fgets(row, 771, f)) {
@@ -81,6 +149,17 @@ int test_g1_add() {
       printf("ERROR not equal\n");
       return -1;
     }
+
+    /* Previous and current rows as one batch with a failing call */
+    if (have_prev &&
+        (check_batch(bls12_g1add_batch, prev_in, prev_out, in, out,
+                     256, 128) != 0)) {
+      return -1;
+    }
+
+    memcpy(prev_in, in, 256);
+    memcpy(prev_out, out, 128);
+    have_prev = 1;
   } 
 
   //printf("Input\n");
@@ -106,7 +185,10 @@ int test_g1_mul() {
   byte in[160];
   byte out[128];
   byte act_out[128];
+  byte prev_in[160];
+  byte prev_out[128];
   EIP2537_ERROR err;
+  int have_prev = 0;
 
   fgets(row, 579, f); /* Skip first row */
   while (fgets(row, 579, f)) {
@@ -129,6 +211,28 @@ int test_g1_mul() {
       printf("ERROR not equal\n");
       return -1;
     }
+
+    err = bls12_g1mul_glv(act_out, in, 160);
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out, 128)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
+    /* Previous and current rows as one batch with a failing call */
+    if (have_prev &&
+        (check_batch(bls12_g1mul_batch, prev_in, prev_out, in, out,
+                     160, 128) != 0)) {
+      return -1;
+    }
+
+    memcpy(prev_in, in, 160);
+    memcpy(prev_out, out, 128);
+    have_prev = 1;
   } 
 
   //printf("Input\n");
@@ -162,6 +266,12 @@ int test_g1_mul() {
       printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
       return -1;
     }
+
+    err = bls12_g1mul_glv(act_out, in, 160);
+    if (err != EIP2537_POINT_NOT_ON_CURVE) {
+      printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
+      return -1;
+    }
   } 
 
   fclose(f);
@@ -182,6 +292,7 @@ int test_g1_multi_exp() {
   byte out[128];
   byte act_out[128];
   byte act_out_bc[128];
+  byte act_out_pippenger[128];
   EIP2537_ERROR err;
 
   ssize_t in_len = 0;
@@ -227,6 +338,44 @@ int test_g1_multi_exp() {
       return -1;
     }
 
+    err = bls12_g1multiexp_pippenger(act_out_pippenger, in, (in_len >> 1));
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out_pippenger, 128)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
+    err = bls12_g1multiexp_straus(act_out, in, (in_len >> 1));
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out, 128)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
+    /* Unaligned caller scratch of exactly the queried size */
+    size_t scratch_len = bls12_g1multiexp_scratch_size(in_len >> 1);
+    byte*  scratch     = malloc(scratch_len + 1);
+    err = bls12_g1multiexp_with_scratch(act_out, in, (in_len >> 1),
+                                        scratch + 1, scratch_len);
+    free(scratch);
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out, 128)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
     free(in);
   }
 
@@ -251,7 +400,10 @@ int test_g2_add() {
   byte in[512];
   byte out[256];
   byte act_out[256];
+  byte prev_in[512];
+  byte prev_out[256];
   EIP2537_ERROR err;
+  int have_prev = 0;
 
   fgets(row, 1539, f); /* Skip first row */
   while (fgets(row, 1539, f)) {
@@ -274,6 +426,17 @@ int test_g2_add() {
       printf("ERROR not equal\n");
       return -1;
     }
+
+    /* Previous and current rows as one batch with a failing call */
+    if (have_prev &&
+        (check_batch(bls12_g2add_batch, prev_in, prev_out, in, out,
+                     512, 256) != 0)) {
+      return -1;
+    }
+
+    memcpy(prev_in, in, 512);
+    memcpy(prev_out, out, 256);
+    have_prev = 1;
   } 
 
   //printf("Input\n");
@@ -299,7 +462,10 @@ int test_g2_mul() {
   byte in[288];
   byte out[256];
   byte act_out[256];
+  byte prev_in[288];
+  byte prev_out[256];
   EIP2537_ERROR err;
+  int have_prev = 0;
 
   fgets(row, 1091, f); /* Skip first row */
   while (fgets(row, 1091, f)) {
@@ -322,6 +488,28 @@ int test_g2_mul() {
       printf("ERROR not equal\n");
       return -1;
     }
+
+    err = bls12_g2mul_gls(act_out, in, 288);
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out, 256)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
+    /* Previous and current rows as one batch with a failing call */
+    if (have_prev &&
+        (check_batch(bls12_g2mul_batch, prev_in, prev_out, in, out,
+                     288, 256) != 0)) {
+      return -1;
+    }
+
+    memcpy(prev_in, in, 288);
+    memcpy(prev_out, out, 256);
+    have_prev = 1;
   } 
 
   //printf("Input\n");
@@ -355,6 +543,12 @@ int test_g2_mul() {
       printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
       return -1;
     }
+
+    err = bls12_g2mul_gls(act_out, in, 288);
+    if (err != EIP2537_POINT_NOT_ON_CURVE) {
+      printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
+      return -1;
+    }
   } 
 
   fclose(f);
@@ -374,6 +568,7 @@ int test_g2_multi_exp() {
   byte* in;
   byte out[256];
   byte act_out[256];
+  byte act_out_pippenger[256];
   EIP2537_ERROR err;
 
   ssize_t in_len = 0;
@@ -408,6 +603,44 @@ int test_g2_multi_exp() {
       return -1;
     }
 
+    err = bls12_g2multiexp_pippenger(act_out_pippenger, in, (in_len >> 1));
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out_pippenger, 256)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
+    err = bls12_g2multiexp_straus(act_out, in, (in_len >> 1));
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out, 256)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
+    /* Unaligned caller scratch of exactly the queried size */
+    size_t scratch_len = bls12_g2multiexp_scratch_size(in_len >> 1);
+    byte*  scratch     = malloc(scratch_len + 1);
+    err = bls12_g2multiexp_with_scratch(act_out, in, (in_len >> 1),
+                                        scratch + 1, scratch_len);
+    free(scratch);
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, act_out, 256)) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+
     free(in);
   }
 
@@ -526,7 +759,10 @@ int test_map_fp_to_g1() {
   byte in[64];
   byte out[128];
   byte act_out[128];
+  byte prev_in[64];
+  byte prev_out[128];
   EIP2537_ERROR err;
+  int have_prev = 0;
 
   fgets(row, 387, f); /* Skip first row */
   while (fgets(row, 387, f)) {
@@ -549,6 +785,17 @@ int test_map_fp_to_g1() {
       printf("ERROR not equal\n");
       return -1;
     }
+
+    /* Previous and current rows as one batch with a failing call */
+    if (have_prev &&
+        (check_batch(bls12_map_fp_to_g1_batch, prev_in, prev_out, in, out,
+                     64, 128) != 0)) {
+      return -1;
+    }
+
+    memcpy(prev_in, in, 64);
+    memcpy(prev_out, out, 128);
+    have_prev = 1;
   } 
 
   //printf("Input\n");
@@ -600,7 +847,10 @@ int test_map_fp2_to_g2() {
   byte in[128];
   byte out[256];
   byte act_out[256];
+  byte prev_in[128];
+  byte prev_out[256];
   EIP2537_ERROR err;
+  int have_prev = 0;
 
   fgets(row, 771, f); /* Skip first row */
   while (fgets(row, 771, f)) {
@@ -623,6 +873,17 @@ int test_map_fp2_to_g2() {
       printf("ERROR not equal\n");
       return -1;
     }
+
+    /* Previous and current rows as one batch with a failing call */
+    if (have_prev &&
+        (check_batch(bls12_map_fp2_to_g2_batch, prev_in, prev_out, in, out,
+                     128, 256) != 0)) {
+      return -1;
+    }
+
+    memcpy(prev_in, in, 128);
+    memcpy(prev_out, out, 256);
+    have_prev = 1;
   } 
 
   //printf("Input\n");
@@ -663,6 +924,550 @@ int test_map_fp2_to_g2() {
   return 0;
 }
 
+int test_gas_budget() {
+  /* 4096 G2 pairs of zeros, out of gas must return before decoding */
+  size_t in_len = 4096 * 288;
+  byte*  in     = (byte*) calloc(in_len, 1);
+  byte   out[256];
+  uint64_t gas_used;
+  EIP2537_ERROR err;
+
+  if (in == NULL) {
+    printf("ERROR allocating input\n");
+    return -1;
+  }
+
+  uint64_t cost = bls12_g2multiexp_gas(in_len);
+  err = bls12_g2multiexp_with_gas(out, in, in_len, cost - 1, &gas_used);
+  if ((err != EIP2537_OUT_OF_GAS) || (gas_used != (cost - 1))) {
+    printf("ERROR - should be EIP2537_OUT_OF_GAS - %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  err = bls12_g2multiexp_with_gas(out, in, in_len - 1, cost, &gas_used);
+  if ((err != EIP2537_INVALID_LENGTH) || (gas_used != 0)) {
+    printf("ERROR - should be EIP2537_INVALID_LENGTH - %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  /* Exact budget runs the call, points at infinity sum to infinity */
+  cost = bls12_g1multiexp_gas(2 * 160);
+  err = bls12_g1multiexp_with_gas(out, in, 2 * 160, cost, &gas_used);
+  if ((err != EIP2537_SUCCESS) || (gas_used != cost) ||
+      !bytes_are_equal(out, in, 128)) {
+    printf("ERROR %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  cost = bls12_pairing_gas(384);
+  err = bls12_pairing_with_gas(out, in, 384, cost, &gas_used);
+  if ((err != EIP2537_SUCCESS) || (gas_used != cost) || (out[31] != 1)) {
+    printf("ERROR %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  /* Same calls through the dispatcher */
+  cost = bls12_pairing_gas(384);
+  err  = eip2537_run(BLS12_PAIRING_ADDRESS, in, 384, out, 32, cost,
+                     &gas_used);
+  if ((err != EIP2537_SUCCESS) || (gas_used != cost) || (out[31] != 1)) {
+    printf("ERROR %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  err = eip2537_run(BLS12_G2MULTIEXP_ADDRESS, in, 4096 * 288, out, 256, 0,
+                    &gas_used);
+  if ((err != EIP2537_OUT_OF_GAS) || (gas_used != 0)) {
+    printf("ERROR - should be EIP2537_OUT_OF_GAS - %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  err = eip2537_run(BLS12_G2ADD_ADDRESS, in, 512, out, 128, 4500, &gas_used);
+  if (err != EIP2537_INVALID_LENGTH) {
+    printf("ERROR - should be EIP2537_INVALID_LENGTH - %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  err = eip2537_run(0x13, in, 64, out, 256, 4500, &gas_used);
+  if (err != EIP2537_UNKNOWN_ADDRESS) {
+    printf("ERROR - should be EIP2537_UNKNOWN_ADDRESS - %d\n", err);
+    free(in);
+    return -1;
+  }
+
+  free(in);
+
+  return 0;
+}
+
+/* Multiple k of a generator, encoded */
+static void g1_generator_mul(byte out[128], uint64_t k) {
+  blst_scalar s;
+  blst_p1     p;
+  uint64_t    limbs[4] = { k, 0, 0, 0 };
+  blst_scalar_from_uint64(&s, limbs);
+  blst_p1_mult(&p, blst_p1_generator(), s.b, 64);
+  g1_to_bytes(out, &p);
+}
+
+static void g2_generator_mul(byte out[256], uint64_t k) {
+  blst_scalar s;
+  blst_p2     p;
+  uint64_t    limbs[4] = { k, 0, 0, 0 };
+  blst_scalar_from_uint64(&s, limbs);
+  blst_p2_mult(&p, blst_p2_generator(), s.b, 64);
+  g2_to_bytes(out, &p);
+}
+
+/* Scalar i of the fixed base checks, edge values then a fixed pattern */
+static void fixed_base_scalar(byte out[32], size_t i) {
+  memset(out, (i == 1) ? 0xff : 0, 32);
+  if (i == 2) {
+    out[31] = 1;
+  }
+  for (size_t j = 0; (i > 2) && (j < 32); ++j) {
+    out[j] = (byte)((i * 0x9d) ^ (j * 0x3b));
+  }
+}
+
+int test_fixed_base() {
+  byte        in[288];
+  byte        out[256];
+  byte        exp_out[256];
+  byte        base[256];
+  blst_scalar s;
+  blst_fp     b, rhs;
+  EIP2537_ERROR err;
+
+  /* G1 base other than the generator must match a plain multiplication */
+  g1_generator_mul(base, 7);
+  err = bls12_g1_add_fixed_base(base);
+  if (err != EIP2537_SUCCESS) {
+    printf("ERROR %d\n", err);
+    return -1;
+  }
+
+  /* Variable time table walk, then the constant time one */
+  for (size_t i = 0; i < 32; ++i) {
+    blst_p1_affine base_aff;
+    blst_p1        exp;
+
+    bls12_mul_set_vartime(i < 16);
+    memcpy(in, base, 128);
+    fixed_base_scalar(in + 128, i % 16);
+
+    blst_fp_from_bendian(&(base_aff.x), base + 16);
+    blst_fp_from_bendian(&(base_aff.y), base + 80);
+    blst_scalar_from_bendian(&s, in + 128);
+    blst_p1_from_affine(&exp, &base_aff);
+    blst_p1_mult(&exp, &exp, s.b, 256);
+    g1_to_bytes(exp_out, &exp);
+
+    err = bls12_g1mul(out, in, 160);
+    if ((err != EIP2537_SUCCESS) || !bytes_are_equal(out, exp_out, 128)) {
+      printf("ERROR fixed base g1mul %zu - %d\n", i, err);
+      return -1;
+    }
+  }
+#ifndef __EIP2537_CT_MUL__
+  bls12_mul_set_vartime(1);
+#endif
+
+  /* Invalid and non subgroup bases are rejected */
+  memcpy(in, base, 128);
+  in[127] ^= 1;
+  err = bls12_g1_add_fixed_base(in);
+  if (err != EIP2537_POINT_NOT_ON_CURVE) {
+    printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
+    return -1;
+  }
+
+  memcpy(in, base, 128);
+  in[0] = 1;
+  err = bls12_g1_add_fixed_base(in);
+  if (err != EIP2537_INVALID_ELEMENT) {
+    printf("ERROR - should be EIP2537_INVALID_ELEMENT - %d\n", err);
+    return -1;
+  }
+
+  /* y^2 = x^3 + 4 for the first x with a root, G1 has cofactor > 1 */
+  uint64_t four[6] = { 4, 0, 0, 0, 0, 0 };
+  blst_fp_from_uint64(&b, four);
+  for (uint64_t c = 1; ; ++c) {
+    blst_p1_affine p;
+    uint64_t       x[6] = { c, 0, 0, 0, 0, 0 };
+    blst_fp_from_uint64(&(p.x), x);
+    blst_fp_sqr(&rhs, &(p.x));
+    blst_fp_mul(&rhs, &rhs, &(p.x));
+    blst_fp_add(&rhs, &rhs, &b);
+    if (blst_fp_sqrt(&(p.y), &rhs) && !blst_p1_affine_in_g1(&p)) {
+      fp_to_bytes(in, &(p.x));
+      fp_to_bytes(in + 64, &(p.y));
+      break;
+    }
+  }
+  err = bls12_g1_add_fixed_base(in);
+  if (err != EIP2537_POINT_NOT_IN_SUBGROUP) {
+    printf("ERROR - should be EIP2537_POINT_NOT_IN_SUBGROUP - %d\n", err);
+    return -1;
+  }
+
+  /* Registering again takes no slot, new bases stop at the limit */
+  size_t num_added = 0;
+  for (uint64_t k = 7; k < 32; ++k) {
+    g1_generator_mul(in, k);
+    err = bls12_g1_add_fixed_base(in);
+    if (err == EIP2537_FIXED_BASE_LIMIT) {
+      break;
+    }
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+    num_added++;
+  }
+  if ((err != EIP2537_FIXED_BASE_LIMIT) || (num_added != 7)) {
+    printf("ERROR - should be EIP2537_FIXED_BASE_LIMIT - %d\n", err);
+    return -1;
+  }
+
+  /* Same for G2 */
+  g2_generator_mul(base, 7);
+  err = bls12_g2_add_fixed_base(base);
+  if (err != EIP2537_SUCCESS) {
+    printf("ERROR %d\n", err);
+    return -1;
+  }
+
+  /* Variable time table walk, then the constant time one */
+  for (size_t i = 0; i < 32; ++i) {
+    blst_p2_affine base_aff;
+    blst_p2        exp;
+
+    bls12_mul_set_vartime(i < 16);
+    memcpy(in, base, 256);
+    fixed_base_scalar(in + 256, i % 16);
+
+    blst_fp_from_bendian(&(base_aff.x.fp[0]), base + 16);
+    blst_fp_from_bendian(&(base_aff.x.fp[1]), base + 80);
+    blst_fp_from_bendian(&(base_aff.y.fp[0]), base + 144);
+    blst_fp_from_bendian(&(base_aff.y.fp[1]), base + 208);
+    blst_scalar_from_bendian(&s, in + 256);
+    blst_p2_from_affine(&exp, &base_aff);
+    blst_p2_mult(&exp, &exp, s.b, 256);
+    g2_to_bytes(exp_out, &exp);
+
+    err = bls12_g2mul(out, in, 288);
+    if ((err != EIP2537_SUCCESS) || !bytes_are_equal(out, exp_out, 256)) {
+      printf("ERROR fixed base g2mul %zu - %d\n", i, err);
+      return -1;
+    }
+  }
+#ifndef __EIP2537_CT_MUL__
+  bls12_mul_set_vartime(1);
+#endif
+
+  memcpy(in, base, 256);
+  in[255] ^= 1;
+  err = bls12_g2_add_fixed_base(in);
+  if (err != EIP2537_POINT_NOT_ON_CURVE) {
+    printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
+    return -1;
+  }
+
+  memcpy(in, base, 256);
+  in[64] = 1;
+  err = bls12_g2_add_fixed_base(in);
+  if (err != EIP2537_INVALID_ELEMENT) {
+    printf("ERROR - should be EIP2537_INVALID_ELEMENT - %d\n", err);
+    return -1;
+  }
+
+  /* y^2 = x^3 + 4(1 + i) for x = (c, 1), G2 has cofactor > 1 */
+  blst_fp2 b2, rhs2;
+  uint64_t one[6] = { 1, 0, 0, 0, 0, 0 };
+  b2.fp[0] = b;
+  b2.fp[1] = b;
+  for (uint64_t c = 1; ; ++c) {
+    blst_p2_affine p;
+    uint64_t       x[6] = { c, 0, 0, 0, 0, 0 };
+    blst_fp_from_uint64(&(p.x.fp[0]), x);
+    blst_fp_from_uint64(&(p.x.fp[1]), one);
+    blst_fp2_sqr(&rhs2, &(p.x));
+    blst_fp2_mul(&rhs2, &rhs2, &(p.x));
+    blst_fp2_add(&rhs2, &rhs2, &b2);
+    if (blst_fp2_sqrt(&(p.y), &rhs2) && !blst_p2_affine_in_g2(&p)) {
+      fp_to_bytes(in, &(p.x.fp[0]));
+      fp_to_bytes(in + 64, &(p.x.fp[1]));
+      fp_to_bytes(in + 128, &(p.y.fp[0]));
+      fp_to_bytes(in + 192, &(p.y.fp[1]));
+      break;
+    }
+  }
+  err = bls12_g2_add_fixed_base(in);
+  if (err != EIP2537_POINT_NOT_IN_SUBGROUP) {
+    printf("ERROR - should be EIP2537_POINT_NOT_IN_SUBGROUP - %d\n", err);
+    return -1;
+  }
+
+  num_added = 0;
+  for (uint64_t k = 7; k < 32; ++k) {
+    g2_generator_mul(in, k);
+    err = bls12_g2_add_fixed_base(in);
+    if (err == EIP2537_FIXED_BASE_LIMIT) {
+      break;
+    }
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+    num_added++;
+  }
+  if ((err != EIP2537_FIXED_BASE_LIMIT) || (num_added != 7)) {
+    printf("ERROR - should be EIP2537_FIXED_BASE_LIMIT - %d\n", err);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Earliest failing pair decides the error, whichever range fails first */
+int test_pairing_first_error() {
+  byte          in[8 * 384];
+  byte          out[32];
+  EIP2537_ERROR err;
+
+  for (size_t i = 0; i < 8; ++i) {
+    g1_generator_mul(in + (i * 384), i + 1);
+    g2_generator_mul(in + (i * 384) + 128, i + 1);
+  }
+
+  err = bls12_pairing(out, in, sizeof(in));
+  if (err != EIP2537_SUCCESS) {
+    printf("ERROR %d\n", err);
+    return -1;
+  }
+
+  /* G2 of pair 2 off the curve, G1 of pair 6 not a field element */
+  in[(2 * 384) + 128 + 255] ^= 1;
+  in[6 * 384] = 1;
+  err = bls12_pairing(out, in, sizeof(in));
+  if (err != EIP2537_POINT_NOT_ON_CURVE) {
+    printf("ERROR - should be EIP2537_POINT_NOT_ON_CURVE - %d\n", err);
+    return -1;
+  }
+
+  /* Swapped, pair 2 not a field element and pair 6 off the curve */
+  in[(2 * 384) + 128 + 255] ^= 1;
+  in[6 * 384] = 0;
+  in[2 * 384] = 1;
+  in[(6 * 384) + 128 + 255] ^= 1;
+  err = bls12_pairing(out, in, sizeof(in));
+  if (err != EIP2537_INVALID_ELEMENT) {
+    printf("ERROR - should be EIP2537_INVALID_ELEMENT - %d\n", err);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Infinity pairs and pairs sharing a G2 point are removed before the Miller
+   loop without changing the result */
+int test_pairing_normalize() {
+  byte          in[4 * 384];
+  byte          ref_in[2 * 384];
+  byte          out[32];
+  byte          ref_out[32];
+  blst_p1       neg_g1;
+  EIP2537_ERROR err;
+
+  blst_p1_from_affine(&neg_g1, blst_p1_affine_generator());
+  blst_p1_cneg(&neg_g1, 1);
+
+  /* e(2G, H) e(3G, H) e(0, 0) e(-G, cH) against e(5G, H) e(-G, cH), one
+     for c = 5 only */
+  for (uint64_t c = 4; c <= 5; ++c) {
+    memset(in, 0, sizeof(in));
+    g1_generator_mul(in, 2);
+    g2_generator_mul(in + 128, 1);
+    g1_generator_mul(in + 384, 3);
+    g2_generator_mul(in + 384 + 128, 1);
+    g1_to_bytes(in + (3 * 384), &neg_g1);
+    g2_generator_mul(in + (3 * 384) + 128, c);
+
+    g1_generator_mul(ref_in, 5);
+    g2_generator_mul(ref_in + 128, 1);
+    memcpy(ref_in + 384, in + (3 * 384), 384);
+
+    err = bls12_pairing(ref_out, ref_in, sizeof(ref_in));
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    uint64_t eliminated = bls12_pairing_eliminated_pairs();
+    err = bls12_pairing(out, in, sizeof(in));
+    if (err != EIP2537_SUCCESS) {
+      printf("ERROR %d\n", err);
+      return -1;
+    }
+
+    if ((bls12_pairing_eliminated_pairs() - eliminated) != 2) {
+      printf("ERROR should eliminate 2 pairs\n");
+      return -1;
+    }
+
+    if (!bytes_are_equal(out, ref_out, 32) || (out[31] != (c == 5))) {
+      printf("ERROR not equal\n");
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* Straus over points the cache knows to be in the subgroup (verdicts from
+   MUL) takes the GLV/GLS split and must match the naive sum */
+int test_straus_endo() {
+  byte          g1_in[8 * 160];
+  byte          g2_in[8 * 288];
+  byte          out[256];
+  byte          exp_out[256];
+  EIP2537_ERROR err;
+  int           ret = 0;
+
+  for (size_t i = 0; i < 8; ++i) {
+    g1_generator_mul(g1_in + (i * 160), i + 2);
+    fixed_base_scalar(g1_in + (i * 160) + 128, i);
+    g2_generator_mul(g2_in + (i * 288), i + 2);
+    fixed_base_scalar(g2_in + (i * 288) + 256, i);
+  }
+
+  bls12_g1multiexp_naive(exp_out, g1_in, sizeof(g1_in));
+  bls12_point_cache_configure(64, 64);
+  for (size_t i = 0; i < 8; ++i) {
+    bls12_g1mul_glv(out, g1_in + (i * 160), 160);
+    bls12_g2mul_gls(out, g2_in + (i * 288), 288);
+  }
+
+  err = bls12_g1multiexp_straus(out, g1_in, sizeof(g1_in));
+  if ((err != EIP2537_SUCCESS) || !bytes_are_equal(out, exp_out, 128)) {
+    printf("ERROR G1 Straus over subgroup points - %d\n", err);
+    ret = -1;
+  }
+
+  bls12_g2multiexp_naive(exp_out, g2_in, sizeof(g2_in));
+  err = bls12_g2multiexp_straus(out, g2_in, sizeof(g2_in));
+  if ((err != EIP2537_SUCCESS) || !bytes_are_equal(out, exp_out, 256)) {
+    printf("ERROR G2 Straus over subgroup points - %d\n", err);
+    ret = -1;
+  }
+
+  bls12_point_cache_configure(0, 0);
+
+  return ret;
+}
+
+/* Invalid selection tables are rejected and leave the live table alone */
+int test_msm_selection() {
+  bls12_msm_selection unsorted[2] = { { 64, BLS12_MSM_STRAUS },
+                                      { 32, BLS12_MSM_PIPPENGER } };
+  bls12_msm_selection unknown[1]  = { { 64, (bls12_msm_engine)7 } };
+  bls12_msm_selection before[16];
+  bls12_msm_selection after[16];
+  EIP2537_ERROR       err;
+
+  size_t num_entries = bls12_g1multiexp_get_selection(before, 16);
+
+  err = bls12_g1multiexp_set_selection(unsorted, 2);
+  if (err != EIP2537_INVALID_SELECTION) {
+    printf("ERROR - should be EIP2537_INVALID_SELECTION - %d\n", err);
+    return -1;
+  }
+
+  err = bls12_g2multiexp_set_selection(unknown, 1);
+  if (err != EIP2537_INVALID_SELECTION) {
+    printf("ERROR - should be EIP2537_INVALID_SELECTION - %d\n", err);
+    return -1;
+  }
+
+  if ((bls12_g1multiexp_get_selection(after, 16) != num_entries) ||
+      (memcmp(before, after, num_entries * sizeof(*after)) != 0)) {
+    printf("ERROR selection table changed by an invalid set\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Scratch sized under one thread must still serve a run under four, for the
+   dispatcher and Pippenger on both groups */
+int test_scratch_threads() {
+  byte          g1_in[16 * 160];
+  byte          g2_in[16 * 288];
+  byte          out[256];
+  byte          exp_out[256];
+  EIP2537_ERROR err;
+
+  for (size_t i = 0; i < 16; ++i) {
+    g1_generator_mul(g1_in + (i * 160), i + 1);
+    fixed_base_scalar(g1_in + (i * 160) + 128, i + 3);
+    g2_generator_mul(g2_in + (i * 288), i + 1);
+    fixed_base_scalar(g2_in + (i * 288) + 256, i + 3);
+  }
+
+  bls12_set_num_threads(1);
+  size_t g1_len = bls12_g1multiexp_scratch_size(sizeof(g1_in));
+  size_t g2_len = bls12_g2multiexp_scratch_size(sizeof(g2_in));
+  if ((g1_len < bls12_g1multiexp_pippenger_scratch_size(sizeof(g1_in))) ||
+      (g2_len < bls12_g2multiexp_pippenger_scratch_size(sizeof(g2_in)))) {
+    printf("ERROR dispatcher scratch smaller than Pippenger\n");
+    bls12_set_num_threads(4);
+    return -1;
+  }
+  bls12_set_num_threads(4);
+
+  byte* g1_scratch = malloc(g1_len);
+  byte* g2_scratch = malloc(g2_len);
+  int   ret        = 0;
+
+  for (int pippenger = 0; (ret == 0) && (pippenger <= 1); ++pippenger) {
+    bls12_g1multiexp_naive(exp_out, g1_in, sizeof(g1_in));
+    err = pippenger
+        ? bls12_g1multiexp_pippenger_with_scratch(out, g1_in, sizeof(g1_in),
+                                                  g1_scratch, g1_len)
+        : bls12_g1multiexp_with_scratch(out, g1_in, sizeof(g1_in),
+                                        g1_scratch, g1_len);
+    if ((err != EIP2537_SUCCESS) || !bytes_are_equal(out, exp_out, 128)) {
+      printf("ERROR G1 scratch sized under one thread - %d\n", err);
+      ret = -1;
+    }
+
+    bls12_g2multiexp_naive(exp_out, g2_in, sizeof(g2_in));
+    err = pippenger
+        ? bls12_g2multiexp_pippenger_with_scratch(out, g2_in, sizeof(g2_in),
+                                                  g2_scratch, g2_len)
+        : bls12_g2multiexp_with_scratch(out, g2_in, sizeof(g2_in),
+                                        g2_scratch, g2_len);
+    if ((err != EIP2537_SUCCESS) || !bytes_are_equal(out, exp_out, 256)) {
+      printf("ERROR G2 scratch sized under one thread - %d\n", err);
+      ret = -1;
+    }
+  }
+
+  free(g1_scratch);
+  free(g2_scratch);
+
+  return ret;
+}
+
 int main() {
   //blst_fp x;
   //printf("size of x %ld\n", sizeof(x));
@@ -683,6 +1488,56 @@ int main() {
   ret |= test_pairing();
   ret |= test_map_fp_to_g1();
   ret |= test_map_fp2_to_g2();
+  ret |= test_gas_budget();
+  ret |= test_fixed_base();
+  ret |= test_pairing_first_error();
+  ret |= test_pairing_normalize();
+  ret |= test_msm_selection();
+  ret |= test_straus_endo();
+
+  /* Pairing again through a cold then warm validated point cache */
+  bls12_point_cache_configure(1024, 1024);
+  ret |= test_pairing();
+  ret |= test_pairing();
+  bls12_point_cache_configure(0, 0);
+
+  /* Pairing with G2 lines admitted, then computed, then served from cache */
+  bls12_pairing_line_cache_configure(64);
+  ret |= test_pairing();
+  ret |= test_pairing();
+  ret |= test_pairing();
+  bls12_pairing_line_cache_configure(0);
+
+  /* Multiexp again through selection tables calibrated on this host */
+  if (bls12_multiexp_calibrate(16) != EIP2537_SUCCESS) {
+    printf("ERROR calibrating multiexp\n");
+    ret |= -1;
+  }
+  ret |= test_g1_multi_exp();
+  ret |= test_g2_multi_exp();
+  bls12_g1multiexp_set_selection(NULL, 0);
+  bls12_g2multiexp_set_selection(NULL, 0);
+
+  /* MUL through the constant time path switched at runtime */
+  bls12_mul_set_vartime(0);
+  ret |= test_g1_mul();
+  ret |= test_g2_mul();
+#ifndef __EIP2537_CT_MUL__
+  bls12_mul_set_vartime(1);
+#endif
+
+  /* Threaded decode, Miller loop and Pippenger paths on every input size */
+  bls12_set_num_threads(4);
+  bls12_pairing_set_parallel_threshold(1);
+  bls12_multiexp_set_parallel_threshold(1);
+  ret |= test_pairing();
+  ret |= test_pairing_first_error();
+  ret |= test_g1_multi_exp();
+  ret |= test_g2_multi_exp();
+  ret |= test_scratch_threads();
+  bls12_set_num_threads(0);
+  bls12_pairing_set_parallel_threshold(8);
+  bls12_multiexp_set_parallel_threshold(32);
 
   if (ret == 0) {
     printf("\nPASSED\n\n");